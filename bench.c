@@ -0,0 +1,324 @@
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ipc.h>
+#include <sys/mman.h>
+#include <sys/msg.h>
+#include <sys/wait.h>
+#include "common.h"
+#include "latency.h"
+#include "transport.h"
+
+#define BENCH_SEED 4760                 // Base seed for every scenario run
+#define DEFAULT_ROUND_TRIPS 100000      // Round trips per transport benchmark
+#define CLOCK_READS 10000000            // Iterations of the clock-read benchmark
+#define PROCESS_STARTS 200              // Process starts per launch benchmark
+
+extern char **environ;
+
+// One end-to-end oss run of the scenario sweep
+typedef struct {
+    int n;                  // -n
+    int s;                  // -s
+    int i;                  // -i
+    const char *extra;      // Further oss options
+} Scenario;
+
+static const Scenario scenarios[] = {
+    { 20, 2, 0, "-T msg" },
+    { 20, 8, 0, "-T msg" },
+    { 100, 18, 0, "-T msg" },
+    { 100, 18, 100, "-T msg" },
+    { 100, 18, 0, "-T msg -q 1000" },
+    { 20, 2, 0, "-T shm" },
+    { 20, 8, 0, "-T shm" },
+    { 100, 18, 0, "-T shm" },
+    { 100, 18, 100, "-T shm" },
+    { 100, 18, 0, "-T shm -q 1000" },
+    { 100, 18, 0, "-T shm -d pipelined" },
+    { 200, 18, 0, "-L pool -T shm" },
+    { 200, 18, 0, "-L spawn -T shm" },
+    { 200, 18, 0, "-L thread" },
+};
+
+/**
+ * Cost of reading and of advancing the simulated clock
+ */
+static void benchClock(FILE *out) {
+    SystemClock clock;
+    volatile uint64_t sink = 0;
+
+    clockSet(&clock, 0);
+
+    uint64_t start = monotonicNs();
+    for (int i = 0; i < CLOCK_READS; i++) {
+        sink += clockRead(&clock);
+    }
+    uint64_t readNs = monotonicNs() - start;
+
+    start = monotonicNs();
+    for (int i = 0; i < CLOCK_READS; i++) {
+        clockAdvance(&clock, 1);
+    }
+    uint64_t advanceNs = monotonicNs() - start;
+    (void)sink;
+
+    fprintf(out, "  \"clock\": {\"readNs\": %.2f, \"advanceNs\": %.2f},\n",
+            (double)readNs / CLOCK_READS, (double)advanceNs / CLOCK_READS);
+}
+
+/**
+ * Remove the mailboxes or queue a round-trip benchmark set up
+ */
+static void releaseRoundTrip(Transport *t) {
+    if (t->kind == TRANSPORT_SHM) {
+        munmap(t->mailboxes, MAILBOX_SEGMENT_SIZE(1));
+    } else {
+        msgctl(t->msgqid, IPC_RMID, NULL);
+    }
+}
+
+/**
+ * Write a null entry for a transport whose round trips could not be run,
+ * keeping the document valid
+ * @return -1
+ */
+static int roundTripFailed(FILE *out, TransportKind kind, int last) {
+    fprintf(out, "    \"%s\": null%s\n", transportName(kind), last ? "" : ",");
+    return -1;
+}
+
+/**
+ * Round trips between this process and a forked echo process over a
+ * transport, measured the way oss sends a quantum and waits for its reply
+ * @return 0 on success, -1 on failure
+ */
+static int benchRoundTrip(FILE *out, TransportKind kind, int roundTrips, int last) {
+    Transport t = { kind, -1, NULL };
+    pid_t self = getpid();
+
+    if (kind == TRANSPORT_SHM) {
+        t.mailboxes = mmap(NULL, MAILBOX_SEGMENT_SIZE(1), PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (t.mailboxes == MAP_FAILED) {
+            perror("mmap");
+            return roundTripFailed(out, kind, last);
+        }
+    } else {
+        t.msgqid = msgget(IPC_PRIVATE, IPC_CREAT | 0600);
+        if (t.msgqid == -1) {
+            perror("msgget");
+            return roundTripFailed(out, kind, last);
+        }
+    }
+
+    pid_t echo = fork();
+    if (echo == -1) {
+        perror("fork");
+        releaseRoundTrip(&t);
+        return roundTripFailed(out, kind, last);
+    }
+    if (echo == 0) {
+        // Echo every quantum back, like a worker that never terminates
+        Message msg;
+        pid_t me = getpid();
+        while (transportRecvFromOss(&t, 0, me, &msg) == 0 && msg.status != 0) {
+            transportSendToOss(&t, 0, msg.shard, self, me, 1);
+        }
+        _exit(EXIT_SUCCESS);
+    }
+
+    LatencyHistogram h;
+    latencyReset(&h);
+
+    Message reply;
+    int warmup = roundTrips / 10;
+    uint64_t start = 0;
+    for (int i = 0; i < warmup + roundTrips; i++) {
+        if (i == warmup) {
+            start = monotonicNs();
+        }
+        uint64_t sent = monotonicNs();
+        transportSendToWorker(&t, 0, echo, 1);
+        if (transportRecvFromWorker(&t, 0, self, &reply) == -1) {
+            perror("receive");
+            break;
+        }
+        if (i >= warmup) {
+            latencyRecord(&h, monotonicNs() - sent);
+        }
+    }
+    uint64_t elapsed = monotonicNs() - start;
+
+    transportSendToWorker(&t, 0, echo, 0);
+    waitpid(echo, NULL, 0);
+    releaseRoundTrip(&t);
+
+    fprintf(out, "    \"%s\": {\"messagesPerSec\": %.1f, \"latency\": ", transportName(kind),
+            elapsed > 0 ? h.count * 1e9 / elapsed : 0.0);
+    latencyWriteJson(out, &h);
+    fprintf(out, "}%s\n", last ? "" : ",");
+    return 0;
+}
+
+/**
+ * Time from starting a process to collecting its exit, with fork + exec
+ * or posix_spawn of a trivial program
+ */
+static void benchProcessStart(FILE *out, int useSpawn, int last) {
+    char *argv[] = { "true", NULL };
+    LatencyHistogram h;
+    latencyReset(&h);
+
+    for (int i = 0; i < PROCESS_STARTS; i++) {
+        uint64_t start = monotonicNs();
+        pid_t pid;
+
+        if (useSpawn) {
+            if (posix_spawnp(&pid, "true", NULL, NULL, argv, environ) != 0) {
+                perror("posix_spawnp");
+                break;
+            }
+        } else {
+            pid = fork();
+            if (pid == 0) {
+                execvp("true", argv);
+                _exit(EXIT_FAILURE);
+            }
+            if (pid == -1) {
+                perror("fork");
+                break;
+            }
+        }
+        waitpid(pid, NULL, 0);
+        latencyRecord(&h, monotonicNs() - start);
+    }
+
+    fprintf(out, "    \"%s\": ", useSpawn ? "spawn" : "forkExec");
+    latencyWriteJson(out, &h);
+    fprintf(out, "%s\n", last ? "" : ",");
+}
+
+/**
+ * Copy a file's contents into the output, indented one level
+ * @return 0 on success, -1 if the file could not be read
+ */
+static int embedFile(FILE *out, const char *path) {
+    FILE *in = fopen(path, "r");
+    if (in == NULL) {
+        return -1;
+    }
+
+    char line[1024];
+    int first = 1;
+    while (fgets(line, sizeof(line), in) != NULL) {
+        line[strcspn(line, "\n")] = '\0';
+        fprintf(out, first ? "%s" : "\n    %s", line);
+        first = 0;
+    }
+    fclose(in);
+    return 0;
+}
+
+/**
+ * Run every scenario through ./oss with a fixed seed and embed its -j output
+ */
+static void benchScenarios(FILE *out) {
+    int count = sizeof(scenarios) / sizeof(scenarios[0]);
+    char jsonPath[] = "/tmp/ossbench.XXXXXX";
+    int fd = mkstemp(jsonPath);
+    if (fd != -1) {
+        close(fd);
+    }
+
+    fprintf(out, "  \"scenarios\": [\n");
+    for (int k = 0; k < count; k++) {
+        const Scenario *sc = &scenarios[k];
+        char command[512];
+        snprintf(command, sizeof(command),
+                 "./oss -n %d -s %d -i %d -t 2 -v 0 %s -S %d -f /dev/null -j %s > /dev/null",
+                 sc->n, sc->s, sc->i, sc->extra, BENCH_SEED + k, jsonPath);
+
+        fprintf(stderr, "ossbench: %s\n", command);
+        int rc = system(command);
+
+        fprintf(out, "    {\"args\": \"-n %d -s %d -i %d -t 2 %s -S %d\", \"exitStatus\": %d, \"stats\": ",
+                sc->n, sc->s, sc->i, sc->extra, BENCH_SEED + k, WIFEXITED(rc) ? WEXITSTATUS(rc) : -1);
+        if (rc != 0 || embedFile(out, jsonPath) == -1) {
+            fprintf(out, "null");
+        }
+        fprintf(out, "}%s\n", k + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ]\n");
+    unlink(jsonPath);
+}
+
+/**
+ * Run the microbenchmarks and scenario sweep, writing one JSON document
+ */
+int main(int argc, char *argv[]) {
+    int opt;
+    int roundTrips = DEFAULT_ROUND_TRIPS;
+    int runScenarios = 1;
+    FILE *out = stdout;
+
+    while ((opt = getopt(argc, argv, "ho:r:x")) != -1) {
+        switch (opt) {
+            case 'h':
+                printf("Usage: %s [-h] [-o file] [-r roundTrips] [-x]\n", argv[0]);
+                printf("  -o file       : Write the JSON results to file (default: stdout)\n");
+                printf("  -r roundTrips : Round trips per transport benchmark (default: %d)\n", DEFAULT_ROUND_TRIPS);
+                printf("  -x            : Skip the end-to-end oss scenario sweep\n");
+                exit(EXIT_SUCCESS);
+            case 'o':
+                out = fopen(optarg, "w");
+                if (out == NULL) {
+                    perror("Error opening output file");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'r':
+                roundTrips = atoi(optarg);
+                if (roundTrips <= 0) {
+                    fprintf(stderr, "Invalid number of round trips. Using default: %d\n", DEFAULT_ROUND_TRIPS);
+                    roundTrips = DEFAULT_ROUND_TRIPS;
+                }
+                break;
+            case 'x':
+                runScenarios = 0;
+                break;
+            default:
+                fprintf(stderr, "Invalid option. Use -h for help.\n");
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"seed\": %d,\n", BENCH_SEED);
+    benchClock(out);
+
+    fprintf(out, "  \"roundTrip\": {\n");
+    benchRoundTrip(out, TRANSPORT_MSG, roundTrips, 0);
+    benchRoundTrip(out, TRANSPORT_SHM, roundTrips, 1);
+    fprintf(out, "  },\n");
+
+    fprintf(out, "  \"processStart\": {\n");
+    benchProcessStart(out, 0, 0);
+    benchProcessStart(out, 1, 1);
+    fprintf(out, "  }%s\n", runScenarios ? "," : "");
+
+    if (runScenarios) {
+        benchScenarios(out);
+    }
+    fprintf(out, "}\n");
+
+    if (out != stdout) {
+        fclose(out);
+    }
+    return EXIT_SUCCESS;
+}
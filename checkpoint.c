@@ -0,0 +1,118 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "checkpoint.h"
+
+/**
+ * Write all of a buffer, retrying short writes
+ * @return 0 on success, -1 on failure
+ */
+static int writeAll(int fd, const void *data, size_t size) {
+    const char *p = data;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        size -= n;
+    }
+    return 0;
+}
+
+/**
+ * Write a checkpoint. It goes to path.tmp first and is renamed over path,
+ * so path always holds a complete checkpoint even if oss dies mid-write.
+ * @param header Header; magic, version and entry size are filled in here
+ * @param entries header->count running workers
+ * @return 0 on success, -1 with errno set
+ */
+int checkpointWrite(const char *path, const CheckpointHeader *header, const CheckpointEntry *entries) {
+    char tmpPath[512];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+
+    CheckpointHeader h = *header;
+    memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic));
+    h.version = CHECKPOINT_VERSION;
+    h.entrySize = sizeof(CheckpointEntry);
+
+    int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        return -1;
+    }
+    if (writeAll(fd, &h, sizeof(h)) == -1 || writeAll(fd, entries, h.count * sizeof(CheckpointEntry)) == -1) {
+        int saved = errno;
+        close(fd);
+        unlink(tmpPath);
+        errno = saved;
+        return -1;
+    }
+    if (close(fd) == -1 || rename(tmpPath, path) == -1) {
+        int saved = errno;
+        unlink(tmpPath);
+        errno = saved;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Map a checkpoint read-only and check its header
+ * @return 0 on success, -1 with errno set (EINVAL if it is not a checkpoint)
+ */
+int checkpointMap(const char *path, CheckpointFile *file) {
+    memset(file, 0, sizeof(*file));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return -1;
+    }
+    if ((size_t)st.st_size < sizeof(CheckpointHeader)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+
+    const CheckpointHeader *header = map;
+    if (memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != CHECKPOINT_VERSION || header->entrySize != sizeof(CheckpointEntry) ||
+        header->count < 0 || header->count > header->s ||
+        sizeof(CheckpointHeader) + header->count * sizeof(CheckpointEntry) > (size_t)st.st_size) {
+        munmap(map, st.st_size);
+        errno = EINVAL;
+        return -1;
+    }
+
+    file->header = header;
+    file->entries = (const CheckpointEntry *)(header + 1);
+    file->mappedSize = st.st_size;
+    return 0;
+}
+
+/**
+ * Unmap a checkpoint
+ */
+void checkpointUnmap(CheckpointFile *file) {
+    if (file->header != NULL) {
+        munmap((void *)file->header, file->mappedSize);
+    }
+    memset(file, 0, sizeof(*file));
+}
@@ -0,0 +1,72 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sched.h"
+#include "workgen.h"
+
+#define CHECKPOINT_MAGIC "OSSCKPT"
+#define CHECKPOINT_VERSION 4
+
+// File header; one CheckpointEntry per running worker follows, in the order
+// the scheduler would dispatch them
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t entrySize;
+    uint64_t wallNs;            // realtime clock when written
+
+    // Simulation parameters; a resumed run takes these over
+    int32_t n, s, t, i;
+    int32_t dispatch;           // DispatchMode
+    int32_t policy;             // SchedPolicy
+    int32_t eventMode;
+    uint32_t seed;
+    int32_t count;              // Entries that follow
+    WorkgenConfig workgen;      // Arrival process and lifetimes (-A, -l, -g)
+    char arrivalTracePath[256]; // -g trace, "" if none
+    char workloadSpec[256];     // -w as given, "" if none
+    int32_t workerOutput;       // WorkerOutput (-o)
+    int32_t workerReports;      // -W
+
+    // Progress
+    uint64_t clockNs;
+    uint64_t lastLaunchNs;
+    uint64_t lastDisplayNs;
+    int32_t totalProcesses;
+    uint64_t totalMessages;
+    uint64_t skippedPasses;
+    uint64_t creditedQuanta;
+    SchedStats sched;
+    uint64_t lastBoostNs;       // Last MLFQ priority boost
+    uint64_t replayNext;        // Next record of the -R trace
+    char replayPath[256];       // -R trace, "" if none
+    WorkgenState generator;     // Generator, next arrival and trace position
+    Rng lottery;                // Lottery scheduler's generator
+} CheckpointHeader;
+
+// A running worker
+typedef struct {
+    uint64_t remainingNs;       // Lifetime left at the checkpoint
+    uint64_t launchNs;          // Scheduler accounting (struct PCB)
+    uint64_t deadlineNs;
+    uint64_t firstDispatchNs;
+    uint64_t cpuNs;
+    uint64_t messagesSent;
+    int32_t dispatched;
+    int32_t level;              // MLFQ level
+} CheckpointEntry;
+
+// A checkpoint mapped for reading
+typedef struct {
+    const CheckpointHeader *header;
+    const CheckpointEntry *entries;
+    size_t mappedSize;
+} CheckpointFile;
+
+int checkpointWrite(const char *path, const CheckpointHeader *header, const CheckpointEntry *entries);
+int checkpointMap(const char *path, CheckpointFile *file);
+void checkpointUnmap(CheckpointFile *file);
+
+#endif /* CHECKPOINT_H */
@@ -2,34 +2,93 @@
 #define COMMON_H
 
 #include <sys/types.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
 
-// Define shared memory structure for the system clock
+// Define shared memory structure for the system clock. A single 64-bit
+// nanosecond counter is read and advanced atomically, so readers never see
+// a torn seconds/nanoseconds pair and the range covers centuries.
 typedef struct {
-    unsigned int seconds;
-    unsigned int nanoseconds;
+    _Atomic uint64_t ns;    // simulated nanoseconds since oss started
 } SystemClock;
 
 // Define message structure for message queue
 typedef struct {
     long mtype;     // Message type
+    pid_t pid;      // Sender PID on replies to oss, 0 otherwise
     int status;     // 1 for running, 0 for terminating
+    int shard;      // Dispatcher shard that takes the reply (oss -> worker)
+    uint32_t payloadOffset;     // Reply's payload in the arena (payload.h)
+    uint32_t payloadLength;     // Its bytes, 0 for a status-only message
 } Message;
 
-// Define PCB structure for process table
+// Status of the synthetic message that interrupts oss's blocking receive
+#define MSG_STATUS_INTERRUPT (-1)
+
+// Payload size passed to msgsnd/msgrcv
+#define MSG_SIZE (sizeof(Message) - sizeof(long))
+
+// Per-entry process table data that is not needed on the dispatch path.
+// occupied, pid and messagesSent live in ProcessTable's hot arrays.
 struct PCB {
-    int occupied;           // either true (1) or false (0)
-    pid_t pid;              // process id of this child
     int startSeconds;       // time when it was forked
     int startNano;          // time when it was forked
-    int messagesSent;       // total times oss sent a message to this process
+    uint64_t launchWallNs;  // wall time of launch until the first reply, else 0
+    uint64_t sentWallNs;    // wall time the outstanding quantum was sent
+    int exited;             // worker process has been reaped
+    int slow;               // a reply is overdue (oss -q): no quanta until it arrives or the worker is reaped
+    int timeouts;           // quanta whose reply missed the budget (oss -q)
+
+    // Scheduler accounting, in simulated nanoseconds
+    uint64_t launchNs;      // clock when launched
+    uint64_t deadlineNs;    // clock at which the worker will terminate
+    uint64_t firstDispatchNs;  // clock of the first quantum (valid once dispatched)
+    uint64_t cpuNs;         // total quanta received
+    int dispatched;         // has received at least one quantum
 };
 
 // Constants
-#define MAX_PROCESSES 20     // Maximum processes in process table
-#define NANO_PER_SEC 1000000000  // Nanoseconds per second
+#define NANO_PER_SEC 1000000000ULL  // Nanoseconds per second
+#define NANO_PER_MS 1000000ULL       // Nanoseconds per millisecond
+
+// Split a clock value into its seconds and nanoseconds parts
+#define CLOCK_SECONDS(ns) ((unsigned long long)((ns) / NANO_PER_SEC))
+#define CLOCK_NANOS(ns) ((unsigned int)((ns) % NANO_PER_SEC))
+
+/**
+ * Read the simulated clock; lock-free and syscall-free
+ */
+static inline uint64_t clockRead(const SystemClock *clock) {
+    return atomic_load_explicit(&((SystemClock *)clock)->ns, memory_order_acquire);
+}
+
+/**
+ * Advance the simulated clock
+ * @return The new clock value
+ */
+static inline uint64_t clockAdvance(SystemClock *clock, uint64_t deltaNs) {
+    return atomic_fetch_add_explicit(&clock->ns, deltaNs, memory_order_acq_rel) + deltaNs;
+}
+
+/**
+ * Set the simulated clock to an absolute value
+ */
+static inline void clockSet(SystemClock *clock, uint64_t ns) {
+    atomic_store_explicit(&clock->ns, ns, memory_order_release);
+}
+
+/**
+ * Wall-clock monotonic time in nanoseconds, for latency measurements
+ */
+static inline uint64_t monotonicNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NANO_PER_SEC + ts.tv_nsec;
+}
 
-// Keys for IPC
-#define SHM_KEY 'S'  // Shared memory key
-#define MSG_KEY 'M'  // Message queue key
+// Every run creates its own control region (region.h) and message queue
+// (IPC_PRIVATE) and hands their descriptors to workers on the command line,
+// so simulations started in the same directory never share any state.
 
 #endif /* COMMON_H */
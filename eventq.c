@@ -0,0 +1,111 @@
+#include <stdlib.h>
+#include <string.h>
+#include "eventq.h"
+
+/**
+ * Place an event at a heap position and record where it is
+ */
+static void heapSet(EventQueue *q, int pos, int id) {
+    q->heap[pos] = id;
+    q->pos[id] = pos;
+}
+
+/**
+ * Restore heap order around a position after an insert, update or removal
+ */
+static void heapFix(EventQueue *q, int pos) {
+    int id = q->heap[pos];
+    uint64_t t = q->time[id];
+
+    // Sift up
+    while (pos > 0 && t < q->time[q->heap[(pos - 1) / 2]]) {
+        heapSet(q, pos, q->heap[(pos - 1) / 2]);
+        pos = (pos - 1) / 2;
+    }
+
+    // Sift down
+    for (;;) {
+        int child = 2 * pos + 1;
+        if (child >= q->size) {
+            break;
+        }
+        if (child + 1 < q->size && q->time[q->heap[child + 1]] < q->time[q->heap[child]]) {
+            child++;
+        }
+        if (q->time[q->heap[child]] >= t) {
+            break;
+        }
+        heapSet(q, pos, q->heap[child]);
+        pos = child;
+    }
+    heapSet(q, pos, id);
+}
+
+/**
+ * Initialize an empty event queue
+ * @param ids Number of distinct event IDs (0 .. ids-1)
+ * @return 0 on success, -1 on allocation failure
+ */
+int eventQueueInit(EventQueue *q, int ids) {
+    q->ids = ids;
+    q->size = 0;
+    q->heap = malloc(ids * sizeof(int));
+    q->pos = malloc(ids * sizeof(int));
+    q->time = malloc(ids * sizeof(uint64_t));
+    if (q->heap == NULL || q->pos == NULL || q->time == NULL) {
+        return -1;
+    }
+    memset(q->pos, 0xff, ids * sizeof(int));
+    return 0;
+}
+
+/**
+ * Release the queue's memory
+ */
+void eventQueueFree(EventQueue *q) {
+    free(q->heap);
+    free(q->pos);
+    free(q->time);
+    memset(q, 0, sizeof(*q));
+}
+
+/**
+ * Schedule an event, moving it if it is already pending
+ */
+void eventSchedule(EventQueue *q, int id, uint64_t time) {
+    q->time[id] = time;
+    if (q->pos[id] == -1) {
+        heapSet(q, q->size++, id);
+    }
+    heapFix(q, q->pos[id]);
+}
+
+/**
+ * Remove a pending event; does nothing if it is not pending
+ */
+void eventCancel(EventQueue *q, int id) {
+    int pos = q->pos[id];
+    if (pos == -1) {
+        return;
+    }
+    q->pos[id] = -1;
+
+    int last = q->heap[--q->size];
+    if (pos < q->size) {
+        heapSet(q, pos, last);
+        heapFix(q, pos);
+    }
+}
+
+/**
+ * Earliest pending event
+ * @param time Set to the event's time
+ * @return ID of the event, or -1 if none is pending
+ */
+int eventPeek(const EventQueue *q, uint64_t *time) {
+    if (q->size == 0) {
+        return -1;
+    }
+    *time = q->time[q->heap[0]];
+    return q->heap[0];
+}
@@ -0,0 +1,23 @@
+#ifndef EVENTQ_H
+#define EVENTQ_H
+
+#include <stdint.h>
+
+// Indexed binary min-heap of timed events. Each event has a small integer
+// ID and at most one pending time, so rescheduling and cancelling an event
+// are O(log n) without searching.
+typedef struct {
+    int ids;                // Number of distinct event IDs
+    int size;               // Pending events
+    int *heap;              // Event IDs ordered by time
+    int *pos;               // Heap position of each ID, -1 if not pending
+    uint64_t *time;         // Pending time of each ID
+} EventQueue;
+
+int eventQueueInit(EventQueue *q, int ids);
+void eventQueueFree(EventQueue *q);
+void eventSchedule(EventQueue *q, int id, uint64_t time);
+void eventCancel(EventQueue *q, int id);
+int eventPeek(const EventQueue *q, uint64_t *time);
+
+#endif /* EVENTQ_H */
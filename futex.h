@@ -0,0 +1,40 @@
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+/**
+ * Park the caller while *addr still holds the expected value
+ */
+static inline void futexWait(_Atomic uint32_t *addr, uint32_t expected) {
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT, expected, NULL, NULL, 0);
+}
+
+/**
+ * Like futexWait, but give up after a relative timeout
+ */
+static inline void futexWaitTimeout(_Atomic uint32_t *addr, uint32_t expected,
+                                    const struct timespec *timeout) {
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT, expected, timeout, NULL, 0);
+}
+
+/**
+ * Wake one waiter parked on addr
+ */
+static inline void futexWake(_Atomic uint32_t *addr) {
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+/**
+ * Wake every waiter parked on addr
+ */
+static inline void futexWakeAll(_Atomic uint32_t *addr) {
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+#endif /* FUTEX_H */
@@ -0,0 +1,98 @@
+#include <string.h>
+#include "latency.h"
+
+#define LATENCY_SUB_COUNT (1 << LATENCY_SUB_BITS)
+
+/**
+ * Bucket holding a value: exact below LATENCY_SUB_COUNT, then
+ * LATENCY_SUB_COUNT linear sub-buckets per power of two
+ */
+static int bucketOf(uint64_t ns) {
+    if (ns < LATENCY_SUB_COUNT) {
+        return (int)ns;
+    }
+    int msb = 63 - __builtin_clzll(ns);
+    int shift = msb - LATENCY_SUB_BITS;
+    return ((shift + 1) << LATENCY_SUB_BITS) | (int)((ns >> shift) & (LATENCY_SUB_COUNT - 1));
+}
+
+/**
+ * Largest value that falls into a bucket
+ */
+static uint64_t bucketUpper(int bucket) {
+    if (bucket < LATENCY_SUB_COUNT) {
+        return bucket;
+    }
+    int shift = (bucket >> LATENCY_SUB_BITS) - 1;
+    uint64_t base = (uint64_t)(LATENCY_SUB_COUNT | (bucket & (LATENCY_SUB_COUNT - 1))) << shift;
+    return base + ((1ULL << shift) - 1);
+}
+
+/**
+ * Empty a histogram
+ */
+void latencyReset(LatencyHistogram *h) {
+    memset(h, 0, sizeof(*h));
+    h->minNs = UINT64_MAX;
+}
+
+/**
+ * Record one sample
+ */
+void latencyRecord(LatencyHistogram *h, uint64_t ns) {
+    h->buckets[bucketOf(ns)]++;
+    h->count++;
+    h->sumNs += ns;
+    if (ns < h->minNs) {
+        h->minNs = ns;
+    }
+    if (ns > h->maxNs) {
+        h->maxNs = ns;
+    }
+}
+
+/**
+ * Value at or below which the given share of samples fall
+ * @param percentile 0-100
+ * @return Upper bound of the bucket holding that sample (capped at the maximum), 0 if empty
+ */
+uint64_t latencyPercentile(const LatencyHistogram *h, double percentile) {
+    if (h->count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(percentile / 100.0 * h->count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen >= rank) {
+            uint64_t upper = bucketUpper(b);
+            return upper < h->maxNs ? upper : h->maxNs;
+        }
+    }
+    return h->maxNs;
+}
+
+/**
+ * Average of all samples, 0 if empty
+ */
+double latencyMeanNs(const LatencyHistogram *h) {
+    return h->count > 0 ? (double)h->sumNs / h->count : 0.0;
+}
+
+/**
+ * Write a histogram summary as a JSON object
+ */
+void latencyWriteJson(FILE *out, const LatencyHistogram *h) {
+    fprintf(out, "{\"count\": %llu, \"meanNs\": %.1f, \"minNs\": %llu, \"p50Ns\": %llu, \"p90Ns\": %llu, "
+            "\"p99Ns\": %llu, \"p999Ns\": %llu, \"maxNs\": %llu}",
+            (unsigned long long)h->count, latencyMeanNs(h),
+            (unsigned long long)(h->count > 0 ? h->minNs : 0),
+            (unsigned long long)latencyPercentile(h, 50), (unsigned long long)latencyPercentile(h, 90),
+            (unsigned long long)latencyPercentile(h, 99), (unsigned long long)latencyPercentile(h, 99.9),
+            (unsigned long long)h->maxNs);
+}
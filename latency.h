@@ -0,0 +1,25 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define LATENCY_SUB_BITS 4                          // 16 sub-buckets per power of two (~6% error)
+#define LATENCY_BUCKETS (61 << LATENCY_SUB_BITS)    // Covers the full uint64_t range
+
+// Log-linear latency histogram: fixed size, O(1) record, no allocation
+typedef struct {
+    uint64_t count;
+    uint64_t sumNs;
+    uint64_t minNs;
+    uint64_t maxNs;
+    uint64_t buckets[LATENCY_BUCKETS];
+} LatencyHistogram;
+
+void latencyReset(LatencyHistogram *h);
+void latencyRecord(LatencyHistogram *h, uint64_t ns);
+uint64_t latencyPercentile(const LatencyHistogram *h, double percentile);
+double latencyMeanNs(const LatencyHistogram *h);
+void latencyWriteJson(FILE *out, const LatencyHistogram *h);
+
+#endif /* LATENCY_H */
@@ -0,0 +1,349 @@
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "common.h"
+#include "futex.h"
+#include "launcher.h"
+#include "placement.h"
+#include "region.h"
+#include "reaper.h"
+#include "remote.h"
+#include "workerloop.h"
+
+#define THREAD_WORKER_STACK (64 * 1024)  // Stack per in-process worker thread
+
+// An in-process worker (-L thread)
+typedef struct {
+    WorkerContext ctx;
+    pthread_t thread;
+} ThreadWorker;
+
+extern char **environ;
+
+static LaunchMode launchMode = LAUNCH_EXEC;
+static Transport *workerTransport = NULL;
+static Region *workerRegion = NULL;
+static char regionFdArg[16];        // Descriptors handed to worker processes
+static char queueIdArg[16];
+static char workloadArg[256];       // -w spec handed to worker processes, "" for none
+static const Workload *workerWorkload = NULL;
+static pid_t *sparePids = NULL;     // Parked worker per entry, 0 if none
+static int poolSlots = 0;
+static int spareCount = 0;
+static ThreadWorker *threadWorkers = NULL;  // Per entry (-L thread)
+static pthread_attr_t threadAttr;
+static pid_t nextVirtualPid = 1;    // Worker IDs reported by thread workers
+
+/**
+ * Parse a launch mode name given on the command line
+ * @return 0 on success, -1 if the name is unknown
+ */
+int parseLaunchMode(const char *name, LaunchMode *mode) {
+    if (strcmp(name, "exec") == 0) {
+        *mode = LAUNCH_EXEC;
+    } else if (strcmp(name, "pool") == 0) {
+        *mode = LAUNCH_POOL;
+    } else if (strcmp(name, "spawn") == 0) {
+        *mode = LAUNCH_SPAWN;
+    } else if (strcmp(name, "thread") == 0) {
+        *mode = LAUNCH_THREAD;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Name of a launch mode for logs and statistics
+ */
+const char *launchModeName(LaunchMode mode) {
+    switch (mode) {
+        case LAUNCH_POOL:
+            return "pool";
+        case LAUNCH_SPAWN:
+            return "spawn";
+        case LAUNCH_THREAD:
+            return "thread";
+        case LAUNCH_REMOTE:
+            return "remote";
+        default:
+            return "exec";
+    }
+}
+
+/**
+ * Start ./worker with the given arguments; the reaper collects it on exit
+ * @param useSpawn Use posix_spawn instead of fork + exec
+ * @param slot Process table entry, for CPU placement
+ * @return PID of the new process, or -1 on failure
+ */
+static pid_t startWorkerProcess(char *const argv[], int useSpawn, int slot) {
+    pid_t pid;
+
+    if (useSpawn) {
+        int rc = posix_spawn(&pid, "./worker", NULL, NULL, argv, environ);
+        if (rc != 0) {
+            errno = rc;
+            return -1;
+        }
+        reaperChildStarted();
+
+        // posix_spawn has no affinity attribute; the worker has only just started
+        if (placementApply(pid, slot) == -1 && errno != ESRCH) {
+            perror("sched_setaffinity");
+        }
+        return pid;
+    }
+
+    pid = fork();
+    if (pid == 0) {
+        // Set up signal handler for parent termination
+        signal(SIGTERM, SIG_DFL);  // Default handler for SIGTERM
+
+        // Place the worker before it execs so it never runs on the dispatcher's CPU
+        if (placementApply(0, slot) == -1) {
+            perror("sched_setaffinity");
+        }
+
+        execv("./worker", argv);
+
+        // If execv fails
+        perror("execv");
+        _exit(EXIT_FAILURE);
+    }
+    if (pid > 0) {
+        reaperChildStarted();
+    }
+    return pid;
+}
+
+/**
+ * Thread entry point for an in-process worker
+ */
+static void *threadWorkerMain(void *arg) {
+    WorkerContext *ctx = &((ThreadWorker *)arg)->ctx;
+
+    // Leave the dispatcher's CPU, whose affinity the thread inherited
+    if (placementApply(0, ctx->slot) == -1) {
+        perror("sched_setaffinity");
+    }
+    workerRun(ctx);
+    return NULL;
+}
+
+/**
+ * Set up the launcher; pool mode tracks the parked workers and thread mode
+ * creates the per-entry worker contexts
+ * @param mode Launch mode
+ * @param transport Transport the workers must use
+ * @param region Control region; worker processes inherit its descriptor
+ * @param slots Number of process table entries
+ * @return 0 on success, -1 on failure
+ */
+int launcherInit(LaunchMode mode, Transport *transport, Region *region, int slots) {
+    launchMode = mode;
+    workerTransport = transport;
+    workerRegion = region;
+    snprintf(regionFdArg, sizeof(regionFdArg), "%d", region->fd);
+    snprintf(queueIdArg, sizeof(queueIdArg), "%d", transport->msgqid);
+
+    if (mode == LAUNCH_THREAD) {
+        threadWorkers = calloc(slots, sizeof(ThreadWorker));
+        if (threadWorkers == NULL) {
+            perror("calloc");
+            return -1;
+        }
+        pthread_attr_init(&threadAttr);
+        pthread_attr_setstacksize(&threadAttr, THREAD_WORKER_STACK);
+        return 0;
+    }
+
+    if (mode != LAUNCH_POOL) {
+        return 0;
+    }
+
+    sparePids = calloc(slots, sizeof(pid_t));
+    if (sparePids == NULL) {
+        perror("calloc");
+        return -1;
+    }
+    poolSlots = slots;
+    return 0;
+}
+
+/**
+ * Start a worker with a lifetime in a process table entry. The lifetime is
+ * written to the entry's control line, where worker processes read it; in
+ * pool mode this activates the worker already parked on the entry,
+ * otherwise a new one is started. With -T sock the entry's worker agent
+ * starts it.
+ * @return PID of the worker, or -1 on failure
+ */
+pid_t launcherStart(int slot, int seconds, int nanoseconds) {
+    if (launchMode == LAUNCH_REMOTE) {
+        return remoteLaunch(slot, (uint64_t)seconds * NANO_PER_SEC + nanoseconds);
+    }
+
+    ControlLine *line = &workerRegion->control[slot];
+    line->seconds = seconds;
+    line->nanoseconds = nanoseconds;
+    atomic_store(&line->state, CONTROL_ASSIGNED);
+
+    if (launcherHasSpare(slot)) {
+        futexWake(&line->state);
+
+        pid_t pid = sparePids[slot];
+        sparePids[slot] = 0;
+        spareCount--;
+        return pid;
+    }
+
+    if (launchMode == LAUNCH_THREAD) {
+        ThreadWorker *tw = &threadWorkers[slot];
+        tw->ctx.transport = workerTransport;
+        tw->ctx.slot = slot;
+        tw->ctx.clock = workerRegion->clock;
+        tw->ctx.pid = nextVirtualPid;
+        tw->ctx.parentPid = getpid();
+        tw->ctx.lifetimeNs = (uint64_t)seconds * NANO_PER_SEC + nanoseconds;
+        tw->ctx.workload = workerWorkload;
+        tw->ctx.output = (WorkerOutput)workerRegion->header->workerOutput;
+        tw->ctx.log = &workerRegion->logs[slot];
+        tw->ctx.payload = workerRegion->header->workerReports ? &workerRegion->payloads[slot] : NULL;
+
+        // Signals stay with the dispatching thread
+        sigset_t all, previous;
+        sigfillset(&all);
+        pthread_sigmask(SIG_BLOCK, &all, &previous);
+        int rc = pthread_create(&tw->thread, &threadAttr, threadWorkerMain, tw);
+        pthread_sigmask(SIG_SETMASK, &previous, NULL);
+        if (rc != 0) {
+            errno = rc;
+            return -1;
+        }
+        return nextVirtualPid++;
+    }
+
+    char slotStr[20];
+    sprintf(slotStr, "%d", slot);
+
+    char *argv[] = { "worker", "-T", (char *)transportName(workerTransport->kind), "-m", slotStr,
+                     "-r", regionFdArg, "-q", queueIdArg, workloadArg[0] != '\0' ? "-w" : NULL, workloadArg, NULL };
+    return startWorkerProcess(argv, launchMode == LAUNCH_SPAWN, slot);
+}
+
+/**
+ * Pre-start a worker that maps the control region and parks on an entry's
+ * control line until launcherStart hands it a lifetime
+ * @return 0 on success, -1 on failure
+ */
+int launcherPrepare(int slot) {
+    if (launchMode != LAUNCH_POOL || slot >= poolSlots || sparePids[slot] > 0) {
+        return 0;
+    }
+
+    atomic_store(&workerRegion->control[slot].state, CONTROL_IDLE);
+
+    char slotStr[20];
+    sprintf(slotStr, "%d", slot);
+    char *argv[] = { "worker", "-T", (char *)transportName(workerTransport->kind), "-m", slotStr,
+                     "-r", regionFdArg, "-q", queueIdArg, workloadArg[0] != '\0' ? "-w" : NULL, workloadArg, NULL };
+
+    pid_t pid = startWorkerProcess(argv, 1, slot);
+    if (pid == -1) {
+        return -1;
+    }
+    sparePids[slot] = pid;
+    spareCount++;
+    return 0;
+}
+
+/**
+ * Finish off a worker that announced it is terminating. Thread workers are
+ * joined; worker processes are collected asynchronously by the reaper.
+ * @param slot Process table entry the worker occupied
+ * @param pid PID (or thread worker ID) of the worker
+ */
+void launcherReap(int slot, pid_t pid) {
+    if (launchMode == LAUNCH_THREAD) {
+        pthread_join(threadWorkers[slot].thread, NULL);
+    }
+}
+
+/**
+ * Forget a parked worker that exited before it was activated
+ * @return 1 if pid was a parked worker, 0 otherwise
+ */
+int launcherForget(pid_t pid) {
+    for (int i = 0; i < poolSlots; i++) {
+        if (sparePids[i] == pid) {
+            sparePids[i] = 0;
+            spareCount--;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Whether workers are child processes that can be signalled and waited for
+ */
+int launcherUsesProcesses(void) {
+    return launchMode != LAUNCH_THREAD && launchMode != LAUNCH_REMOTE;
+}
+
+/**
+ * Whether a parked worker is waiting on an entry
+ */
+int launcherHasSpare(int slot) {
+    return launchMode == LAUNCH_POOL && slot < poolSlots && sparePids[slot] > 0;
+}
+
+/**
+ * Number of parked workers
+ */
+int launcherSpareCount(void) {
+    return spareCount;
+}
+
+/**
+ * Send a signal to every parked worker
+ */
+void launcherSignalSpares(int sig) {
+    for (int i = 0; i < poolSlots; i++) {
+        if (sparePids[i] > 0) {
+            kill(sparePids[i], sig);
+        }
+    }
+}
+
+/**
+ * Set the kernels workers run in every quantum (oss -w). Call before the
+ * first launcherPrepare or launcherStart.
+ * @param spec Workload as given on the command line, passed to worker processes
+ * @param workload The parsed spec, shared by thread workers
+ */
+void launcherSetWorkload(const char *spec, const Workload *workload) {
+    snprintf(workloadArg, sizeof(workloadArg), "%s", spec);
+    workerWorkload = workload;
+}
+
+/**
+ * Release the parked worker and thread worker tables
+ */
+void launcherCleanup(void) {
+    free(sparePids);
+    sparePids = NULL;
+    if (threadWorkers != NULL) {
+        pthread_attr_destroy(&threadAttr);
+        free(threadWorkers);
+        threadWorkers = NULL;
+    }
+    poolSlots = 0;
+    spareCount = 0;
+}
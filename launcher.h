@@ -0,0 +1,34 @@
+#ifndef LAUNCHER_H
+#define LAUNCHER_H
+
+#include <sys/types.h>
+#include "common.h"
+#include "region.h"
+#include "transport.h"
+#include "workload.h"
+
+// How oss starts worker processes
+typedef enum {
+    LAUNCH_EXEC,            // fork() + exec of ./worker on demand (default)
+    LAUNCH_POOL,            // Activate a pre-exec'd, pre-attached worker parked on a slot
+    LAUNCH_SPAWN,           // posix_spawn() (vfork-style) of ./worker on demand
+    LAUNCH_THREAD,          // Worker loop on a thread inside oss, in-memory mailboxes
+    LAUNCH_REMOTE           // Ask a worker agent to start it (-T sock)
+} LaunchMode;
+
+int parseLaunchMode(const char *name, LaunchMode *mode);
+const char *launchModeName(LaunchMode mode);
+
+int launcherInit(LaunchMode mode, Transport *transport, Region *region, int slots);
+pid_t launcherStart(int slot, int seconds, int nanoseconds);
+int launcherPrepare(int slot);
+void launcherReap(int slot, pid_t pid);
+int launcherForget(pid_t pid);
+int launcherUsesProcesses(void);
+int launcherHasSpare(int slot);
+int launcherSpareCount(void);
+void launcherSignalSpares(int sig);
+void launcherSetWorkload(const char *spec, const Workload *workload);
+void launcherCleanup(void);
+
+#endif /* LAUNCHER_H */
@@ -0,0 +1,387 @@
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "common.h"
+#include "futex.h"
+#include "logger.h"
+#include "workerlog.h"
+
+#define LOG_QUEUE_CAPACITY 16384     // Records (power of two)
+#define LOG_WAKE_THRESHOLD 1024      // Queued records before producers wake the writer
+#define LOG_BATCH_BYTES (256 * 1024) // Formatted bytes per write() batch
+#define LOG_LINE_MAX 256             // Longest formatted record
+#define LOG_TEXT_MAX 240             // Longest LOG_TEXT payload
+#define LOG_IDLE_NS (10 * NANO_PER_MS)  // Writer wakes at least this often
+
+// One queue cell; 'seq' implements the bounded multi-producer queue
+typedef struct {
+    _Atomic uint64_t seq;
+    uint16_t type;
+    uint16_t length;        // Text length for LOG_TEXT
+    union {
+        int64_t args[6];
+        char text[LOG_TEXT_MAX];
+    };
+} LogRecord;
+
+static LogRecord *queue = NULL;
+static _Atomic uint64_t enqueuePos;
+static _Atomic uint64_t dequeuePos;     // Advanced only by the writer thread
+static _Atomic uint32_t writerWake;     // Futex word the writer sleeps on
+static _Atomic int stopping;
+static _Atomic uint64_t written;
+static _Atomic uint64_t dropped;
+static int running = 0;
+static int verbosityLevel = LOG_MESSAGES;
+static int outputFds[2] = { STDOUT_FILENO, -1 };
+static pthread_t writerThread;
+
+// Minimum verbosity at which each event type is recorded
+static const int eventLevel[LOG_EVENT_TYPES] = {
+    [LOG_TEXT] = LOG_QUIET,
+    [LOG_LAUNCH] = LOG_LIFECYCLE,
+    [LOG_SEND] = LOG_MESSAGES,
+    [LOG_RECEIVE] = LOG_MESSAGES,
+    [LOG_TERMINATING] = LOG_LIFECYCLE,
+    [LOG_UNEXPECTED_EXIT] = LOG_LIFECYCLE,
+    [LOG_REPLY_TIMEOUT] = LOG_LIFECYCLE,
+    [LOG_TABLE_HEADER] = LOG_LIFECYCLE,
+    [LOG_TABLE_ROW] = LOG_LIFECYCLE,
+    [LOG_TABLE_END] = LOG_LIFECYCLE,
+    [LOG_WORKER] = LOG_MESSAGES,
+};
+
+/**
+ * Write a whole buffer to every output, retrying short writes
+ */
+static void writeAll(const char *buf, size_t len) {
+    for (int i = 0; i < 2; i++) {
+        if (outputFds[i] < 0) {
+            continue;
+        }
+        size_t off = 0;
+        while (off < len) {
+            ssize_t n = write(outputFds[i], buf + off, len - off);
+            if (n == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            off += n;
+        }
+    }
+}
+
+/**
+ * Render one record as text
+ * @return Number of bytes written to out
+ */
+static int formatRecord(const LogRecord *rec, char *out) {
+    const int64_t *a = rec->args;
+
+    switch (rec->type) {
+        case LOG_TEXT:
+            memcpy(out, rec->text, rec->length);
+            return rec->length;
+        case LOG_LAUNCH:
+            if (a[3] >= 0) {
+                return snprintf(out, LOG_LINE_MAX,
+                                "OSS: Launching worker process PID %d (will run for %d sec, %d nano) on CPU %d\n",
+                                (int)a[0], (int)a[1], (int)a[2], (int)a[3]);
+            }
+            return snprintf(out, LOG_LINE_MAX, "OSS: Launching worker process PID %d (will run for %d sec, %d nano)\n",
+                            (int)a[0], (int)a[1], (int)a[2]);
+        case LOG_SEND:
+            return snprintf(out, LOG_LINE_MAX, "OSS: Sending message to worker %d PID %d at time %llu:%u\n",
+                            (int)a[0], (int)a[1], CLOCK_SECONDS((uint64_t)a[2]), CLOCK_NANOS((uint64_t)a[2]));
+        case LOG_RECEIVE:
+            return snprintf(out, LOG_LINE_MAX, "OSS: Receiving message from worker %d PID %d at time %llu:%u\n",
+                            (int)a[0], (int)a[1], CLOCK_SECONDS((uint64_t)a[2]), CLOCK_NANOS((uint64_t)a[2]));
+        case LOG_TERMINATING:
+            return snprintf(out, LOG_LINE_MAX, "OSS: Worker %d PID %d is planning to terminate\n",
+                            (int)a[0], (int)a[1]);
+        case LOG_UNEXPECTED_EXIT:
+            return snprintf(out, LOG_LINE_MAX, "OSS: Worker %d PID %d has terminated unexpectedly\n",
+                            (int)a[0], (int)a[1]);
+        case LOG_REPLY_TIMEOUT:
+            return snprintf(out, LOG_LINE_MAX, "OSS: Worker %d PID %d gave no reply in %lld us (timeout %lld); %s\n",
+                            (int)a[0], (int)a[1], (long long)a[2], (long long)a[3],
+                            a[4] ? "killed" : "marked slow");
+        case LOG_TABLE_HEADER:
+            return snprintf(out, LOG_LINE_MAX, "OSS PID:%d SysClockS: %llu SysclockNano: %u\n"
+                            "Process Table%s:\nEntry\tOccupied\tPID\tStartS\tStartN\tMessagesSent\n",
+                            (int)a[0], CLOCK_SECONDS((uint64_t)a[1]), CLOCK_NANOS((uint64_t)a[1]),
+                            a[2] ? " (changed entries)" : "");
+        case LOG_TABLE_ROW:
+            return snprintf(out, LOG_LINE_MAX, "%d\t%d\t\t%d\t%d\t%d\t%lld\n",
+                            (int)a[0], (int)a[1], (int)a[2], (int)a[3], (int)a[4], (long long)a[5]);
+        case LOG_TABLE_END:
+            out[0] = '\n';
+            return 1;
+        case LOG_WORKER: {
+            int n = snprintf(out, LOG_LINE_MAX,
+                             "WORKER PID:%d PPID:%d SysClockS: %llu SysclockNano: %u TermTimeS: %llu TermTimeNano: %u\n",
+                             (int)a[1], (int)a[2], CLOCK_SECONDS((uint64_t)a[4]), CLOCK_NANOS((uint64_t)a[4]),
+                             CLOCK_SECONDS((uint64_t)a[5]), CLOCK_NANOS((uint64_t)a[5]));
+            if (a[0] == WORKER_LOG_START) {
+                return n + snprintf(out + n, LOG_LINE_MAX - n, "--Just Starting\n");
+            }
+            if (a[0] == WORKER_LOG_TERMINATE) {
+                return n + snprintf(out + n, LOG_LINE_MAX - n,
+                                    "--Terminating after sending message back to oss after %d iterations.\n", (int)a[3]);
+            }
+            return n + snprintf(out + n, LOG_LINE_MAX - n, "--%d iteration%s have passed since starting\n",
+                                (int)a[3], a[3] == 1 ? "" : "s");
+        }
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Claim a queue cell, or count a drop if the queue is full
+ * @return The claimed cell, or NULL
+ */
+static LogRecord *claimRecord(uint64_t *pos) {
+    uint64_t p = atomic_load_explicit(&enqueuePos, memory_order_relaxed);
+
+    for (;;) {
+        LogRecord *rec = &queue[p & (LOG_QUEUE_CAPACITY - 1)];
+        uint64_t seq = atomic_load_explicit(&rec->seq, memory_order_acquire);
+        int64_t diff = (int64_t)seq - (int64_t)p;
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&enqueuePos, &p, p + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *pos = p;
+                return rec;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            return NULL;
+        } else {
+            p = atomic_load_explicit(&enqueuePos, memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Publish a filled cell and nudge the writer once enough work has queued
+ */
+static void publishRecord(LogRecord *rec, uint64_t pos) {
+    atomic_store_explicit(&rec->seq, pos + 1, memory_order_release);
+
+    if (pos - atomic_load_explicit(&dequeuePos, memory_order_relaxed) >= LOG_WAKE_THRESHOLD) {
+        atomic_fetch_add(&writerWake, 1);
+        futexWake(&writerWake);
+    }
+}
+
+/**
+ * Writer thread: drain the queue, format records and write them in batches
+ */
+static void *writerMain(void *arg) {
+    char *batch = malloc(LOG_BATCH_BYTES + LOG_LINE_MAX);
+    size_t len = 0;
+    uint64_t readPos = 0;
+    struct timespec idle = { 0, LOG_IDLE_NS };
+    (void)arg;
+
+    for (;;) {
+        uint32_t wake = atomic_load(&writerWake);
+        int drained = 0;
+
+        for (;;) {
+            LogRecord *rec = &queue[readPos & (LOG_QUEUE_CAPACITY - 1)];
+            if (atomic_load_explicit(&rec->seq, memory_order_acquire) != readPos + 1) {
+                break;
+            }
+
+            len += formatRecord(rec, batch + len);
+            atomic_store_explicit(&rec->seq, readPos + LOG_QUEUE_CAPACITY, memory_order_release);
+            readPos++;
+            drained++;
+
+            if (len >= LOG_BATCH_BYTES) {
+                writeAll(batch, len);
+                len = 0;
+            }
+        }
+        atomic_store_explicit(&dequeuePos, readPos, memory_order_relaxed);
+        atomic_fetch_add_explicit(&written, drained, memory_order_relaxed);
+
+        if (len > 0) {
+            writeAll(batch, len);
+            len = 0;
+        }
+
+        if (atomic_load(&stopping) && drained == 0) {
+            break;
+        }
+        if (drained == 0) {
+            futexWaitTimeout(&writerWake, wake, &idle);
+        }
+    }
+
+    free(batch);
+    return NULL;
+}
+
+/**
+ * Start the background writer, with fresh written/dropped counts; does
+ * nothing if it is already running
+ * @param logfile Log file mirrored alongside stdout
+ * @param verbosity Highest level that is recorded
+ * @return 0 on success, -1 on failure
+ */
+int loggerStart(FILE *logfile, int verbosity) {
+    if (running) {
+        return 0;
+    }
+    verbosityLevel = verbosity;
+    outputFds[1] = logfile != NULL ? fileno(logfile) : -1;
+
+    atomic_store(&enqueuePos, 0);
+    atomic_store(&dequeuePos, 0);
+    atomic_store(&stopping, 0);
+    atomic_store(&written, 0);
+    atomic_store(&dropped, 0);
+
+    queue = aligned_alloc(64, LOG_QUEUE_CAPACITY * sizeof(LogRecord));
+    if (queue == NULL) {
+        return -1;
+    }
+    for (uint64_t i = 0; i < LOG_QUEUE_CAPACITY; i++) {
+        atomic_init(&queue[i].seq, i);
+    }
+
+    // Anything buffered so far must reach the files before the writer's output
+    fflush(stdout);
+    if (logfile != NULL) {
+        fflush(logfile);
+    }
+
+    // The writer never handles signals; they stay with the dispatching thread
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &previous);
+    int rc = pthread_create(&writerThread, NULL, writerMain, NULL);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    if (rc != 0) {
+        free(queue);
+        queue = NULL;
+        return -1;
+    }
+    running = 1;
+    return 0;
+}
+
+/**
+ * Flush every queued record and stop the writer; safe to call twice
+ */
+void loggerStop(void) {
+    if (!running) {
+        return;
+    }
+    running = 0;
+
+    atomic_store(&stopping, 1);
+    atomic_fetch_add(&writerWake, 1);
+    futexWake(&writerWake);
+    pthread_join(writerThread, NULL);
+
+    free(queue);
+    queue = NULL;
+}
+
+/**
+ * Whether records of a level are kept at the current verbosity
+ */
+int loggerEnabled(int level) {
+    return level <= verbosityLevel;
+}
+
+/**
+ * Queue an event; the writer formats it later
+ */
+void logEvent(LogEventType type, int64_t a, int64_t b, int64_t c, int64_t d, int64_t e, int64_t f) {
+    if (eventLevel[type] > verbosityLevel) {
+        return;
+    }
+
+    LogRecord local;
+    LogRecord *rec = &local;
+    uint64_t pos = 0;
+
+    if (running && (rec = claimRecord(&pos)) == NULL) {
+        return;
+    }
+
+    rec->type = type;
+    rec->args[0] = a;
+    rec->args[1] = b;
+    rec->args[2] = c;
+    rec->args[3] = d;
+    rec->args[4] = e;
+    rec->args[5] = f;
+
+    if (running) {
+        publishRecord(rec, pos);
+    } else {
+        // Writer not running: format and write synchronously
+        char line[LOG_LINE_MAX];
+        writeAll(line, formatRecord(rec, line));
+        atomic_fetch_add(&written, 1);
+    }
+}
+
+/**
+ * Queue a line of text formatted by the caller
+ */
+void logText(int level, const char *format, ...) {
+    if (level > verbosityLevel) {
+        return;
+    }
+
+    LogRecord local;
+    LogRecord *rec = &local;
+    uint64_t pos = 0;
+
+    if (running && (rec = claimRecord(&pos)) == NULL) {
+        return;
+    }
+
+    va_list ap;
+    va_start(ap, format);
+    int n = vsnprintf(rec->text, LOG_TEXT_MAX, format, ap);
+    va_end(ap);
+    rec->type = LOG_TEXT;
+    rec->length = (n < 0) ? 0 : (n >= LOG_TEXT_MAX ? LOG_TEXT_MAX - 1 : n);
+
+    if (running) {
+        publishRecord(rec, pos);
+    } else {
+        writeAll(rec->text, rec->length);
+        atomic_fetch_add(&written, 1);
+    }
+}
+
+/**
+ * Number of records written so far
+ */
+uint64_t loggerWritten(void) {
+    return atomic_load(&written);
+}
+
+/**
+ * Number of records dropped because the queue was full
+ */
+uint64_t loggerDropped(void) {
+    return atomic_load(&dropped);
+}
@@ -0,0 +1,38 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Verbosity levels selected with -v; a record is kept when its level is
+// at or below the configured verbosity
+#define LOG_QUIET 0         // Startup line only (final statistics are always printed)
+#define LOG_LIFECYCLE 1     // Launches, terminations and process tables
+#define LOG_MESSAGES 2      // Every send and receive (default)
+
+// Event records. Hot events carry raw integers and are formatted by the
+// writer thread; LOG_TEXT carries a line formatted by the caller.
+typedef enum {
+    LOG_TEXT,               // text
+    LOG_LAUNCH,             // pid, lifetime seconds, lifetime nanoseconds, pinned CPU (-1 if none)
+    LOG_SEND,               // entry, pid, clock
+    LOG_RECEIVE,            // entry, pid, clock
+    LOG_TERMINATING,        // entry, pid
+    LOG_UNEXPECTED_EXIT,    // entry, pid
+    LOG_REPLY_TIMEOUT,      // entry, pid, microseconds waited, timeouts of the entry, killed flag (-q)
+    LOG_TABLE_HEADER,       // oss pid, clock, delta-only flag
+    LOG_TABLE_ROW,          // entry, occupied, pid, start seconds, start nanoseconds, messages
+    LOG_TABLE_END,
+    LOG_WORKER,             // WorkerLogType, pid, parent pid, iterations, clock, termination time (-o ring)
+    LOG_EVENT_TYPES
+} LogEventType;
+
+int loggerStart(FILE *logfile, int verbosity);
+void loggerStop(void);
+int loggerEnabled(int level);
+void logEvent(LogEventType type, int64_t a, int64_t b, int64_t c, int64_t d, int64_t e, int64_t f);
+void logText(int level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+uint64_t loggerWritten(void);
+uint64_t loggerDropped(void);
+
+#endif /* LOGGER_H */
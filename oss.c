@@ -4,62 +4,212 @@
 #include <getopt.h>
 #include <sys/types.h>
 #include <sys/ipc.h>
-#include <sys/shm.h>
 #include <sys/msg.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <time.h>
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
 #include <stdbool.h>
 
-// Define constants if not using common.h
-#define SHM_KEY 'S'
-#define MSG_KEY 'M'
-#define MAX_PROCESSES 20
-#define NANO_PER_SEC 1000000000
-
-// Define shared memory structure for the system clock
-typedef struct {
-    unsigned int seconds;
-    unsigned int nanoseconds;
-} SystemClock;
-
-// Define PCB structure for process table
-struct PCB {
-    int occupied;           // either true (1) or false (0)
-    pid_t pid;              // process id of this child
-    int startSeconds;       // time when it was forked
-    int startNano;          // time when it was forked
-    int messagesSent;       // total times oss sent a message to this process
-};
-
-// Define message structure for message queue
-typedef struct {
-    long mtype;             // Message type
-    int status;             // 1 for running, 0 for terminating
-} Message;
+#include "common.h"
+#include "transport.h"
+#include "pcbtable.h"
+#include "logger.h"
+#include "launcher.h"
+#include "reaper.h"
+#include "sched.h"
+#include "eventq.h"
+#include "latency.h"
+#include "statseg.h"
+#include "trace.h"
+#include "placement.h"
+#include "region.h"
+#include "checkpoint.h"
+#include "workload.h"
+#include "workgen.h"
+#include "shard.h"
+#include "remote.h"
+#include "server.h"
 
 // Global variables for resources that need cleanup
-int shmid = -1;             // Shared memory ID
+Region region = { .fd = -1 };  // Clock, control lines, mailboxes and statistics
+int hugePages = 0;          // Back the region with huge pages (-H)
 int msgqid = -1;            // Message queue ID
+Transport transport = { TRANSPORT_MSG, -1, NULL };  // Active oss <-> worker transport
 SystemClock *systemClock;   // Pointer to shared memory clock
 FILE *logfile = NULL;       // Log file pointer
-struct PCB *processTable;   // Process table
+ProcessTable processTable;  // Process table
 int totalProcesses = 0;     // Total processes launched
-int totalMessages = 0;      // Total messages sent
-int simultaneousMax = 0;    // Maximum simultaneous processes
-pid_t childPIDs[MAX_PROCESSES];  // Array to keep track of child PIDs
+uint64_t totalMessages = 0; // Total messages sent
+int simultaneousMax = 0;    // Maximum simultaneous processes (process table entries)
+int simultaneousLimit = 0;  // Simultaneous processes of the current run, at most simultaneousMax
+int processLimit = 0;       // Total processes to launch
+LaunchMode launchMode = LAUNCH_EXEC;  // How workers are started (-L)
+uint64_t launchLatencyTotalNs = 0;    // Sum of launch-to-first-reply latencies
+uint64_t launchLatencyMaxNs = 0;      // Worst launch-to-first-reply latency
+int launchLatencySamples = 0;         // Launches that have replied at least once
+SchedPolicy schedPolicy = SCHED_RR;   // Which entry serial dispatch picks (-p)
+uint64_t quantumNs = 0;     // Simulated time each dispatched quantum covers
+int eventMode = 0;          // Jump the clock between events instead of stepping (-e)
+EventQueue events;          // Pending events (-e), IDs below
+unsigned long long skippedPasses = 0;   // Loop passes skipped by fast-forwarding
+unsigned long long creditedQuanta = 0;  // Quanta accounted without a message
+
+unsigned int seed = 0;      // Random seed (-S, default: time)
+char jsonPath[256] = "";    // Machine-readable final statistics (-j)
+LatencyHistogram roundTrip; // Wall time from sending a quantum to its reply
+
+char tracePath[256] = "";   // Binary event trace (-B)
+char replayPath[256] = "";  // Trace whose launch schedule is replayed (-R)
+TraceFile replay;           // Mapped -R trace
+size_t replayNext = 0;      // Next record of the replay trace to look at
+
+WorkgenConfig workgenConfig = { ARRIVAL_FIXED, LIFETIME_UNIFORM, WORKGEN_BURST_SIZE, 0.0, 0, 0 };  // -A, -l
+Workgen workgen = { .trace = { .fd = -1 } };  // Arrivals and lifetimes
+Rng lotteryRng;             // Lottery draws; separate, so arrivals depend only on -S
+char arrivalTracePath[256] = "";  // CSV trace of arrivals and lifetimes (-g)
+char workgenText[320] = "";       // Arrivals described, for the log and statistics
+
+char checkpointPath[256] = "";  // Periodic snapshot of the run (-k)
+uint64_t checkpointIntervalNs = 1000 * NANO_PER_MS;  // Wall time between snapshots (-K)
+CheckpointEntry *checkpointEntries = NULL;  // Scratch space for a snapshot
+int *checkpointOrder = NULL;
+char resumePath[256] = "";  // Snapshot a run is resumed from (-r)
+CheckpointFile resume;      // Mapped -r snapshot
+int runTimeLimit = 60;      // Wall-clock seconds before oss gives up (-a, 0 = none)
+
+int dispatcherCpu = -1;     // CPU the dispatcher is pinned to (-c)
+char *workerCpuList = NULL; // CPUs workers may run on (-C)
+PlacementPolicy placementPolicy = PLACE_NONE;  // How workers are placed on them (-P)
+char placement[512] = "";   // Chosen placement, for the log and statistics
+
+char workloadSpec[256] = "";    // Kernels workers run per quantum (-w), as given
+Workload workload;              // Parsed -w
+char workloadText[256] = "none";  // Described, for the log and statistics
+
+WorkerOutput workerOutput = WORKER_OUTPUT_STDOUT;  // Where workers report status (-o)
+unsigned long long workerRecords = 0;   // Worker log records merged into the log (-o ring)
+
+int workerReports = 0;      // Workers report each quantum through the payload arena (-W)
+unsigned long long reportPayloads = 0;  // Reports read from the arena
+unsigned long long reportBytes = 0;
+unsigned long long reportRejected = 0;  // Descriptors outside the sender's slab
+unsigned long long reportErrors = 0;    // Reports carrying an error
+uint64_t reportWorkNs = 0;              // Workload wall time reported
+uint64_t reportKernelNs[KERNEL_COUNT];  // The same, per kernel
+unsigned long long reportKernelSamples[KERNEL_COUNT];
+
+uint64_t replyBudgetNs = 0;  // Longest wait for a quantum's reply (-q, 0 = none)
+unsigned long long replyTimeouts = 0;   // Replies that missed the budget
+unsigned long long workersKilled = 0;   // Workers killed for it
+unsigned long long lateReplies = 0;     // Overdue replies of slow workers taken after all
+int slowCount = 0;          // Occupied entries marked slow
+int *slowSlots = NULL;      // Scratch list of them
+
+#define EVENT_LAUNCH 0      // Next allowed launch
+#define EVENT_DISPLAY 1     // Next process table display
+#define EVENT_CHILD 2       // + entry index: earliest time the worker can terminate
+int *pendingSlots = NULL;   // Scratch list of entries awaiting a reply (pipelined)
+int *exitedSlots = NULL;    // Occupied entries whose worker has been reaped
+int exitedCount = 0;        // Entries in exitedSlots
+volatile sig_atomic_t awaitingReply = 0;  // Blocked (or about to block) on a reply
+volatile sig_atomic_t stopSignal = 0;     // SIGINT or SIGALRM, acted on between passes
+
+#define SHUTDOWN_GRACE_NS (2 * NANO_PER_SEC)  // SIGTERM to SIGKILL escalation
+
+// How oss hands out quanta
+typedef enum {
+    DISPATCH_SERIAL,        // One worker at a time: send, then wait for its reply
+    DISPATCH_PIPELINED      // Send to every worker, then collect replies as they arrive
+} DispatchMode;
+
+DispatchMode dispatchMode = DISPATCH_SERIAL;
+int dispatcherThreads = 1;  // Threads exchanging a pipelined round's messages (-m)
+ShardJob *shardJobs = NULL; // The quanta of a sharded round (-m)
+int sendWindow = INT_MAX;   // Quanta a round keeps outstanding at once (transportSendWindow)
+
+char serverPath[256] = "";  // Unix socket jobs are served on (-u)
+int jobTimedOut = 0;        // The served job ran out of wall time (-a)
+int verbosity = LOG_MESSAGES;   // Log level (-v), restored for every served job
+int seedGiven = 0;          // -S given: every served job uses the same seed
+
+char agentAddress[256] = REMOTE_DEFAULT_ADDRESS;  // Where worker agents connect (-X)
+int agentsWanted = 1;       // Worker agents to wait for before starting (-N)
+
+// Process table rows as last displayed, for delta rendering (-D)
+typedef struct {
+    unsigned char occupied;
+    pid_t pid;
+    int startSeconds;
+    int startNano;
+    uint64_t messagesSent;
+} TableRow;
+
+int deltaTables = 0;        // Only display rows that changed since the last table
+TableRow *shownRows = NULL; // Last displayed value of every row
+int shownCapacity = 0;      // Rows in shownRows
 
 // Function prototypes
 void cleanup();
+void copyOption(char *dest, size_t size, int opt, const char *value);
 void sigintHandler(int sig);
 void timeoutHandler(int sig);
+void stopRun(int sig);
 void incrementClock(int activeChildren);
-int launchChild(int timelimit, int *processCount);
-int findNextChildIndex(int currentChild);
-int countActiveChildren();
+int launchChild(int *processCount);
+pid_t startChild(int index, int childSeconds, int childNano);
+int resumeChild(const CheckpointEntry *saved);
+void saveCheckpoint(int timelimit, int launchInterval, uint64_t lastLaunchTime, uint64_t lastDisplayTime);
+int sendQuantum(int index);
+void accountQuantum(int index);
+void handleReply(int index, const Message *response, uint64_t replyWallNs);
+void dispatchOne(int index);
+void dispatchRound();
+void dispatchShardedRound();
+void exchangeShardBatch(ShardJob *jobs, int count);
+void takeShardReplies(ShardJob *jobs, int count);
+void takeReport(int index, const Message *response);
+void retireChild(int index);
+void publishEntry(int index);
+void drainWorkerLog(int index);
+uint64_t nextLaunchTime(uint64_t lastLaunchTime);
+int replayPeekLaunch(const TraceRecord **launch);
+void fastForward(uint64_t lastLaunchTime, uint64_t lastDisplayTime);
+void creditQuanta(int index, uint64_t firstNs, uint64_t lastNs, uint64_t quantum, uint64_t count);
+int awaitReply(int *slots, int count, Message *msg, uint64_t deadlineNs);
+void replyOverdue(int index);
+int takeLateReply(const Message *response);
+void takeLateReplies(int wait);
+void interruptReceive(void);
+void onChildExit(pid_t pid, int status, const struct rusage *usage);
+void takeReply(const Message *response, int *pending, int *pendingCount);
+uint64_t roundDeadline(const int *pending, int pendingCount);
+void retireExited();
+void onShutdownExit(pid_t pid, int status, const struct rusage *usage);
+const char *dispatchModeName();
 void displayProcessTable();
+void writeJsonStats(int timelimit, int launchInterval, double elapsed, double messageRate,
+                    double launchLatencyAvgUs, unsigned long long reportDropped);
+void runSimulation(int timelimit, int launchInterval, FILE *client);
+void printFinalStats(FILE *out, double messageRate, double launchLatencyAvgUs, unsigned long long workerDropped,
+                     unsigned long long reportDropped, const char *kernelTimes);
+void serveJobs(int timelimit, int launchInterval);
+void startJob(const ServerRequest *request, int *timelimit, int *launchInterval);
+
+/**
+ * Copy an option's value into its buffer. A value that does not fit is an
+ * error rather than a truncated path, which a checkpoint would also keep.
+ */
+void copyOption(char *dest, size_t size, int opt, const char *value) {
+    size_t length = strlen(value);
+    if (length >= size) {
+        fprintf(stderr, "The -%c value is too long (at most %zu characters).\n", opt, size - 1);
+        exit(EXIT_FAILURE);
+    }
+    memcpy(dest, value, length + 1);
+}
 
 /**
  * Main function
@@ -67,18 +217,20 @@ void displayProcessTable();
 int main(int argc, char *argv[]) {
     // Default parameter values
     int opt;
-    int processLimit = 5;        // Default number of processes to launch
+    processLimit = 5;            // Default number of processes to launch
     simultaneousMax = 3;         // Default simultaneous processes
     int timelimit = 5;           // Default time limit for children
     int launchInterval = 1000;   // Default interval between launches (ms)
     char logfileName[256] = "oss.log"; // Default log file name
+    int processLimitGiven = 0;
+    int launchModeGiven = 0;
 
     // Parse command line arguments
-    while ((opt = getopt(argc, argv, "hn:s:t:i:f:")) != -1) {
+    while ((opt = getopt(argc, argv, "hn:s:t:i:f:T:d:m:v:DL:p:eS:j:B:R:c:C:P:Hk:K:r:a:w:A:l:g:o:WX:N:u:q:")) != -1) {
         switch (opt) {
             case 'h':
                 printf("Usage: %s [-h] [-n proc] [-s simul] [-t timelimitForChildren] ", argv[0]);
-                printf("[-i intervalInMsToLaunchChildren] [-f logfile]\n");
+                printf("[-i intervalInMsToLaunchChildren] [-f logfile] [-T msg|shm|sock] [-d serial|pipelined] [-m threads] [-v level] [-D] [-L exec|pool|spawn|thread] [-p rr|mlfq|srt|lottery] [-e] [-S seed] [-j file] [-B trace] [-R trace] [-c cpu] [-C cpulist] [-P spread|pack] [-H] [-k file] [-K ms] [-r file] [-a seconds] [-w workload] [-A arrivals] [-l lifetimes] [-g trace.csv] [-o stdout|ring|off] [-W] [-X address] [-N agents] [-u socket] [-q ms]\n");
                 printf("Options:\n");
                 printf("  -h                   : Display this help message\n");
                 printf("  -n proc              : Number of total processes to launch (default: %d)\n", processLimit);
@@ -86,17 +238,69 @@ int main(int argc, char *argv[]) {
                 printf("  -t timelimitForChildren: Upper bound for child runtime in seconds (default: %d)\n", timelimit);
                 printf("  -i intervalInMsToLaunchChildren: Minimum interval between child launches (default: %d)\n", launchInterval);
                 printf("  -f logfile           : Path to log file (default: %s)\n", logfileName);
+                printf("  -T transport         : msg (SysV message queue), shm (shared-memory mailboxes) or sock (TCP\n");
+                printf("                         to worker agents, which run the workers) (default: msg)\n");
+                printf("  -d dispatch          : serial (one worker per quantum) or pipelined (all workers per round) (default: serial)\n");
+                printf("  -m threads           : Threads sending a pipelined round's quanta and taking the replies, each\n");
+                printf("                         on its own channel, at most %d (default: 1)\n", SHARD_MAX);
+                printf("  -v level             : 0 = statistics only, 1 = launches/terminations/tables, 2 = every message (default: %d)\n", verbosity);
+                printf("  -D                   : Display only process table rows that changed since the last table\n");
+                printf("  -L launch            : exec (fork + exec), pool (pre-forked workers), spawn (posix_spawn)\n");
+                printf("                         or thread (workers as threads inside oss) (default: exec; pool with -u)\n");
+                printf("  -p policy            : rr (round-robin), mlfq (multi-level feedback queue), srt (shortest\n");
+                printf("                         remaining time) or lottery; selects the next worker (default: rr)\n");
+                printf("  -e                   : Discrete-event mode: jump the clock to the next launch, display or\n");
+                printf("                         worker deadline instead of exchanging messages that change nothing\n");
+                printf("  -S seed              : Random seed, for reproducible runs (default: current time)\n");
+                printf("  -j file              : Also write the final statistics to file as JSON\n");
+                printf("  -B trace             : Append fixed-size binary event records to trace (see ossanalyze)\n");
+                printf("  -R trace             : Replay the launch times and lifetimes recorded in trace (-n, -t\n");
+                printf("                         and -i are then ignored)\n");
+                printf("  -c cpu               : Pin the dispatcher to this CPU; workers then avoid it\n");
+                printf("  -C cpulist           : CPUs workers may run on, e.g. 0-3,8 (default: all)\n");
+                printf("  -P placement         : spread (entry i on the i-th CPU of the worker CPUs, round-robin)\n");
+                printf("                         or pack (CPUs sharing the dispatcher's last-level cache)\n");
+                printf("  -H                   : Back the control region with huge pages (transparent huge pages\n");
+                printf("                         if none are reserved)\n");
+                printf("  -k file              : Periodically snapshot the run to file, for -r\n");
+                printf("  -K ms                : Wall-clock milliseconds between snapshots (default: 1000)\n");
+                printf("  -r file              : Resume the run snapshotted in file (its -n, -s, -t, -i, -d, -p,\n");
+                printf("                         -e and -S replace the command line's)\n");
+                printf("  -a seconds           : Wall-clock time limit, 0 for none (default: %d)\n", runTimeLimit);
+                printf("  -w workload          : Kernels each worker runs per quantum, e.g. compute:1M,stream:8M,\n");
+                printf("                         chase:4M,sleep:100 (multiply-adds, bytes, bytes, us) (default: none)\n");
+                printf("  -A arrivals          : fixed (every -i ms), poisson (mean gap -i ms) or bursty[:size]\n");
+                printf("                         (Poisson bursts of back-to-back launches, mean size %g) (default: fixed)\n", WORKGEN_BURST_SIZE);
+                printf("  -l lifetimes         : uniform (1 s to 1 s + -t), or exp, pareto[:alpha] or lognormal[:sigma]\n");
+                printf("                         with the same mean, cut at %d x -t (default: uniform)\n", WORKGEN_LIFETIME_CAP);
+                printf("  -g trace.csv         : Launch at the arrival times with the lifetimes of a CSV trace of\n");
+                printf("                         arrival,lifetime lines in seconds, read as it goes (-n caps it)\n");
+                printf("  -o output            : Worker status lines: stdout (printf), ring (shared-memory log rings\n");
+                printf("                         merged in order into the log at -v 2) or off (default: stdout)\n");
+                printf("  -W                   : Workers report each quantum's work, kernel times and errors through\n");
+                printf("                         the shared payload arena\n");
+                printf("  -X address           : host:port oss listens on for worker agents (-T sock) (default: %s)\n",
+                       REMOTE_DEFAULT_ADDRESS);
+                printf("  -N agents            : Worker agents to wait for before starting, at most %d (default: %d)\n",
+                       REMOTE_MAX_AGENTS, agentsWanted);
+                printf("  -u socket            : Serve jobs from ossctl on this Unix socket, one after another,\n");
+                printf("                         keeping the IPC resources and workers (-L pool) between jobs;\n");
+                printf("                         a job's statistics are sent to ossctl when it ends\n");
+                printf("  -q ms                : Wait at most ms for a quantum's reply; a worker process that\n");
+                printf("                         misses it is killed, a thread or remote one skipped until it\n");
+                printf("                         replies (default: 0, wait as long as it takes)\n");
                 exit(EXIT_SUCCESS);
             case 'n':
                 processLimit = atoi(optarg);
-                if (processLimit <= 0 || processLimit > 100) {
+                processLimitGiven = 1;
+                if (processLimit <= 0) {
                     fprintf(stderr, "Invalid number of processes. Using default: 5\n");
                     processLimit = 5;
                 }
                 break;
             case 's':
                 simultaneousMax = atoi(optarg);
-                if (simultaneousMax <= 0 || simultaneousMax > 20) {
+                if (simultaneousMax <= 0) {
                     fprintf(stderr, "Invalid number of simultaneous processes. Using default: 3\n");
                     simultaneousMax = 3;
                 }
@@ -116,8 +320,163 @@ int main(int argc, char *argv[]) {
                 }
                 break;
             case 'f':
-                strncpy(logfileName, optarg, sizeof(logfileName) - 1);
-                logfileName[sizeof(logfileName) - 1] = '\0'; // Ensure null-termination
+                copyOption(logfileName, sizeof(logfileName), opt, optarg);
+                break;
+            case 'T':
+                if (parseTransportKind(optarg, &transport.kind) == -1) {
+                    fprintf(stderr, "Invalid transport. Use msg, shm or sock.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'd':
+                if (strcmp(optarg, "serial") == 0) {
+                    dispatchMode = DISPATCH_SERIAL;
+                } else if (strcmp(optarg, "pipelined") == 0) {
+                    dispatchMode = DISPATCH_PIPELINED;
+                } else {
+                    fprintf(stderr, "Invalid dispatch mode. Use serial or pipelined.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'm':
+                dispatcherThreads = atoi(optarg);
+                if (dispatcherThreads < 1 || dispatcherThreads > SHARD_MAX) {
+                    fprintf(stderr, "Invalid number of dispatcher threads. Use 1 to %d.\n", SHARD_MAX);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'v':
+                verbosity = atoi(optarg);
+                if (verbosity < LOG_QUIET || verbosity > LOG_MESSAGES) {
+                    fprintf(stderr, "Invalid verbosity. Using default: %d\n", LOG_MESSAGES);
+                    verbosity = LOG_MESSAGES;
+                }
+                break;
+            case 'D':
+                deltaTables = 1;
+                break;
+            case 'L':
+                if (parseLaunchMode(optarg, &launchMode) == -1) {
+                    fprintf(stderr, "Invalid launch mode. Use exec, pool, spawn or thread.\n");
+                    exit(EXIT_FAILURE);
+                }
+                launchModeGiven = 1;
+                break;
+            case 'e':
+                eventMode = 1;
+                break;
+            case 'S':
+                seed = (unsigned int)strtoul(optarg, NULL, 10);
+                seedGiven = 1;
+                break;
+            case 'j':
+                copyOption(jsonPath, sizeof(jsonPath), opt, optarg);
+                break;
+            case 'B':
+                copyOption(tracePath, sizeof(tracePath), opt, optarg);
+                break;
+            case 'R':
+                copyOption(replayPath, sizeof(replayPath), opt, optarg);
+                break;
+            case 'c':
+                dispatcherCpu = atoi(optarg);
+                if (dispatcherCpu < 0) {
+                    fprintf(stderr, "Invalid CPU. The dispatcher will not be pinned.\n");
+                    dispatcherCpu = -1;
+                }
+                break;
+            case 'C':
+                workerCpuList = optarg;
+                break;
+            case 'P':
+                if (parsePlacementPolicy(optarg, &placementPolicy) == -1) {
+                    fprintf(stderr, "Invalid placement. Use spread or pack.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'H':
+                hugePages = 1;
+                break;
+            case 'k':
+                copyOption(checkpointPath, sizeof(checkpointPath), opt, optarg);
+                break;
+            case 'K':
+                checkpointIntervalNs = strtoull(optarg, NULL, 10) * NANO_PER_MS;
+                if (checkpointIntervalNs == 0) {
+                    fprintf(stderr, "Invalid snapshot interval. Using default: 1000\n");
+                    checkpointIntervalNs = 1000 * NANO_PER_MS;
+                }
+                break;
+            case 'r':
+                copyOption(resumePath, sizeof(resumePath), opt, optarg);
+                break;
+            case 'w':
+                copyOption(workloadSpec, sizeof(workloadSpec), opt, optarg);
+                if (parseWorkload(optarg, &workload) == -1) {
+                    fprintf(stderr, "Invalid workload. Use kernel:amount[,kernel:amount...] with compute, stream, chase or sleep.\n");
+                    exit(EXIT_FAILURE);
+                }
+                workloadDescribe(&workload, workloadText, sizeof(workloadText));
+                break;
+            case 'A':
+                if (parseArrivalProcess(optarg, &workgenConfig) == -1) {
+                    fprintf(stderr, "Invalid arrival process. Use fixed, poisson or bursty[:size].\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'l':
+                if (parseLifetimeDistribution(optarg, &workgenConfig) == -1) {
+                    fprintf(stderr, "Invalid lifetime distribution. Use uniform, exp, pareto[:alpha > 1] or lognormal[:sigma].\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'g':
+                copyOption(arrivalTracePath, sizeof(arrivalTracePath), opt, optarg);
+                workgenConfig.arrival = ARRIVAL_TRACE;
+                break;
+            case 'o':
+                if (parseWorkerOutput(optarg, &workerOutput) == -1) {
+                    fprintf(stderr, "Invalid worker output. Use stdout, ring or off.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'W':
+                workerReports = 1;
+                break;
+            case 'u':
+                copyOption(serverPath, sizeof(serverPath), opt, optarg);
+                break;
+            case 'X':
+                copyOption(agentAddress, sizeof(agentAddress), opt, optarg);
+                break;
+            case 'N':
+                agentsWanted = atoi(optarg);
+                if (agentsWanted < 1 || agentsWanted > REMOTE_MAX_AGENTS) {
+                    fprintf(stderr, "Invalid number of worker agents. Use 1 to %d.\n", REMOTE_MAX_AGENTS);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'q': {
+                int budgetMs = atoi(optarg);
+                if (budgetMs < 0) {
+                    fprintf(stderr, "Invalid reply budget. Using default: 0 (none)\n");
+                    budgetMs = 0;
+                }
+                replyBudgetNs = (uint64_t)budgetMs * NANO_PER_MS;
+                break;
+            }
+            case 'a':
+                runTimeLimit = atoi(optarg);
+                if (runTimeLimit < 0) {
+                    fprintf(stderr, "Invalid time limit. Using default: 60\n");
+                    runTimeLimit = 60;
+                }
+                break;
+            case 'p':
+                if (parseSchedPolicy(optarg, &schedPolicy) == -1) {
+                    fprintf(stderr, "Invalid scheduling policy. Use rr, mlfq, srt or lottery.\n");
+                    exit(EXIT_FAILURE);
+                }
                 break;
             default:
                 fprintf(stderr, "Invalid option. Use -h for help.\n");
@@ -125,6 +484,98 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    // Resume: the snapshot's simulation parameters replace the command line's
+    if (resumePath[0] != '\0') {
+        if (checkpointMap(resumePath, &resume) == -1) {
+            perror("Error opening checkpoint");
+            exit(EXIT_FAILURE);
+        }
+        const CheckpointHeader *h = resume.header;
+        processLimit = h->n;
+        simultaneousMax = h->s;
+        timelimit = h->t;
+        launchInterval = h->i;
+        dispatchMode = h->dispatch == DISPATCH_PIPELINED ? DISPATCH_PIPELINED : DISPATCH_SERIAL;
+        schedPolicy = (SchedPolicy)h->policy;
+        eventMode = h->eventMode;
+        seed = h->seed;
+        seedGiven = 1;
+        snprintf(replayPath, sizeof(replayPath), "%s", h->replayPath);
+        workgenConfig = h->workgen;
+        snprintf(arrivalTracePath, sizeof(arrivalTracePath), "%s", h->arrivalTracePath);
+        snprintf(workloadSpec, sizeof(workloadSpec), "%s", h->workloadSpec);
+        if (parseWorkload(workloadSpec[0] != '\0' ? workloadSpec : "none", &workload) == -1) {
+            fprintf(stderr, "Checkpoint %s has an invalid workload\n", resumePath);
+            exit(EXIT_FAILURE);
+        }
+        workloadDescribe(&workload, workloadText, sizeof(workloadText));
+        workerOutput = (WorkerOutput)h->workerOutput;
+        workerReports = h->workerReports;
+    }
+
+    if (replayPath[0] != '\0' && arrivalTracePath[0] != '\0') {
+        fprintf(stderr, "Use either -R or -g, not both.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (serverPath[0] != '\0' && (resumePath[0] != '\0' || checkpointPath[0] != '\0' || replayPath[0] != '\0' ||
+                                  arrivalTracePath[0] != '\0' || tracePath[0] != '\0')) {
+        fprintf(stderr, "Serving jobs (-u) cannot be combined with -r, -k, -R, -g or -B.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (dispatcherThreads > 1 && dispatchMode != DISPATCH_PIPELINED) {
+        fprintf(stderr, "Dispatcher threads (-m) need pipelined dispatch (-d pipelined).\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // With -T sock the worker agents start and run every worker
+    if (transport.kind == TRANSPORT_SOCK) {
+        if (launchMode == LAUNCH_THREAD || dispatcherThreads > 1) {
+            fprintf(stderr, "Worker agents (-T sock) cannot run thread workers (-L thread) or use dispatcher threads (-m).\n");
+            exit(EXIT_FAILURE);
+        }
+        launchMode = LAUNCH_REMOTE;
+    }
+
+    // A server keeps one warm worker parked per entry between jobs
+    if (serverPath[0] != '\0' && !launchModeGiven && transport.kind != TRANSPORT_SOCK) {
+        launchMode = LAUNCH_POOL;
+    }
+
+    simultaneousLimit = simultaneousMax;
+
+    // An arrival trace runs to its end unless -n caps it
+    if (arrivalTracePath[0] != '\0' && !processLimitGiven && resume.header == NULL) {
+        processLimit = INT_MAX;
+    }
+    workgenConfig.intervalNs = (uint64_t)launchInterval * NANO_PER_MS;
+    workgenConfig.maxLifetimeNs = (uint64_t)timelimit * NANO_PER_SEC;
+    workgenDescribe(&workgenConfig, arrivalTracePath, workgenText, sizeof(workgenText));
+
+    // Replay: the recorded launches replace -n, -t and -i
+    if (replayPath[0] != '\0') {
+        if (traceMap(replayPath, &replay) == -1) {
+            perror("Error opening replay trace");
+            exit(EXIT_FAILURE);
+        }
+        processLimit = 0;
+        for (size_t r = 0; r < replay.count; r++) {
+            if (replay.records[r].type == TRACE_LAUNCH) {
+                processLimit++;
+            }
+        }
+        if (processLimit == 0) {
+            fprintf(stderr, "Replay trace %s records no launches\n", replayPath);
+            traceUnmap(&replay);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (placementInit(dispatcherCpu, workerCpuList, placementPolicy) == -1) {
+        perror("Invalid CPU placement (-c/-C)");
+        exit(EXIT_FAILURE);
+    }
+    placementDescribe(placement, sizeof(placement));
+
     // Open log file
     logfile = fopen(logfileName, "w");
     if (logfile == NULL) {
@@ -132,412 +583,1855 @@ int main(int argc, char *argv[]) {
         exit(EXIT_FAILURE);
     }
 
+    // Formatting and writes happen on the background logging thread
+    if (loggerStart(logfile, verbosity) == -1) {
+        perror("loggerStart");
+        fclose(logfile);
+        exit(EXIT_FAILURE);
+    }
+
     // Set up signal handlers for proper cleanup
     signal(SIGINT, sigintHandler);
     signal(SIGALRM, timeoutHandler);
 
-    // Set 60-second timeout
-    alarm(60);
+    // Give up after the wall-clock time limit (-a); a served job's starts with the job
+    if (runTimeLimit > 0 && serverPath[0] == '\0') {
+        alarm(runTimeLimit);
+    }
 
-    // Create shared memory for system clock
-    key_t key = ftok(".", SHM_KEY);
-    if (key == -1) {
-        perror("ftok");
+    // Collect child exits as they happen (SIGCHLD + epoll)
+    if (reaperInit(interruptReceive) == -1) {
+        perror("reaperInit");
         cleanup();
         exit(EXIT_FAILURE);
     }
 
-    shmid = shmget(key, sizeof(SystemClock), IPC_CREAT | 0666);
-    if (shmid == -1) {
-        perror("shmget");
+    // Create the control region: clock, control lines, mailboxes, statistics
+    if (regionCreate(&region, simultaneousMax, hugePages) == -1) {
+        perror("Error creating control region");
         cleanup();
         exit(EXIT_FAILURE);
     }
-    // Attach to shared memory
-    systemClock = (SystemClock *)shmat(shmid, NULL, 0);
-    if (systemClock == (void *)-1) {
-        perror("shmat");
-        cleanup();
-        exit(EXIT_FAILURE);
+    systemClock = region.clock;
+
+    // Workers read their output mode from the region; ring records would
+    // only be discarded below -v 2, and agents keep their rings to themselves
+    if (workerOutput == WORKER_OUTPUT_RING && (!loggerEnabled(LOG_MESSAGES) || transport.kind == TRANSPORT_SOCK)) {
+        workerOutput = WORKER_OUTPUT_OFF;
+    }
+    region.header->workerOutput = workerOutput;
+    if (transport.kind == TRANSPORT_SOCK) {
+        workerReports = 0;
     }
+    region.header->workerReports = workerReports;
 
     // Initialize system clock
-    systemClock->seconds = 0;
-    systemClock->nanoseconds = 0;
+    clockSet(systemClock, 0);
 
     // Create message queue
-    key_t msgKey = ftok(".", MSG_KEY);
-    if (msgKey == -1) {
-        perror("ftok");
+    msgqid = msgget(IPC_PRIVATE, IPC_CREAT | 0600);
+    if (msgqid == -1) {
+        perror("msgget");
         cleanup();
         exit(EXIT_FAILURE);
     }
+    transport.msgqid = msgqid;
 
-    msgqid = msgget(msgKey, IPC_CREAT | 0666);
-    if (msgqid == -1) {
-        perror("msgget");
+    // Thread workers always use the mailboxes; they share oss's address space
+    if (launchMode == LAUNCH_THREAD) {
+        transport.kind = TRANSPORT_SHM;
+    }
+    if (transport.kind == TRANSPORT_SHM) {
+        transport.mailboxes = region.mailboxes;
+    }
+    transport.shards = dispatcherThreads;
+
+    // Wait for the worker agents; they run the workers of -T sock
+    if (transport.kind == TRANSPORT_SOCK) {
+        printf("OSS: Waiting for %d worker agent(s) on %s\n", agentsWanted, agentAddress);
+        fflush(stdout);
+        if (remoteStart(agentAddress, agentsWanted, simultaneousMax, workerOutput, workloadSpec, systemClock,
+                        reaperReportExit, &stopSignal) == -1) {
+            if (stopSignal != 0) {
+                stopRun(stopSignal);
+            }
+            perror("Error starting worker agents");
+            cleanup();
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Allocate and initialize process table
+    if (pcbTableInit(&processTable, PCB_TABLE_INITIAL, simultaneousMax) == -1) {
+        perror("malloc");
         cleanup();
         exit(EXIT_FAILURE);
     }
 
-    // Allocate and initialize process table
-    processTable = (struct PCB *)malloc(MAX_PROCESSES * sizeof(struct PCB));
-    if (processTable == NULL) {
+    // Live per-entry statistics for ossstat
+    statsInit(region.stats, simultaneousMax, launchMode != LAUNCH_THREAD && launchMode != LAUNCH_REMOTE);
+
+    if (schedInit(schedPolicy, &processTable, &lotteryRng) == -1) {
         perror("malloc");
         cleanup();
         exit(EXIT_FAILURE);
     }
 
-    // Initialize process table
-    for (int i = 0; i < MAX_PROCESSES; i++) {
-        processTable[i].occupied = 0;
-        processTable[i].pid = 0;
-        processTable[i].startSeconds = 0;
-        processTable[i].startNano = 0;
-        processTable[i].messagesSent = 0;
-        childPIDs[i] = 0;
+    if (eventMode && eventQueueInit(&events, EVENT_CHILD + simultaneousMax) == -1) {
+        perror("malloc");
+        cleanup();
+        exit(EXIT_FAILURE);
     }
 
-    // Seed random number generator
-    srand(time(NULL));
+    pendingSlots = (int *)malloc(simultaneousMax * sizeof(int));
+    slowSlots = (int *)malloc(simultaneousMax * sizeof(int));
+    exitedSlots = (int *)malloc(simultaneousMax * sizeof(int));
+    checkpointEntries = malloc(simultaneousMax * sizeof(CheckpointEntry));
+    checkpointOrder = malloc(simultaneousMax * sizeof(int));
+    if (pendingSlots == NULL || slowSlots == NULL || exitedSlots == NULL || checkpointEntries == NULL || checkpointOrder == NULL) {
+        perror("malloc");
+        cleanup();
+        exit(EXIT_FAILURE);
+    }
 
-    // Main execution loop
-    int processCount = 0;
-    int nextChild = -1;
-    unsigned int lastLaunchTime = 0;
-    unsigned int lastDisplayTime = 0;
+    // Dispatcher threads, each with its own reply channel (-m)
+    if (dispatcherThreads > 1) {
+        shardJobs = malloc(simultaneousMax * sizeof(ShardJob));
+        if (shardJobs == NULL || shardsStart(dispatcherThreads, &transport, getpid(), simultaneousMax, replyBudgetNs) == -1) {
+            perror("Error starting dispatcher threads");
+            cleanup();
+            exit(EXIT_FAILURE);
+        }
+    }
+    sendWindow = transportSendWindow(&transport);
 
-    fprintf(stdout, "OSS PID:%d starting with parameters: n=%d, s=%d, t=%d, i=%d\n",
-            getpid(), processLimit, simultaneousMax, timelimit, launchInterval);
-    fprintf(logfile, "OSS PID:%d starting with parameters: n=%d, s=%d, t=%d, i=%d\n",
-            getpid(), processLimit, simultaneousMax, timelimit, launchInterval);
+    // Pin the dispatcher after the log writer and dispatcher threads have
+    // started, so they keep the CPUs oss started with instead of sharing its one
+    if (placementPinDispatcher() == -1) {
+        perror("sched_setaffinity");
+        cleanup();
+        exit(EXIT_FAILURE);
+    }
 
-    // Main loop: Continue until all processes have been launched and completed
-    while (totalProcesses < processLimit || countActiveChildren() > 0) {
-        // Count number of active children
-        int activeChildren = countActiveChildren();
+    // Take jobs from clients instead of the command line (-u)
+    if (serverPath[0] != '\0' && serverListen(serverPath) == -1) {
+        perror("Error serving jobs");
+        cleanup();
+        exit(EXIT_FAILURE);
+    }
 
-        // Increment the clock
-        incrementClock(activeChildren > 0 ? activeChildren : 1);
+    // Set up the launcher and park the first pre-forked workers (-L pool);
+    // a server keeps one parked on every entry for the jobs to come
+    if (launcherInit(launchMode, &transport, &region, simultaneousMax) == -1) {
+        cleanup();
+        exit(EXIT_FAILURE);
+    }
+    if (workloadActive(&workload)) {
+        launcherSetWorkload(workloadSpec, &workload);
+    }
+    for (int i = 0; i < simultaneousMax && (i < processLimit || serverPath[0] != '\0'); i++) {
+        if (launcherPrepare(i) == -1) {
+            perror("launcherPrepare");
+        }
+    }
 
-        // Check if it's time to launch a new process
-        unsigned int currentTimeMs = (systemClock->seconds * 1000) + (systemClock->nanoseconds / 1000000);
-        if (totalProcesses < processLimit && activeChildren < simultaneousMax && 
-            (currentTimeMs - lastLaunchTime) >= (unsigned int)launchInterval) {
+    // Serve jobs until a client or a signal stops oss (-u), or run the one simulation
+    if (serverPath[0] != '\0') {
+        serveJobs(timelimit, launchInterval);
+    } else {
+        runSimulation(timelimit, launchInterval, NULL);
+    }
 
-            int newChildIndex = launchChild(timelimit, &processCount);
-            if (newChildIndex >= 0) {
-                lastLaunchTime = currentTimeMs;
-                displayProcessTable();
-            }
-        }
+    // Cleanup and exit
+    cleanup();
+    return EXIT_SUCCESS;
+}
 
-        // Send message to next child if any are active
-        if (activeChildren > 0) {
-            nextChild = findNextChildIndex(nextChild);
-            if (nextChild >= 0) {
-                // Send message to this child
-                Message msg;
-                msg.mtype = processTable[nextChild].pid;  // Use child PID as message type
-                msg.status = 1;  // 1 = continue
-
-                fprintf(stdout, "OSS: Sending message to worker %d PID %d at time %d:%d\n",
-                        nextChild, processTable[nextChild].pid, systemClock->seconds, systemClock->nanoseconds);
-                fprintf(logfile, "OSS: Sending message to worker %d PID %d at time %d:%d\n",
-                        nextChild, processTable[nextChild].pid, systemClock->seconds, systemClock->nanoseconds);
-
-                if (msgsnd(msgqid, &msg, sizeof(msg.status), 0) == -1) {
-                    perror("msgsnd");
-                    // Child may have terminated, check
-                    int status;
-                    pid_t result = waitpid(processTable[nextChild].pid, &status, WNOHANG);
-                    if (result > 0) {
-                        fprintf(stdout, "OSS: Worker %d PID %d has terminated unexpectedly\n",
-                                nextChild, processTable[nextChild].pid);
-                        fprintf(logfile, "OSS: Worker %d PID %d has terminated unexpectedly\n",
-                                nextChild, processTable[nextChild].pid);
-                        processTable[nextChild].occupied = 0;
-                        childPIDs[nextChild] = 0;
-                        continue;
-                    }
-                }
+/**
+ * Run one simulation from launch to final statistics: the command line's,
+ * or a job a client sent (-u)
+ * @param client Where the job's client wants the statistics, NULL for none
+ */
+void runSimulation(int timelimit, int launchInterval, FILE *client) {
+    // Seed random number generator; -S makes runs reproducible
+    if (!seedGiven) {
+        seed = (unsigned int)time(NULL);
+    }
 
-                processTable[nextChild].messagesSent++;
-                totalMessages++;
+    // A resumed run continues the snapshot's generators and trace position
+    rngSeed(&lotteryRng, ~(uint64_t)seed);
+    if (resume.header != NULL) {
+        lotteryRng = resume.header->lottery;
+    }
+    int workgenStatus = resume.header != NULL ?
+        workgenRestore(&workgen, &workgenConfig, arrivalTracePath, &resume.header->generator) :
+        workgenInit(&workgen, &workgenConfig, arrivalTracePath, seed);
+    if (workgenStatus == -1) {
+        if (workgen.state.traceLine > 0) {
+            fprintf(stderr, "Arrival trace %s, line %llu: ", arrivalTracePath,
+                    (unsigned long long)workgen.state.traceLine);
+        }
+        perror("Error reading arrival trace");
+        cleanup();
+        exit(EXIT_FAILURE);
+    }
+    latencyReset(&roundTrip);
 
-                // Receive message from child
-                Message response;
-                if (msgrcv(msgqid, &response, sizeof(response.status), getpid(), 0) == -1) {
-                    perror("msgrcv");
-                    continue;
-                }
+    if (tracePath[0] != '\0' &&
+        traceOpen(tracePath, processLimit, simultaneousMax, timelimit, launchInterval, seed) == -1) {
+        perror("Error opening trace file");
+        cleanup();
+        exit(EXIT_FAILURE);
+    }
 
-                fprintf(stdout, "OSS: Receiving message from worker %d PID %d at time %d:%d\n",
-                        nextChild, processTable[nextChild].pid, systemClock->seconds, systemClock->nanoseconds);
-                fprintf(logfile, "OSS: Receiving message from worker %d PID %d at time %d:%d\n",
-                        nextChild, processTable[nextChild].pid, systemClock->seconds, systemClock->nanoseconds);
+    // Main execution loop
+    int processCount = 0;
+    uint64_t lastLaunchTime = 0;
+    uint64_t lastDisplayTime = 0;
+    uint64_t nextCheckpointNs = monotonicNs() + checkpointIntervalNs;
+
+    // Resume: restore the clock and counters, then relaunch the running
+    // workers with their remaining lifetimes in their dispatch order
+    if (resume.header != NULL) {
+        const CheckpointHeader *h = resume.header;
+        clockSet(systemClock, h->clockNs);
+        totalProcesses = processCount = h->totalProcesses;
+        totalMessages = h->totalMessages;
+        skippedPasses = h->skippedPasses;
+        creditedQuanta = h->creditedQuanta;
+        lastLaunchTime = h->lastLaunchNs;
+        lastDisplayTime = h->lastDisplayNs;
+        replayNext = h->replayNext;
+        schedResume(&h->sched, h->lastBoostNs);
+        for (int k = 0; k < h->count; k++) {
+            if (resumeChild(&resume.entries[k]) == -1) {
+                cleanup();
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
 
-                // Check if child is terminating
-                if (response.status == 0) {
-                    fprintf(stdout, "OSS: Worker %d PID %d is planning to terminate\n",
-                            nextChild, processTable[nextChild].pid);
-                    fprintf(logfile, "OSS: Worker %d PID %d is planning to terminate\n",
-                            nextChild, processTable[nextChild].pid);
+    logText(LOG_QUIET, "OSS PID:%d starting with parameters: n=%d, s=%d, t=%d, i=%d, T=%s, d=%s, L=%s, p=%s, e=%d, S=%u\n",
+            getpid(), processLimit, simultaneousLimit, timelimit, launchInterval,
+            transportName(transport.kind), dispatchModeName(), launchModeName(launchMode),
+            schedPolicyName(schedPolicy), eventMode, seed);
+    if (dispatchMode == DISPATCH_PIPELINED && schedPolicy != SCHED_RR) {
+        logText(LOG_QUIET, "OSS: -p %s does not apply: pipelined rounds dispatch every worker\n",
+                schedPolicyName(schedPolicy));
+    }
+    logText(LOG_QUIET, "OSS: CPU placement: %s\n", placement);
+    if (dispatcherThreads > 1) {
+        logText(LOG_QUIET, "OSS: Dispatcher threads: %d, %s\n", dispatcherThreads,
+                dispatcherCpu >= 0 || placementPolicy == PLACE_PACK ? "on the CPUs oss started with (only the main thread is pinned)"
+                                                                     : "placed by the kernel");
+    }
+    if (replyBudgetNs != 0) {
+        logText(LOG_QUIET, "OSS: Reply budget: %llu ms per quantum\n", (unsigned long long)(replyBudgetNs / NANO_PER_MS));
+    }
+    logText(LOG_QUIET, "OSS: Workload per quantum: %s\n", workloadText);
+    if (replay.header == NULL) {
+        logText(LOG_QUIET, "OSS: Arrivals: %s\n", workgenText);
+    }
+    if (region.name[0] != '\0') {
+        logText(LOG_QUIET, "OSS: Control region /dev/shm%s: %zu bytes, %s; message queue %d\n", region.name,
+                region.size, regionBackingName(region.header->backing), msgqid);
+    } else {
+        logText(LOG_QUIET, "OSS: Control region /proc/%d/fd/%d: %zu bytes, %s; message queue %d\n", getpid(),
+                region.fd, region.size, regionBackingName(region.header->backing), msgqid);
+    }
+    if (transport.kind == TRANSPORT_SOCK) {
+        logText(LOG_QUIET, "OSS: Worker agents: %d on %s\n", remoteAgentCount(), agentAddress);
+    }
+    if (resume.header != NULL) {
+        logText(LOG_QUIET, "OSS: Resumed %s at %llu:%09u: %d launched, %d running, %llu messages\n", resumePath,
+                CLOCK_SECONDS(resume.header->clockNs), CLOCK_NANOS(resume.header->clockNs), totalProcesses,
+                resume.header->count, (unsigned long long)totalMessages);
+    }
+    if (checkpointPath[0] != '\0') {
+        logText(LOG_QUIET, "OSS: Snapshotting to %s every %llu ms\n", checkpointPath,
+                (unsigned long long)(checkpointIntervalNs / NANO_PER_MS));
+    }
+    if (replay.header != NULL) {
+        logText(LOG_QUIET, "OSS: Replaying %d launches from %s (recorded with n=%d, s=%d, t=%d, i=%d, S=%u)\n",
+                processLimit, replayPath, replay.header->n, replay.header->s, replay.header->t,
+                replay.header->i, replay.header->seed);
+    }
 
-                    // Wait for child to actually terminate
-                    waitpid(processTable[nextChild].pid, NULL, 0);
+    // Wall-clock start of the run, used for the message rate
+    struct timespec runStart, runEnd;
+    clock_gettime(CLOCK_MONOTONIC, &runStart);
 
-                    // Update process table
-                    processTable[nextChild].occupied = 0;
-                    childPIDs[nextChild] = 0;
-                }
-            }
+    // Main loop: Continue until all processes have been launched and completed
+    while (totalProcesses < processLimit || processTable.activeCount > 0) {
+        // Retire workers that exited since the last pass
+        if (reaperPending()) {
+            reaperPoll(0, onChildExit);
+            retireExited();
         }
 
-        // Check if it's time to display the process table (every 0.5 seconds)
-        unsigned int halfSecondInterval = 500; // 500ms = 0.5s
-        if ((currentTimeMs - lastDisplayTime) >= halfSecondInterval) {
-            displayProcessTable();
-            lastDisplayTime = currentTimeMs;
+        // Slow workers get no quanta; take their overdue replies as they come
+        // in, waiting for one when nothing else could run
+        if (slowCount > 0) {
+            takeLateReplies(slowCount == processTable.activeCount);
         }
-    }
 
-    // Final statistics
-    fprintf(stdout, "\n--- Final Statistics ---\n");
-    fprintf(stdout, "Total processes launched: %d\n", totalProcesses);
-    fprintf(stdout, "Total messages sent: %d\n", totalMessages);
+        // Nothing can run once every worker agent is gone
+        if (transport.kind == TRANSPORT_SOCK && remoteAgentsConnected() == 0) {
+            fprintf(stderr, "OSS: No worker agent is left. Cleaning up and terminating...\n");
+            cleanup();
+            exit(EXIT_FAILURE);
+        }
 
-    fprintf(logfile, "\n--- Final Statistics ---\n");
-    fprintf(logfile, "Total processes launched: %d\n", totalProcesses);
-    fprintf(logfile, "Total messages sent: %d\n", totalMessages);
+        // The arrival trace has ended: nothing more to launch
+        if (!workgen.state.pending && processLimit > totalProcesses) {
+            processLimit = totalProcesses;
+        }
 
-    // Cleanup and exit
-    cleanup();
-    return EXIT_SUCCESS;
-}
+        // A served job out of time launches nothing more; its workers still
+        // run out their lifetimes, so the server keeps its warm workers
+        if (stopSignal == SIGALRM && serverPath[0] != '\0') {
+            stopSignal = 0;
+            jobTimedOut = 1;
+            processLimit = totalProcesses;
+            logText(LOG_QUIET, "OSS: Job out of time (%d seconds); launching no more workers\n", runTimeLimit);
+        }
 
-/**
- * Launch a new child worker process
- * @param timelimit Upper bound for child runtime
- * @param processCount Pointer to current process count
- * @return Index of the new child in the process table, or -1 on failure
- */
-int launchChild(int timelimit, int *processCount) {
-    // Find free slot in process table
-    int freeIndex = -1;
-    for (int i = 0; i < MAX_PROCESSES; i++) {
-        if (processTable[i].occupied == 0) {
-            freeIndex = i;
-            break;
+        // Snapshot at a pass boundary, where no reply is outstanding
+        if (stopSignal != 0) {
+            if (checkpointPath[0] != '\0') {
+                saveCheckpoint(timelimit, launchInterval, lastLaunchTime, lastDisplayTime);
+            }
+            stopRun(stopSignal);
+        }
+        if (checkpointPath[0] != '\0' && monotonicNs() >= nextCheckpointNs) {
+            saveCheckpoint(timelimit, launchInterval, lastLaunchTime, lastDisplayTime);
+            nextCheckpointNs = monotonicNs() + checkpointIntervalNs;
         }
-    }
 
-    if (freeIndex == -1) {
-        fprintf(stderr, "Error: No free slots in process table\n");
-        return -1;
-    }
+        statsTotals(totalProcesses, totalMessages, processTable.activeCount);
 
-    // Determine random lifetime for child (1 to timelimit seconds)
-    int childSeconds = (rand() % timelimit) + 1;
-    int childNano = rand() % NANO_PER_SEC; // Random nanoseconds
+        // Skip passes that would only advance the clock and message counts
+        if (eventMode) {
+            fastForward(lastLaunchTime, lastDisplayTime);
+        }
 
-    // Record process start time
-    processTable[freeIndex].startSeconds = systemClock->seconds;
-    processTable[freeIndex].startNano = systemClock->nanoseconds;
+        // Count number of active children
+        int activeChildren = processTable.activeCount;
+
+        // Each child's quantum is its share of a 250ms pass over all children
+        quantumNs = (250 * NANO_PER_MS) / (activeChildren > 0 ? activeChildren : 1);
+
+        // Increment the clock. Serial dispatch spends 250ms per pass over the
+        // children one quantum at a time; a pipelined round covers the whole
+        // pass at once and so advances the full 250ms before sending.
+        if (dispatchMode == DISPATCH_PIPELINED) {
+            incrementClock(1);
+        } else {
+            incrementClock(activeChildren > 0 ? activeChildren : 1);
+        }
 
-    // Fork new process
-    pid_t childPid = fork();
+        // Check if it's time to launch a new process
+        uint64_t currentTime = clockRead(systemClock);
+        if (totalProcesses < processLimit && activeChildren < simultaneousLimit &&
+            currentTime >= nextLaunchTime(lastLaunchTime)) {
 
-    if (childPid == -1) {
-        perror("fork");
-        return -1;
-    } else if (childPid == 0) {
-        // Child process
+            int newChildIndex = launchChild(&processCount);
+            if (newChildIndex >= 0) {
+                lastLaunchTime = currentTime;
+                displayProcessTable();
+            }
+        }
 
-        // Set up signal handler for parent termination
-        signal(SIGTERM, SIG_DFL);  // Default handler for SIGTERM
+        // Dispatch one child, or every child in pipelined mode
+        if (activeChildren > 0) {
+            if (dispatchMode == DISPATCH_PIPELINED) {
+                dispatchRound();
+            } else {
+                int nextChild = schedNext(currentTime);
+                if (nextChild >= 0) {
+                    dispatchOne(nextChild);
+                }
+            }
+        }
 
-        char secStr[20], nanoStr[20];
-        sprintf(secStr, "%d", childSeconds);
-        sprintf(nanoStr, "%d", childNano);
+        // Check if it's time to display the process table (every 0.5 seconds)
+        uint64_t halfSecondInterval = 500 * NANO_PER_MS; // 500ms = 0.5s
+        if ((currentTime - lastDisplayTime) >= halfSecondInterval) {
+            displayProcessTable();
+            lastDisplayTime = currentTime;
+        }
+    }
 
-        // Execute worker with arguments
-        execl("./worker", "worker", secStr, nanoStr, NULL);
+    statsTotals(totalProcesses, totalMessages, processTable.activeCount);
+    statsFinish();
 
-        // If execl fails
-        perror("execl");
-        exit(EXIT_FAILURE);
-    } else {
-        // Parent process - update process table
-        processTable[freeIndex].occupied = 1;
-        processTable[freeIndex].pid = childPid;
-        processTable[freeIndex].messagesSent = 0;
-        childPIDs[freeIndex] = childPid;
+    // Message rate over the whole run (each message is one oss <-> worker round trip)
+    clock_gettime(CLOCK_MONOTONIC, &runEnd);
+    double elapsed = (runEnd.tv_sec - runStart.tv_sec) + (runEnd.tv_nsec - runStart.tv_nsec) / 1e9;
+    double messageRate = elapsed > 0 ? totalMessages / elapsed : 0.0;
 
-        (*processCount)++;
-        totalProcesses++;
+    double launchLatencyAvgUs = launchLatencySamples > 0 ?
+        launchLatencyTotalNs / 1e3 / launchLatencySamples : 0.0;
 
-        fprintf(stdout, "OSS: Launching worker process PID %d (will run for %d sec, %d nano)\n",
-                childPid, childSeconds, childNano);
-        fprintf(logfile, "OSS: Launching worker process PID %d (will run for %d sec, %d nano)\n",
-                childPid, childSeconds, childNano);
+    // Flush the logging thread before the synchronous statistics
+    loggerStop();
 
-        return freeIndex;
+    unsigned long long workerDropped = 0, reportDropped = 0;
+    for (int i = 0; i < simultaneousMax; i++) {
+        workerDropped += atomic_load(&region.logs[i].dropped);
+        reportDropped += atomic_load(&region.payloads[i].dropped);
     }
-}
-
-/**
- * Find the next child to send a message to
- * @param currentChild Index of the current child
- * @return Index of the next child, or -1 if none available
- */
-int findNextChildIndex(int currentChild) {
-    int startIdx = (currentChild + 1) % MAX_PROCESSES;
-    int idx = startIdx;
 
-    do {
-        if (processTable[idx].occupied) {
-            return idx;
+    // Average wall time of each kernel per reported quantum
+    char kernelTimes[256] = "";
+    size_t kernelUsed = 0;
+    for (int k = 0; k < KERNEL_COUNT && kernelUsed < sizeof(kernelTimes); k++) {
+        if (reportKernelSamples[k] > 0) {
+            kernelUsed += snprintf(kernelTimes + kernelUsed, sizeof(kernelTimes) - kernelUsed, " (%s %.1f us)",
+                                   workloadKernelName(k), reportKernelNs[k] / 1e3 / reportKernelSamples[k]);
         }
-        idx = (idx + 1) % MAX_PROCESSES;
-    } while (idx != startIdx);
+    }
 
-    return -1;  // No active children
-}
+    // Final statistics, also sent to a client that asked for the job (-u)
+    printFinalStats(stdout, messageRate, launchLatencyAvgUs, workerDropped, reportDropped, kernelTimes);
+    printFinalStats(logfile, messageRate, launchLatencyAvgUs, workerDropped, reportDropped, kernelTimes);
+    if (client != NULL) {
+        printFinalStats(client, messageRate, launchLatencyAvgUs, workerDropped, reportDropped, kernelTimes);
+    }
 
-/**
- * Count number of active child processes
- * @return Number of active children
- */
-int countActiveChildren() {
-    int count = 0;
-    for (int i = 0; i < MAX_PROCESSES; i++) {
-        if (processTable[i].occupied) {
-            count++;
-        }
+    if (jsonPath[0] != '\0') {
+        writeJsonStats(timelimit, launchInterval, elapsed, messageRate, launchLatencyAvgUs, reportDropped);
     }
-    return count;
 }
 
 /**
- * Increment the system clock
- * @param activeChildren Number of active children
+ * Print the final statistics of the run
+ * @param out stdout, the log file or a client's output (-u)
  */
-void incrementClock(int activeChildren) {
-    // Increment by 250ms divided by number of children
-    unsigned int incrementNano = (250 * 1000000) / activeChildren;
-
-    systemClock->nanoseconds += incrementNano;
-    if (systemClock->nanoseconds >= NANO_PER_SEC) {
-        systemClock->seconds += systemClock->nanoseconds / NANO_PER_SEC;
-        systemClock->nanoseconds %= NANO_PER_SEC;
+void printFinalStats(FILE *out, double messageRate, double launchLatencyAvgUs, unsigned long long workerDropped,
+                     unsigned long long reportDropped, const char *kernelTimes) {
+    // Average simulated turnaround, wait and response time per completed process
+    const SchedStats *sched = schedStats();
+    double completed = sched->completed > 0 ? sched->completed : 1;
+    double turnaroundS = sched->turnaroundNs / 1e9 / completed;
+    double waitS = sched->waitNs / 1e9 / completed;
+    double responseS = sched->responseNs / 1e9 / completed;
+    double reportWorkUs = reportPayloads > 0 ? reportWorkNs / 1e3 / reportPayloads : 0.0;
+
+    fprintf(out, "\n--- Final Statistics ---\n");
+    fprintf(out, "Total processes launched: %d\n", totalProcesses);
+    fprintf(out, "Total messages sent: %llu\n", (unsigned long long)totalMessages);
+    fprintf(out, "Transport: %s, messages/sec: %.1f\n", transportName(transport.kind), messageRate);
+    fprintf(out, "Log records written: %llu, dropped: %llu\n",
+            (unsigned long long)loggerWritten(), (unsigned long long)loggerDropped());
+    fprintf(out, "Launch mode: %s, launch-to-first-reply latency: avg %.1f us, max %.1f us over %d launches\n",
+            launchModeName(launchMode), launchLatencyAvgUs, launchLatencyMaxNs / 1e3, launchLatencySamples);
+    fprintf(out, "Scheduler: %s, average turnaround %.3f s, wait %.3f s, response %.3f s over %d processes\n",
+            schedPolicyName(schedPolicy), turnaroundS, waitS, responseS, sched->completed);
+    fprintf(out, "Discrete-event mode: %s, passes skipped: %llu, quanta credited without a message: %llu\n",
+            eventMode ? "on" : "off", skippedPasses, creditedQuanta);
+    fprintf(out, "Round trip: p50 %.1f us, p99 %.1f us, max %.1f us over %llu messages\n",
+            latencyPercentile(&roundTrip, 50) / 1e3, latencyPercentile(&roundTrip, 99) / 1e3,
+            roundTrip.maxNs / 1e3, (unsigned long long)roundTrip.count);
+    fprintf(out, "Worker output: %s, ring records merged: %llu, dropped: %llu\n",
+            workerOutputName(workerOutput), workerRecords, workerDropped);
+    fprintf(out, "Dispatcher threads: %d, quanta sent by a thread other than their owner: %llu\n",
+            dispatcherThreads, (unsigned long long)shardsSteals());
+    fprintf(out, "Worker reports: %s, payloads: %llu (%llu bytes), dropped: %llu, rejected: %llu, "
+            "with errors: %llu, workload avg %.1f us%s\n",
+            workerReports ? "on" : "off", reportPayloads, reportBytes, reportDropped, reportRejected,
+            reportErrors, reportWorkUs, kernelTimes);
+    if (replyBudgetNs != 0) {
+        fprintf(out, "Reply budget: %llu ms, timeouts: %llu, workers killed: %llu, late replies taken: %llu\n",
+                (unsigned long long)(replyBudgetNs / NANO_PER_MS), replyTimeouts, workersKilled, lateReplies);
+    }
+    if (transport.kind == TRANSPORT_SOCK) {
+        fprintf(out, "Socket hops: oss<->agent p50 %.1f us, p99 %.1f us; agent<->worker p50 %.1f us, p99 %.1f us over %llu replies\n",
+                latencyPercentile(remoteNetworkHop(), 50) / 1e3, latencyPercentile(remoteNetworkHop(), 99) / 1e3,
+                latencyPercentile(remoteAgentHop(), 50) / 1e3, latencyPercentile(remoteAgentHop(), 99) / 1e3,
+                (unsigned long long)remoteAgentHop()->count);
     }
 }
 
 /**
- * Display the current process table
+ * Serve jobs from ossctl clients on the Unix socket (-u), one after another,
+ * until a client asks oss to stop or SIGINT arrives. The control region,
+ * message queue, launcher and parked workers stay up between jobs; clients
+ * that connect while a job runs wait their turn.
+ * @param timelimit -t of the command line, for jobs that do not give one
+ * @param launchInterval -i of the command line, likewise
  */
-void displayProcessTable() {
-    fprintf(stdout, "OSS PID:%d SysClockS: %d SysclockNano: %d\n",
-            getpid(), systemClock->seconds, systemClock->nanoseconds);
-    fprintf(stdout, "Process Table:\n");
-    fprintf(stdout, "Entry\tOccupied\tPID\tStartS\tStartN\tMessagesSent\n");
+void serveJobs(int timelimit, int launchInterval) {
+    int jobs = 0;
+    int defaultProcesses = processLimit;
+
+    printf("OSS: Serving jobs on %s (at most %d simultaneous processes per job)\n", serverPath, simultaneousMax);
+    fflush(stdout);
+
+    while (stopSignal == 0) {
+        // Retire parked workers that died between jobs
+        if (reaperPending()) {
+            reaperPoll(0, onChildExit);
+            retireExited();
+        }
+
+        ServerRequest request;
+        if (serverAccept(&request, SERVER_POLL_MS) == -1) {
+            if (errno != EAGAIN && errno != EINTR) {
+                perror("Error accepting a job");
+                break;
+            }
+            continue;
+        }
+        if (request.type == SERVER_STOP) {
+            fprintf(serverOutput(), "OSS: Stopping after %d job(s)\n", jobs);
+            serverFinish(0);
+            break;
+        }
+        if (request.simultaneous > simultaneousMax) {
+            char reason[96];
+            snprintf(reason, sizeof(reason), "-s %d is more than the %d this oss serves", request.simultaneous,
+                     simultaneousMax);
+            serverReject(reason);
+            continue;
+        }
+
+        // Zeros take the command line's values
+        if (request.processes == 0) {
+            request.processes = defaultProcesses;
+        }
+        if (request.timelimit == 0) {
+            request.timelimit = timelimit;
+        }
+        if (request.launchInterval == 0) {
+            request.launchInterval = launchInterval;
+        }
+        if (request.simultaneous == 0) {
+            request.simultaneous = simultaneousMax;
+        }
 
-    fprintf(logfile, "OSS PID:%d SysClockS: %d SysclockNano: %d\n",
-            getpid(), systemClock->seconds, systemClock->nanoseconds);
-    fprintf(logfile, "Process Table:\n");
-    fprintf(logfile, "Entry\tOccupied\tPID\tStartS\tStartN\tMessagesSent\n");
+        jobs++;
+        int jobTimelimit, jobInterval;
+        startJob(&request, &jobTimelimit, &jobInterval);
+        logText(LOG_QUIET, "OSS: Job %d\n", jobs);
+        runSimulation(jobTimelimit, jobInterval, serverOutput());
+        alarm(0);
+        serverFinish(jobTimedOut ? SERVER_JOB_TIMED_OUT : 0);
+    }
 
-    for (int i = 0; i < MAX_PROCESSES; i++) {
-        fprintf(stdout, "%d\t%d\t\t%d\t%d\t%d\t%d\n", i, processTable[i].occupied,
-                processTable[i].pid, processTable[i].startSeconds,
-                processTable[i].startNano, processTable[i].messagesSent);
-        fprintf(logfile, "%d\t%d\t\t%d\t%d\t%d\t%d\n", i, processTable[i].occupied,
-                processTable[i].pid, processTable[i].startSeconds,
-                processTable[i].startNano, processTable[i].messagesSent);
+    if (stopSignal == SIGINT) {
+        fprintf(stderr, "\nCaught SIGINT. Stopping after %d job(s)...\n", jobs);
     }
-    fprintf(stdout, "\n");
-    fprintf(logfile, "\n");
 }
 
 /**
- * Signal handler for SIGINT (Ctrl+C)
+ * Reset the per-run state for a served job: its parameters, the clock,
+ * counters, scheduler, statistics segment and logger. What the jobs share
+ * (region, queue, launcher, parked workers, agents) is left as it is.
+ * @param timelimit Set to the job's -t
+ * @param launchInterval Set to the job's -i
  */
-void sigintHandler(int sig) {
-    fprintf(stderr, "\nCaught SIGINT. Cleaning up and terminating...\n");
-    fprintf(logfile, "\nCaught SIGINT. Cleaning up and terminating...\n");
-    fprintf(logfile, "\n--- Final Statistics at Termination ---\n");
-    fprintf(logfile, "Total processes launched: %d\n", totalProcesses);
-    fprintf(logfile, "Total messages sent: %d\n", totalMessages);
-    cleanup();
-    exit(EXIT_SUCCESS);
+void startJob(const ServerRequest *request, int *timelimit, int *launchInterval) {
+    processLimit = request->processes;
+    simultaneousLimit = request->simultaneous;
+    *timelimit = request->timelimit;
+    *launchInterval = request->launchInterval;
+
+    totalProcesses = 0;
+    totalMessages = 0;
+    launchLatencyTotalNs = 0;
+    launchLatencyMaxNs = 0;
+    launchLatencySamples = 0;
+    skippedPasses = 0;
+    creditedQuanta = 0;
+    workerRecords = 0;
+    reportPayloads = reportBytes = reportRejected = reportErrors = 0;
+    replyTimeouts = workersKilled = lateReplies = 0;
+    reportWorkNs = 0;
+    memset(reportKernelNs, 0, sizeof(reportKernelNs));
+    memset(reportKernelSamples, 0, sizeof(reportKernelSamples));
+    for (int i = 0; i < simultaneousMax; i++) {
+        atomic_store(&region.logs[i].dropped, 0);
+        atomic_store(&region.payloads[i].dropped, 0);
+    }
+    jobTimedOut = 0;
+
+    clockSet(systemClock, 0);
+    statsInit(region.stats, simultaneousMax, launchMode != LAUNCH_THREAD && launchMode != LAUNCH_REMOTE);
+    schedFree();
+    if (eventMode) {
+        eventQueueFree(&events);
+    }
+    if (schedInit(schedPolicy, &processTable, &lotteryRng) == -1 ||
+        (eventMode && eventQueueInit(&events, EVENT_CHILD + simultaneousMax) == -1)) {
+        perror("malloc");
+        cleanup();
+        exit(EXIT_FAILURE);
+    }
+
+    workgenClose(&workgen);
+    workgenConfig.intervalNs = (uint64_t)*launchInterval * NANO_PER_MS;
+    workgenConfig.maxLifetimeNs = (uint64_t)*timelimit * NANO_PER_SEC;
+    workgenDescribe(&workgenConfig, arrivalTracePath, workgenText, sizeof(workgenText));
+
+    if (loggerStart(logfile, verbosity) == -1) {
+        perror("loggerStart");
+        cleanup();
+        exit(EXIT_FAILURE);
+    }
+    if (runTimeLimit > 0) {
+        alarm(runTimeLimit);
+    }
+}
+
+/**
+ * Launch a new child worker process
+ * @param processCount Pointer to current process count
+ * @return Index of the new child in the process table, or -1 on failure
+ */
+int launchChild(int *processCount) {
+    // Take a free slot off the process table's free list
+    int freeIndex = pcbReserve(&processTable);
+
+    if (freeIndex == -1) {
+        fprintf(stderr, "Error: No free slots in process table\n");
+        return -1;
+    }
+
+    // Take the generator's lifetime for this arrival, or the recorded one
+    // when replaying
+    uint64_t lifetimeNs = workgen.state.lifetimeNs;
+    const TraceRecord *recorded;
+    if (replayPeekLaunch(&recorded) == 0) {
+        lifetimeNs = recorded->arg;
+    }
+    int childSeconds = (int)(lifetimeNs / NANO_PER_SEC);
+    int childNano = (int)(lifetimeNs % NANO_PER_SEC);
+
+    // Record process start time
+    uint64_t now = clockRead(systemClock);
+    processTable.pcb[freeIndex].startSeconds = CLOCK_SECONDS(now);
+    processTable.pcb[freeIndex].startNano = CLOCK_NANOS(now);
+
+    pid_t childPid = startChild(freeIndex, childSeconds, childNano);
+    if (childPid == -1) {
+        return -1;
+    }
+    if (replay.header != NULL) {
+        replayNext++;
+    } else if (workgenAdvance(&workgen) == -1) {
+        fprintf(stderr, "Arrival trace %s, line %llu: %s; no further launches\n", arrivalTracePath,
+                (unsigned long long)workgen.state.traceLine, strerror(errno));
+    }
+    statsSlotStart(freeIndex, childPid, now);
+    schedAdmit(freeIndex, now, now + (uint64_t)childSeconds * NANO_PER_SEC + childNano);
+
+    // Its deadline is only known for certain once it has read the clock and replied
+    if (eventMode) {
+        eventSchedule(&events, EVENT_CHILD + freeIndex, 0);
+    }
+
+    (*processCount)++;
+    totalProcesses++;
+
+    int cpu = placementWorkerCpu(freeIndex);
+    logEvent(LOG_LAUNCH, childPid, childSeconds, childNano, cpu, 0, 0);
+    traceEvent(TRACE_LAUNCH, freeIndex, childPid, cpu, now,
+               (uint64_t)childSeconds * NANO_PER_SEC + childNano);
+
+    return freeIndex;
+}
+
+/**
+ * Start (or, with -L pool, activate) the worker of a reserved entry and
+ * enter it into the process table
+ * @param index Entry reserved with pcbReserve; released again on failure
+ * @return PID of the worker, or -1 on failure
+ */
+pid_t startChild(int index, int childSeconds, int childNano) {
+    processTable.pcb[index].exited = 0;
+    processTable.pcb[index].slow = 0;
+    processTable.pcb[index].timeouts = 0;
+
+    // Hand the new worker an empty mailbox
+    if (transport.kind == TRANSPORT_SHM) {
+        ringReset(&transport.mailboxes->boxes[index].toWorker);
+        ringReset(&transport.mailboxes->boxes[index].toOss);
+    }
+
+    processTable.pcb[index].launchWallNs = monotonicNs();
+    pid_t childPid = launcherStart(index, childSeconds, childNano);
+    if (childPid == -1) {
+        perror("launch worker");
+        pcbUnreserve(&processTable, index);
+        return -1;
+    }
+
+    pcbActivate(&processTable, index, childPid);
+    publishEntry(index);
+    return childPid;
+}
+
+/**
+ * Relaunch a worker that was running when a checkpoint was written, with
+ * the lifetime it had left and its scheduler accounting
+ * @param saved The worker's checkpoint entry
+ * @return Index of the worker in the process table, or -1 on failure
+ */
+int resumeChild(const CheckpointEntry *saved) {
+    int index = pcbReserve(&processTable);
+    if (index == -1) {
+        fprintf(stderr, "Error: No free slots in process table\n");
+        return -1;
+    }
+
+    int childSeconds = (int)(saved->remainingNs / NANO_PER_SEC);
+    int childNano = (int)(saved->remainingNs % NANO_PER_SEC);
+    uint64_t now = clockRead(systemClock);
+    struct PCB *pcb = &processTable.pcb[index];
+    pcb->startSeconds = CLOCK_SECONDS(saved->launchNs);
+    pcb->startNano = CLOCK_NANOS(saved->launchNs);
+
+    pid_t childPid = startChild(index, childSeconds, childNano);
+    if (childPid == -1) {
+        return -1;
+    }
+    processTable.messagesSent[index] = saved->messagesSent;
+    publishEntry(index);
+    statsSlotStart(index, childPid, saved->launchNs);
+
+    pcb->launchNs = saved->launchNs;
+    pcb->deadlineNs = now + saved->remainingNs;
+    pcb->firstDispatchNs = saved->firstDispatchNs;
+    pcb->cpuNs = saved->cpuNs;
+    pcb->dispatched = saved->dispatched;
+    schedReadmit(index, saved->level);
+    if (eventMode) {
+        eventSchedule(&events, EVENT_CHILD + index, 0);
+    }
+
+    int cpu = placementWorkerCpu(index);
+    logEvent(LOG_LAUNCH, childPid, childSeconds, childNano, cpu, 0, 0);
+    traceEvent(TRACE_LAUNCH, index, childPid, cpu, now, saved->remainingNs);
+    return index;
+}
+
+/**
+ * Write a checkpoint: parameters, clock, counters, the generator state and
+ * every running worker in dispatch order with its remaining lifetime
+ */
+void saveCheckpoint(int timelimit, int launchInterval, uint64_t lastLaunchTime, uint64_t lastDisplayTime) {
+    CheckpointHeader h;
+    memset(&h, 0, sizeof(h));
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    h.wallNs = (uint64_t)ts.tv_sec * NANO_PER_SEC + ts.tv_nsec;
+
+    h.n = processLimit;
+    h.s = simultaneousMax;
+    h.t = timelimit;
+    h.i = launchInterval;
+    h.dispatch = dispatchMode;
+    h.policy = schedPolicy;
+    h.eventMode = eventMode;
+    h.seed = seed;
+    h.workgen = workgen.config;
+    snprintf(h.arrivalTracePath, sizeof(h.arrivalTracePath), "%s", arrivalTracePath);
+    snprintf(h.workloadSpec, sizeof(h.workloadSpec), "%s", workloadSpec);
+    h.workerOutput = workerOutput;
+    h.workerReports = workerReports;
+
+    uint64_t now = clockRead(systemClock);
+    h.clockNs = now;
+    h.lastLaunchNs = lastLaunchTime;
+    h.lastDisplayNs = lastDisplayTime;
+    h.totalProcesses = totalProcesses;
+    h.totalMessages = totalMessages;
+    h.skippedPasses = skippedPasses;
+    h.creditedQuanta = creditedQuanta;
+    h.sched = *schedStats();
+    h.lastBoostNs = schedLastBoostNs();
+    h.replayNext = replayNext;
+    if (replay.header != NULL) {
+        snprintf(h.replayPath, sizeof(h.replayPath), "%s", replayPath);
+    }
+    h.generator = workgen.state;
+    h.lottery = lotteryRng;
+
+    h.count = schedOrder(checkpointOrder);
+
+    // Slow entries (-q) are out of the scheduler's order but still occupied;
+    // they go last, as the lowest priority they rejoin at
+    for (int i = 0, index = processTable.ringHead; slowCount > 0 && i < processTable.activeCount; i++) {
+        int listed = 0;
+        for (int k = 0; k < h.count && !listed; k++) {
+            listed = checkpointOrder[k] == index;
+        }
+        if (processTable.pcb[index].slow && !listed) {
+            checkpointOrder[h.count++] = index;
+        }
+        index = processTable.ringNext[index];
+    }
+
+    for (int k = 0; k < h.count; k++) {
+        int index = checkpointOrder[k];
+        const struct PCB *pcb = &processTable.pcb[index];
+        CheckpointEntry *e = &checkpointEntries[k];
+        memset(e, 0, sizeof(*e));
+        e->remainingNs = pcb->deadlineNs > now ? pcb->deadlineNs - now : 0;
+        e->launchNs = pcb->launchNs;
+        e->deadlineNs = pcb->deadlineNs;
+        e->firstDispatchNs = pcb->firstDispatchNs;
+        e->cpuNs = pcb->cpuNs;
+        e->dispatched = pcb->dispatched;
+        e->level = pcb->slow ? MLFQ_LEVELS - 1 : schedLevel(index);
+        e->messagesSent = processTable.messagesSent[index];
+    }
+
+    if (checkpointWrite(checkpointPath, &h, checkpointEntries) == -1) {
+        perror("Error writing checkpoint");
+    }
+}
+
+/**
+ * Name of the dispatch mode for logs
+ */
+const char *dispatchModeName() {
+    return dispatchMode == DISPATCH_PIPELINED ? "pipelined" : "serial";
+}
+
+/**
+ * Send one quantum to a child. A full queue is waited on for at most the
+ * reply budget (-q), and a pending stop ends the wait.
+ * @param index Process table index of the child
+ * @return 0 if the message was sent, -1 if the child is gone or it could
+ *         not be sent
+ */
+int sendQuantum(int index) {
+    logEvent(LOG_SEND, index, processTable.pid[index], clockRead(systemClock), 0, 0, 0);
+    processTable.pcb[index].sentWallNs = monotonicNs();
+    uint64_t deadline = replyBudgetNs != 0 ? processTable.pcb[index].sentWallNs + replyBudgetNs : 0;
+
+    // 1 = continue; a child exit interrupts the wait too, and is collected later
+    int rc;
+    while ((rc = transportSendToWorkerUntil(&transport, index, processTable.pid[index], 1, deadline)) == -1 &&
+           errno == EINTR && stopSignal == 0) {
+    }
+    if (rc == -1 && errno == EINTR) {
+        return -1;      // Stopping; the main loop shuts down after this pass
+    }
+    if (rc == -1 && errno == ETIMEDOUT) {
+        fprintf(stderr, "OSS: Queue still full after %llu ms; PID %d misses this quantum\n",
+                (unsigned long long)(replyBudgetNs / NANO_PER_MS), processTable.pid[index]);
+        return -1;
+    }
+    if (rc == -1) {
+        perror("send to worker");
+        // Child may have terminated; the reaper knows
+        reaperPoll(0, onChildExit);
+        retireExited();
+        return -1;
+    }
+
+    accountQuantum(index);
+    return 0;
+}
+
+/**
+ * Account a quantum that has been sent to a child
+ * @param index Process table index of the child
+ */
+void accountQuantum(int index) {
+    uint64_t now = clockRead(systemClock);
+    traceEvent(TRACE_SEND, index, processTable.pid[index], 0, now, quantumNs);
+    schedCharge(index, now, quantumNs);
+    statsDispatch(index, now, quantumNs);
+    processTable.messagesSent[index]++;
+    atomic_store_explicit(&region.control[index].messagesSent, processTable.messagesSent[index],
+                          memory_order_relaxed);
+    totalMessages++;
+}
+
+/**
+ * Log a child's reply and retire the child if it is terminating
+ * @param index Process table index of the child
+ * @param response Reply received from the child
+ * @param replyWallNs Wall time the reply was received
+ */
+void handleReply(int index, const Message *response, uint64_t replyWallNs) {
+    uint64_t wallNow = replyWallNs;
+    uint64_t rtt = wallNow - processTable.pcb[index].sentWallNs;
+    latencyRecord(&roundTrip, rtt);
+    statsReply(index, rtt);
+
+    // First reply since launch: record the launch latency
+    uint64_t launchedAt = processTable.pcb[index].launchWallNs;
+    if (launchedAt != 0) {
+        uint64_t latency = wallNow - launchedAt;
+        launchLatencyTotalNs += latency;
+        if (latency > launchLatencyMaxNs) {
+            launchLatencyMaxNs = latency;
+        }
+        launchLatencySamples++;
+        processTable.pcb[index].launchWallNs = 0;
+
+        // The worker reads the clock at startup, so its deadline is no earlier than this
+        if (eventMode) {
+            eventSchedule(&events, EVENT_CHILD + index, processTable.pcb[index].deadlineNs);
+        }
+    }
+
+    // The worker logs its status and writes its report before replying
+    if (workerOutput == WORKER_OUTPUT_RING) {
+        drainWorkerLog(index);
+    }
+    if (response->payloadLength != 0) {
+        takeReport(index, response);
+    }
+
+    uint64_t now = clockRead(systemClock);
+    logEvent(LOG_RECEIVE, index, processTable.pid[index], now, 0, 0, 0);
+    traceEvent(TRACE_RECEIVE, index, processTable.pid[index], response->status, now, rtt);
+
+    // Check if child is terminating
+    if (response->status == 0) {
+        logEvent(LOG_TERMINATING, index, processTable.pid[index], 0, 0, 0, 0);
+        traceEvent(TRACE_TERMINATE, index, processTable.pid[index], 0, now,
+                   now - processTable.pcb[index].launchNs);
+        schedComplete(index, clockRead(systemClock));
+
+        // Wait for child to actually terminate
+        launcherReap(index, processTable.pid[index]);
+
+        // Update process table
+        retireChild(index);
+    }
+}
+
+/**
+ * Free a child's process table entry; with -L pool, park a fresh worker on
+ * the entry if more launches are still to come, or more jobs may (-u)
+ * @param index Process table index of the child
+ */
+void retireChild(int index) {
+    if (workerOutput == WORKER_OUTPUT_RING) {
+        drainWorkerLog(index);      // Whatever a worker that died left behind
+    }
+    payloadReset(&region.payloads[index]);
+    statsSlotEnd(index);
+    if (processTable.pcb[index].slow) {
+        processTable.pcb[index].slow = 0;   // Already out of the scheduler
+        slowCount--;
+    } else {
+        schedRemove(index);
+    }
+    if (eventMode) {
+        eventCancel(&events, EVENT_CHILD + index);
+    }
+    pcbRelease(&processTable, index);
+    publishEntry(index);
+
+    if ((serverPath[0] != '\0' || totalProcesses + launcherSpareCount() < processLimit) &&
+        launcherPrepare(index) == -1) {
+        perror("launcherPrepare");
+    }
+}
+
+/**
+ * Copy an entry's PCB to its control line in the region, where external
+ * tools see it; the dispatch table itself stays private to oss
+ * @param index Process table index
+ */
+void publishEntry(int index) {
+    ControlLine *line = &region.control[index];
+    line->occupied = processTable.occupied[index];
+    line->pid = processTable.pid[index];
+    line->startNs = (uint64_t)processTable.pcb[index].startSeconds * NANO_PER_SEC + processTable.pcb[index].startNano;
+    atomic_store_explicit(&line->messagesSent, processTable.messagesSent[index], memory_order_relaxed);
+}
+
+/**
+ * Merge the records an entry's worker has logged since the last drain into
+ * the log, in the order it wrote them (-o ring)
+ * @param index Process table index
+ */
+void drainWorkerLog(int index) {
+    WorkerLogRecord record;
+    while (workerLogTake(&region.logs[index], &record) == 0) {
+        logEvent(LOG_WORKER, record.type, record.pid, record.parentPid, record.iterations,
+                 record.clockNs, record.terminationNs);
+        workerRecords++;
+    }
+}
+
+/**
+ * Account the report a worker's reply points to in the payload arena and
+ * give its space back (-W)
+ * @param index Process table index
+ * @param response Reply carrying the report's descriptor
+ */
+void takeReport(int index, const Message *response) {
+    const WorkerReport *report = payloadAt(region.payloads, simultaneousMax, index,
+                                           response->payloadOffset, response->payloadLength);
+    if (report == NULL) {
+        reportRejected++;
+        return;
+    }
+    if (response->payloadLength < sizeof(WorkerReport) ||
+        response->payloadLength < sizeof(WorkerReport) + (uint64_t)report->sampleCount * sizeof(uint64_t)) {
+        reportRejected++;
+        payloadRelease(&region.payloads[index], response->payloadOffset, response->payloadLength);
+        return;
+    }
+
+    reportPayloads++;
+    reportBytes += response->payloadLength;
+    reportWorkNs += report->workNs;
+    if (report->error != 0) {
+        reportErrors++;
+    }
+    uint32_t sample = 0;
+    for (int k = 0; k < KERNEL_COUNT && sample < report->sampleCount; k++) {
+        if (report->kernels & (1u << k)) {
+            reportKernelNs[k] += report->samples[sample++];
+            reportKernelSamples[k]++;
+        }
+    }
+    payloadRelease(&region.payloads[index], response->payloadOffset, response->payloadLength);
+}
+
+/**
+ * Next launch record of the replay trace
+ * @param launch Set to the record
+ * @return 0 on success, -1 if not replaying or every launch has been replayed
+ */
+int replayPeekLaunch(const TraceRecord **launch) {
+    while (replayNext < replay.count && replay.records[replayNext].type != TRACE_LAUNCH) {
+        replayNext++;
+    }
+    if (replayNext == replay.count) {
+        return -1;
+    }
+    *launch = &replay.records[replayNext];
+    return 0;
+}
+
+/**
+ * Earliest simulated time of the next launch: from the arrival generator, or
+ * the recorded time when replaying
+ */
+uint64_t nextLaunchTime(uint64_t lastLaunchTime) {
+    const TraceRecord *launch;
+    if (replay.header != NULL) {
+        return replayPeekLaunch(&launch) == 0 ? launch->simNs : UINT64_MAX;
+    }
+    return workgenNextLaunch(&workgen, lastLaunchTime);
+}
+
+/**
+ * Wait for a reply from one of the given entries. A child exit (SIGCHLD)
+ * interrupts the wait so the caller can collect it.
+ * @param deadlineNs Wall time (monotonicNs) to give up at, 0 for never
+ * @return 0 on success, -1 with errno EINTR if children exited, ETIMEDOUT
+ *         if no reply came by the deadline
+ */
+int awaitReply(int *slots, int count, Message *msg, uint64_t deadlineNs) {
+    int rc;
+
+    // Announce the wait before checking so an exit in between interrupts it
+    awaitingReply = 1;
+    if (reaperPending()) {
+        errno = EINTR;
+        rc = -1;
+    } else {
+        rc = transportRecvAnyFromWorkerUntil(&transport, slots, count, getpid(), msg, deadlineNs);
+    }
+    awaitingReply = 0;
+    return rc;
+}
+
+/**
+ * SIGCHLD wake callback: break oss out of a blocking receive
+ */
+void interruptReceive(void) {
+    if (awaitingReply) {
+        transportInterrupt(&transport, getpid());
+    }
+}
+
+/**
+ * Reaper callback: note that an occupied entry's worker has exited. It is
+ * retired by retireExited once any reply it sent first has been taken.
+ */
+void onChildExit(pid_t pid, int status, const struct rusage *usage) {
+    statsExit(pid, status, usage);
+
+    int index = pcbFindByPid(&processTable, pid);
+    traceEvent(TRACE_REAP, index, pid, status, clockRead(systemClock),
+               (uint64_t)(usage->ru_utime.tv_sec + usage->ru_stime.tv_sec) * 1000000 +
+               usage->ru_utime.tv_usec + usage->ru_stime.tv_usec);
+
+    if (index == -1) {
+        // A worker that already terminated normally, or a parked spare
+        launcherForget(pid);
+        return;
+    }
+    if (!processTable.pcb[index].exited) {
+        processTable.pcb[index].exited = 1;
+        exitedSlots[exitedCount++] = index;
+    }
+}
+
+/**
+ * Retire every entry whose worker exited without a final reply
+ */
+void retireExited() {
+    for (int i = 0; i < exitedCount; i++) {
+        int index = exitedSlots[i];
+        if (processTable.occupied[index] && processTable.pcb[index].exited) {
+            logEvent(LOG_UNEXPECTED_EXIT, index, processTable.pid[index], 0, 0, 0, 0);
+            uint64_t now = clockRead(systemClock);
+            traceEvent(TRACE_UNEXPECTED_EXIT, index, processTable.pid[index], 0, now,
+                       now - processTable.pcb[index].launchNs);
+            transportDiscard(&transport, processTable.pid[index]);
+            retireChild(index);
+        }
+    }
+    exitedCount = 0;
+}
+
+/**
+ * Serial dispatch: send one quantum to a child and wait for its reply
+ * @param index Process table index of the child
+ */
+void dispatchOne(int index) {
+    // A slow worker's turn passes until its overdue reply is in (-q)
+    if (processTable.pcb[index].slow) {
+        return;
+    }
+    if (sendQuantum(index) == -1) {
+        return;
+    }
+
+    // Receive message from child
+    Message response;
+    uint64_t deadline = replyBudgetNs != 0 ? processTable.pcb[index].sentWallNs + replyBudgetNs : 0;
+    for (;;) {
+        if (awaitReply(&index, 1, &response, deadline) == 0) {
+            // The queue and the worker agents also deliver slow workers' overdue replies
+            if (response.pid == processTable.pid[index]) {
+                break;
+            }
+            if (!takeLateReply(&response)) {
+                fprintf(stderr, "OSS: Ignoring reply from unknown PID %d\n", response.pid);
+            }
+            continue;
+        }
+        if (errno == ETIMEDOUT) {
+            replyOverdue(index);
+            return;
+        }
+        if (errno != EINTR) {
+            perror("receive from worker");
+            return;
+        }
+
+        reaperPoll(0, onChildExit);
+        if (processTable.pcb[index].exited) {
+            // A worker sends its final reply before exiting, so it is here if it was sent
+            int found = 0;
+            while (transportTryRecvAnyFromWorker(&transport, &index, 1, getpid(), &response) == 0) {
+                if (response.pid == processTable.pid[index]) {
+                    found = 1;
+                    break;
+                }
+                takeLateReply(&response);
+            }
+            if (found) {
+                break;
+            }
+            retireExited();
+            return;
+        }
+        retireExited();
+    }
+
+    handleReply(index, &response, monotonicNs());
+    retireExited();
 }
 
 /**
- * Signal handler for SIGALRM (timeout)
+ * A quantum's reply missed the budget (-q): stop waiting for it. A worker
+ * process is killed and its entry retired once the reaper has it; a thread
+ * or remote worker cannot be killed, so it is marked slow and gets no more
+ * quanta until its reply comes in.
+ * @param index Process table index of the worker
+ */
+void replyOverdue(int index) {
+    struct PCB *pcb = &processTable.pcb[index];
+    pid_t pid = processTable.pid[index];
+    uint64_t waited = monotonicNs() - pcb->sentWallNs;
+    int killed = launcherUsesProcesses();
+
+    pcb->timeouts++;
+    replyTimeouts++;
+    logEvent(LOG_REPLY_TIMEOUT, index, pid, waited / 1000, pcb->timeouts, killed, 0);
+    traceEvent(TRACE_TIMEOUT, index, pid, killed, clockRead(systemClock), waited);
+
+    if (!pcb->slow) {
+        pcb->slow = 1;
+        slowCount++;
+        schedRemove(index);
+    }
+    if (killed && kill(pid, SIGKILL) == 0) {
+        workersKilled++;
+    }
+}
+
+/**
+ * Hand an overdue reply to its slow entry, which rejoins the scheduler at
+ * the lowest priority. The reply of a worker killed for being late is
+ * dropped; its entry is retired once it is reaped.
+ * @return 1 if the reply belonged to a slow entry, 0 if to none
+ */
+int takeLateReply(const Message *response) {
+    int index = pcbFindByPid(&processTable, response->pid);
+    if (index == -1 || !processTable.occupied[index] || !processTable.pcb[index].slow) {
+        return 0;
+    }
+    if (launcherUsesProcesses()) {
+        return 1;
+    }
+
+    processTable.pcb[index].slow = 0;
+    slowCount--;
+    lateReplies++;
+    schedReadmit(index, MLFQ_LEVELS - 1);
+    handleReply(index, response, monotonicNs());
+    return 1;
+}
+
+/**
+ * Take the overdue replies of slow entries that have come in (-q)
+ * @param wait Wait up to the reply budget for one if none has
+ */
+void takeLateReplies(int wait) {
+    for (;;) {
+        int count = 0;
+        for (int i = 0, index = processTable.ringHead; i < processTable.activeCount; i++) {
+            if (processTable.pcb[index].slow) {
+                slowSlots[count++] = index;
+            }
+            index = processTable.ringNext[index];
+        }
+        if (count == 0) {
+            break;
+        }
+
+        Message response;
+        int rc = wait ? awaitReply(slowSlots, count, &response, monotonicNs() + replyBudgetNs)
+                      : transportTryRecvAnyFromWorker(&transport, slowSlots, count, getpid(), &response);
+        if (rc == -1) {
+            break;      // None yet, or interrupted by an exit the next pass retires
+        }
+        if (!takeLateReply(&response)) {
+            fprintf(stderr, "OSS: Ignoring reply from unknown PID %d\n", response.pid);
+        }
+        wait = 0;
+    }
+    retireExited();
+}
+
+/**
+ * Hand a reply received during a pipelined round to its pending entry
+ * @param pending Entries still awaiting a reply; the matched one is removed
+ * @param pendingCount Number of pending entries
+ */
+void takeReply(const Message *response, int *pending, int *pendingCount) {
+    int index = pcbFindByPid(&processTable, response->pid);
+    int match = -1;
+    for (int p = 0; index >= 0 && p < *pendingCount; p++) {
+        if (pending[p] == index) {
+            match = p;
+            break;
+        }
+    }
+    if (match == -1) {
+        if (!takeLateReply(response)) {
+            fprintf(stderr, "OSS: Ignoring reply from unknown PID %d\n", response->pid);
+        }
+        return;
+    }
+
+    pending[match] = pending[--(*pendingCount)];
+    handleReply(index, response, monotonicNs());
+}
+
+/**
+ * Wall time by which the earliest of a round's outstanding quanta must be
+ * answered (-q)
+ * @return The deadline, or 0 if there is no budget
+ */
+uint64_t roundDeadline(const int *pending, int pendingCount) {
+    if (replyBudgetNs == 0) {
+        return 0;
+    }
+    uint64_t earliest = UINT64_MAX;
+    for (int p = 0; p < pendingCount; p++) {
+        if (processTable.pcb[pending[p]].sentWallNs < earliest) {
+            earliest = processTable.pcb[pending[p]].sentWallNs;
+        }
+    }
+    return earliest + replyBudgetNs;
+}
+
+/**
+ * Pipelined dispatch: send a quantum to every occupied entry, then drain
+ * the replies in arrival order, matching each one to its entry by PID. On
+ * the message queue at most sendWindow quanta are outstanding; past that,
+ * replies are taken to make room before the next send.
+ */
+void dispatchRound() {
+    if (dispatcherThreads > 1) {
+        dispatchShardedRound();
+        return;
+    }
+
+    int *pending = pendingSlots;
+    int pendingCount = 0;
+
+    // Snapshot the active ring first: a failed send releases its entry.
+    // Slow entries sit the round out (-q). The entries awaiting a reply are
+    // kept at the front of the same list, behind the ones still to send.
+    int count = 0;
+    for (int i = 0, index = processTable.ringHead; i < processTable.activeCount; i++) {
+        if (!processTable.pcb[index].slow) {
+            pending[count++] = index;
+        }
+        index = processTable.ringNext[index];
+    }
+
+    // Slow workers' late replies take room on the queue as well
+    int sent = 0;
+    while (sent < count || pendingCount > 0) {
+        // A stop sends nothing more; the replies already due are still taken
+        if (stopSignal != 0) {
+            count = sent;
+        }
+        if (sent < count && (pendingCount == 0 || pendingCount < sendWindow - slowCount)) {
+            int index = pending[sent++];
+            if (processTable.occupied[index] && sendQuantum(index) == 0) {
+                pending[pendingCount++] = index;
+            }
+            continue;
+        }
+
+        Message response;
+        if (awaitReply(pending, pendingCount, &response, roundDeadline(pending, pendingCount)) == 0) {
+            takeReply(&response, pending, &pendingCount);
+            continue;
+        }
+        if (errno == ETIMEDOUT) {
+            // Stop waiting for every quantum that is past the budget
+            uint64_t now = monotonicNs();
+            int kept = 0;
+            for (int p = 0; p < pendingCount; p++) {
+                if (now - processTable.pcb[pending[p]].sentWallNs >= replyBudgetNs) {
+                    replyOverdue(pending[p]);
+                } else {
+                    pending[kept++] = pending[p];
+                }
+            }
+            pendingCount = kept;
+            continue;
+        }
+        if (errno != EINTR) {
+            perror("receive from worker");
+            break;
+        }
+
+        // Workers exited: take the final replies they sent first, then
+        // retire the ones that never replied and stop waiting for them
+        reaperPoll(0, onChildExit);
+        while (pendingCount > 0 &&
+               transportTryRecvAnyFromWorker(&transport, pending, pendingCount, getpid(), &response) == 0) {
+            takeReply(&response, pending, &pendingCount);
+        }
+        retireExited();
+
+        int kept = 0;
+        for (int p = 0; p < pendingCount; p++) {
+            if (processTable.occupied[pending[p]]) {
+                pending[kept++] = pending[p];
+            }
+        }
+        pendingCount = kept;
+    }
+    retireExited();
+}
+
+/**
+ * Handle the replies a sharded round has taken since the last call, and the
+ * quanta it stopped waiting for (-q)
+ * @param count Jobs in the round
+ */
+void takeShardReplies(ShardJob *jobs, int count) {
+    for (int i = 0; i < count; i++) {
+        if (jobs[i].state == SHARD_JOB_REPLIED) {
+            Message response = { 0, jobs[i].pid, jobs[i].status, jobs[i].shard,
+                                 jobs[i].payloadOffset, jobs[i].payloadLength };
+            jobs[i].state = SHARD_JOB_DONE;
+            handleReply(jobs[i].index, &response, jobs[i].replyWallNs);
+        } else if (jobs[i].state == SHARD_JOB_OVERDUE) {
+            jobs[i].state = SHARD_JOB_DONE;
+            replyOverdue(jobs[i].index);
+        }
+    }
+}
+
+/**
+ * Sharded pipelined dispatch (-m): the dispatcher threads send the round's
+ * quanta and take the replies, each on the channel of the thread that sent
+ * the quantum. oss accounts the quanta and handles the replies once the
+ * threads are done, so the scheduler, process table and trace stay
+ * single-threaded. A round larger than sendWindow is exchanged in batches.
+ */
+void dispatchShardedRound() {
+    ShardJob *jobs = shardJobs;
+    int count = 0;
+    for (int i = 0, index = processTable.ringHead; i < processTable.activeCount; i++) {
+        if (!processTable.pcb[index].slow) {
+            jobs[count].index = index;
+            jobs[count].pid = processTable.pid[index];
+            count++;
+        }
+        index = processTable.ringNext[index];
+    }
+
+    // Slow workers' late replies take room on the queue as well
+    int window = sendWindow - slowCount > 1 ? sendWindow - slowCount : 1;
+    for (int start = 0; start < count; start += window) {
+        exchangeShardBatch(jobs + start, count - start < window ? count - start : window);
+    }
+    retireExited();
+}
+
+/**
+ * Hand a batch of a sharded round to the dispatcher threads and handle its
+ * replies
+ * @param count Jobs in the batch
+ */
+void exchangeShardBatch(ShardJob *jobs, int count) {
+    // An earlier batch may have retired some of these entries
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        if (processTable.occupied[jobs[i].index] && processTable.pid[jobs[i].index] == jobs[i].pid) {
+            jobs[kept] = jobs[i];
+            logEvent(LOG_SEND, jobs[kept].index, jobs[kept].pid, clockRead(systemClock), 0, 0, 0);
+            kept++;
+        }
+    }
+    count = kept;
+
+    // Announce the wait first, so an exit from here on interrupts the threads
+    awaitingReply = 1;
+    if (reaperPending()) {
+        interruptReceive();
+    }
+    int rc = shardsExchange(jobs, count);
+    int error = errno;
+    awaitingReply = 0;
+
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        if (jobs[i].state == SHARD_JOB_FAILED) {
+            fprintf(stderr, "send to worker: %s\n", strerror(jobs[i].error));
+            jobs[i].state = SHARD_JOB_DONE;
+            failed = 1;
+        } else {
+            processTable.pcb[jobs[i].index].sentWallNs = jobs[i].sentWallNs;
+            accountQuantum(jobs[i].index);
+        }
+    }
+    takeShardReplies(jobs, count);
+    if (failed) {
+        // Children may have terminated; the reaper knows
+        reaperPoll(0, onChildExit);
+    }
+
+    while (rc == -1) {
+        if (error != EINTR) {
+            errno = error;
+            perror("receive from worker");
+            break;
+        }
+
+        // Workers exited: take the final replies they sent first, then
+        // retire the ones that never replied and stop waiting for them
+        reaperPoll(0, onChildExit);
+        shardsCollect(jobs, 0);
+        takeShardReplies(jobs, count);
+        retireExited();
+
+        int pendingCount = 0;
+        for (int i = 0; i < count; i++) {
+            if (jobs[i].state == SHARD_JOB_SENT && !processTable.occupied[jobs[i].index]) {
+                jobs[i].state = SHARD_JOB_DONE;
+            }
+            pendingCount += jobs[i].state == SHARD_JOB_SENT;
+        }
+        if (pendingCount == 0) {
+            break;
+        }
+
+        awaitingReply = 1;
+        if (reaperPending()) {
+            interruptReceive();
+        }
+        rc = shardsCollect(jobs, 1);
+        error = errno;
+        awaitingReply = 0;
+        takeShardReplies(jobs, count);
+    }
+}
+
+/**
+ * Discrete-event mode: jump over the loop passes before the next event.
+ * Events are the next allowed launch, the next table display and each
+ * worker's earliest termination time. Passes before the earliest event
+ * would only advance the clock and hand out quanta that the workers answer
+ * with "continue", so they are accounted here (clock, scheduler, message
+ * counts) without exchanging messages. The pass that reaches the event
+ * runs normally, so launches, displays and terminations happen at the same
+ * simulated times as in step mode.
+ */
+void fastForward(uint64_t lastLaunchTime, uint64_t lastDisplayTime) {
+    int active = processTable.activeCount;
+
+    if (totalProcesses < processLimit && active < simultaneousLimit) {
+        eventSchedule(&events, EVENT_LAUNCH, nextLaunchTime(lastLaunchTime));
+    } else {
+        eventCancel(&events, EVENT_LAUNCH);
+    }
+    if (loggerEnabled(LOG_LIFECYCLE)) {
+        eventSchedule(&events, EVENT_DISPLAY, lastDisplayTime + 500 * NANO_PER_MS);
+    } else {
+        eventCancel(&events, EVENT_DISPLAY);
+    }
+
+    uint64_t next;
+    if (eventPeek(&events, &next) == -1) {
+        return;
+    }
+
+    // Clock step and per-child quantum of one pass, as in the main loop
+    uint64_t quantum = (250 * NANO_PER_MS) / (active > 0 ? active : 1);
+    uint64_t step = dispatchMode == DISPATCH_PIPELINED ? 250 * NANO_PER_MS : quantum;
+    uint64_t now = clockRead(systemClock);
+    if (next <= now + step) {
+        return;
+    }
+
+    // Passes whose clock value stays before the event
+    uint64_t skip = (next - now - 1) / step;
+
+    // Slow entries (-q) get no quanta here either: a round skips them, and a
+    // serial pass that picks one (or finds none ready) dispatches nothing.
+    // A round, or a serial round-robin pass, hands every entry its quanta in
+    // a fixed order, so those are credited per entry rather than per pass.
+    if (active > 0 && dispatchMode == DISPATCH_PIPELINED) {
+        for (int i = 0, index = processTable.ringHead; i < active; i++) {
+            if (!processTable.pcb[index].slow) {
+                creditQuanta(index, now + step, now + skip * step, quantum, skip);
+            }
+            index = processTable.ringNext[index];
+        }
+    } else if (active > 0 && schedPolicy == SCHED_RR) {
+        // Pass k picks the k-th entry after the cursor, wrapping around the ring
+        for (uint64_t k = 1; k <= skip && k <= (uint64_t)active; k++) {
+            int index = schedNext(now + k * step);
+            uint64_t visits = (skip - k) / active + 1;
+            if (!processTable.pcb[index].slow) {
+                creditQuanta(index, now + k * step, now + (k + (visits - 1) * active) * step, quantum, visits);
+            }
+        }
+        for (uint64_t k = skip > (uint64_t)active ? (skip - active) % active : 0; k > 0; k--) {
+            schedNext(now);
+        }
+    } else {
+        // The other policies pick by state every pass changes
+        for (uint64_t pass = 1; pass <= skip && active > 0; pass++) {
+            uint64_t t = now + pass * step;
+            int index = schedNext(t);
+            if (index < 0 || processTable.pcb[index].slow) {
+                continue;
+            }
+            creditQuanta(index, t, t, quantum, 1);
+        }
+    }
+
+    clockSet(systemClock, now + skip * step);
+    skippedPasses += skip;
+}
+
+/**
+ * Account quanta fast-forward hands an entry without exchanging messages
+ * @param firstNs Simulated time of the first of them
+ * @param lastNs Simulated time of the last
+ * @param count Quanta
+ */
+void creditQuanta(int index, uint64_t firstNs, uint64_t lastNs, uint64_t quantum, uint64_t count) {
+    schedChargeQuanta(index, firstNs, quantum, count);
+    statsDispatchQuanta(index, lastNs, quantum, count);
+    processTable.messagesSent[index] += count;
+    atomic_store_explicit(&region.control[index].messagesSent, processTable.messagesSent[index],
+                          memory_order_relaxed);
+    totalMessages += count;
+    creditedQuanta += count;
+}
+
+/**
+ * Increment the system clock
+ * @param activeChildren Number of active children
+ */
+void incrementClock(int activeChildren) {
+    // Increment by 250ms divided by number of children
+    clockAdvance(systemClock, (250 * NANO_PER_MS) / activeChildren);
+}
+
+/**
+ * Display the current process table, or only its changed rows with -D
+ */
+void displayProcessTable() {
+    if (!loggerEnabled(LOG_LIFECYCLE)) {
+        return;
+    }
+
+    // Rows the table grew into since the last display always count as changed
+    if (shownCapacity < processTable.capacity) {
+        TableRow *rows = realloc(shownRows, processTable.capacity * sizeof(TableRow));
+        if (rows != NULL) {
+            memset(rows + shownCapacity, 0xff, (processTable.capacity - shownCapacity) * sizeof(TableRow));
+            shownRows = rows;
+            shownCapacity = processTable.capacity;
+        }
+    }
+
+    logEvent(LOG_TABLE_HEADER, getpid(), clockRead(systemClock), deltaTables, 0, 0, 0);
+
+    for (int i = 0; i < processTable.capacity; i++) {
+        TableRow row = { processTable.occupied[i], processTable.pid[i], processTable.pcb[i].startSeconds,
+                         processTable.pcb[i].startNano, processTable.messagesSent[i] };
+
+        if (deltaTables && i < shownCapacity) {
+            TableRow *last = &shownRows[i];
+            if (last->occupied == row.occupied && last->pid == row.pid &&
+                last->startSeconds == row.startSeconds && last->startNano == row.startNano &&
+                last->messagesSent == row.messagesSent) {
+                continue;
+            }
+            *last = row;
+        }
+
+        logEvent(LOG_TABLE_ROW, i, row.occupied, row.pid, row.startSeconds, row.startNano, row.messagesSent);
+    }
+
+    logEvent(LOG_TABLE_END, 0, 0, 0, 0, 0, 0);
+}
+
+/**
+ * Write the run's parameters and final statistics to the -j file as one
+ * JSON object
+ */
+void writeJsonStats(int timelimit, int launchInterval, double elapsed, double messageRate,
+                    double launchLatencyAvgUs, unsigned long long reportDropped) {
+    FILE *out = fopen(jsonPath, "w");
+    if (out == NULL) {
+        perror("Error opening JSON statistics file");
+        return;
+    }
+
+    const SchedStats *sched = schedStats();
+    double completed = sched->completed > 0 ? sched->completed : 1;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"parameters\": {\"n\": %d, \"s\": %d, \"t\": %d, \"i\": %d, \"transport\": \"%s\", "
+            "\"dispatch\": \"%s\", \"launch\": \"%s\", \"policy\": \"%s\", \"eventMode\": %d, \"seed\": %u, \"placement\": \"%s\", "
+            "\"workload\": \"%s\", \"arrivals\": \"%s\", \"workerOutput\": \"%s\", \"dispatcherThreads\": %d},\n",
+            processLimit, simultaneousLimit, timelimit, launchInterval, transportName(transport.kind),
+            dispatchModeName(), launchModeName(launchMode), schedPolicyName(schedPolicy), eventMode, seed, placement,
+            workloadText, replay.header != NULL ? "replay" : workgenText, workerOutputName(workerOutput),
+            dispatcherThreads);
+    fprintf(out, "  \"processesLaunched\": %d,\n", totalProcesses);
+    fprintf(out, "  \"messagesSent\": %llu,\n", (unsigned long long)totalMessages);
+    fprintf(out, "  \"elapsedSec\": %.6f,\n", elapsed);
+    fprintf(out, "  \"messagesPerSec\": %.1f,\n", messageRate);
+    fprintf(out, "  \"roundTrip\": ");
+    latencyWriteJson(out, &roundTrip);
+    fprintf(out, ",\n");
+    fprintf(out, "  \"launchLatency\": {\"count\": %d, \"meanUs\": %.1f, \"maxUs\": %.1f},\n",
+            launchLatencySamples, launchLatencyAvgUs, launchLatencyMaxNs / 1e3);
+    fprintf(out, "  \"scheduler\": {\"completed\": %d, \"turnaroundSec\": %.6f, \"waitSec\": %.6f, "
+            "\"responseSec\": %.6f},\n",
+            sched->completed, sched->turnaroundNs / 1e9 / completed, sched->waitNs / 1e9 / completed,
+            sched->responseNs / 1e9 / completed);
+    fprintf(out, "  \"fastForward\": {\"passesSkipped\": %llu, \"quantaCredited\": %llu},\n",
+            skippedPasses, creditedQuanta);
+    fprintf(out, "  \"quantaStolen\": %llu,\n", (unsigned long long)shardsSteals());
+    fprintf(out, "  \"workerReports\": {\"enabled\": %d, \"payloads\": %llu, \"bytes\": %llu, \"dropped\": %llu, "
+            "\"rejected\": %llu, \"errors\": %llu, \"workUsAvg\": %.1f, \"kernelUsAvg\": {",
+            workerReports, reportPayloads, reportBytes, reportDropped, reportRejected, reportErrors,
+            reportPayloads > 0 ? reportWorkNs / 1e3 / reportPayloads : 0.0);
+    const char *separator = "";
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        if (reportKernelSamples[k] > 0) {
+            fprintf(out, "%s\"%s\": %.1f", separator, workloadKernelName(k), reportKernelNs[k] / 1e3 / reportKernelSamples[k]);
+            separator = ", ";
+        }
+    }
+    fprintf(out, "}},\n");
+    fprintf(out, "  \"replyBudget\": {\"ms\": %llu, \"timeouts\": %llu, \"workersKilled\": %llu, \"lateReplies\": %llu},\n",
+            (unsigned long long)(replyBudgetNs / NANO_PER_MS), replyTimeouts, workersKilled, lateReplies);
+    if (transport.kind == TRANSPORT_SOCK) {
+        fprintf(out, "  \"socketHops\": {\"agents\": %d, \"network\": ", remoteAgentCount());
+        latencyWriteJson(out, remoteNetworkHop());
+        fprintf(out, ", \"agent\": ");
+        latencyWriteJson(out, remoteAgentHop());
+        fprintf(out, "},\n");
+    }
+    fprintf(out, "  \"log\": {\"written\": %llu, \"dropped\": %llu}\n",
+            (unsigned long long)loggerWritten(), (unsigned long long)loggerDropped());
+    fprintf(out, "}\n");
+    fclose(out);
+}
+
+/**
+ * Signal handler for SIGINT (Ctrl+C). The main loop stops at the end of the
+ * current pass; a second SIGINT stops at once.
+ */
+void sigintHandler(int sig) {
+    if (stopSignal != 0) {
+        stopRun(sig);
+    }
+    stopSignal = sig;
+}
+
+/**
+ * Signal handler for SIGALRM (timeout), deferred like SIGINT
  */
 void timeoutHandler(int sig) {
-    fprintf(stderr, "\nTimeout reached (60 seconds). Cleaning up and terminating...\n");
-    fprintf(logfile, "\nTimeout reached (60 seconds). Cleaning up and terminating...\n");
-    fprintf(logfile, "\n--- Final Statistics at Timeout ---\n");
+    if (stopSignal != 0) {
+        stopRun(sig);
+    }
+    stopSignal = sig;
+}
+
+/**
+ * Log why oss is stopping early, clean up and exit
+ * @param sig SIGINT or SIGALRM
+ */
+void stopRun(int sig) {
+    loggerStop();
+    if (sig == SIGALRM) {
+        fprintf(stderr, "\nTimeout reached (%d seconds). Cleaning up and terminating...\n", runTimeLimit);
+        fprintf(logfile, "\nTimeout reached (%d seconds). Cleaning up and terminating...\n", runTimeLimit);
+        fprintf(logfile, "\n--- Final Statistics at Timeout ---\n");
+    } else {
+        fprintf(stderr, "\nCaught SIGINT. Cleaning up and terminating...\n");
+        fprintf(logfile, "\nCaught SIGINT. Cleaning up and terminating...\n");
+        fprintf(logfile, "\n--- Final Statistics at Termination ---\n");
+    }
     fprintf(logfile, "Total processes launched: %d\n", totalProcesses);
-    fprintf(logfile, "Total messages sent: %d\n", totalMessages);
+    fprintf(logfile, "Total messages sent: %llu\n", (unsigned long long)totalMessages);
+    if (checkpointPath[0] != '\0') {
+        fprintf(stderr, "Resume from the last snapshot with -r %s\n", checkpointPath);
+    }
     cleanup();
     exit(EXIT_SUCCESS);
 }
 
+/**
+ * Reaper callback during cleanup: log the exit and forget the child so it
+ * is not signalled again
+ */
+void onShutdownExit(pid_t pid, int status, const struct rusage *usage) {
+    if (logfile != NULL) {
+        fprintf(logfile, "Child PID %d terminated with status %d\n", pid, status);
+    }
+    statsExit(pid, status, usage);
+
+    int index = processTable.capacity > 0 ? pcbFindByPid(&processTable, pid) : -1;
+    if (index >= 0) {
+        pcbRelease(&processTable, index);
+    } else {
+        launcherForget(pid);
+    }
+}
+
 /**
  * Cleanup function to release resources
  */
 void cleanup() {
+    // Make sure queued records reach the log before cleanup messages
+    loggerStop();
+
     // Log cleanup start
     if (logfile != NULL) {
         fprintf(logfile, "Starting cleanup process...\n");
     }
 
     // Kill any remaining child processes
-    for (int i = 0; i < MAX_PROCESSES; i++) {
-        if (childPIDs[i] > 0) {
-            if (kill(childPIDs[i], SIGTERM) == 0) {
+    for (int i = 0; i < processTable.capacity; i++) {
+        if (processTable.occupied[i] && processTable.pid[i] > 0 && launcherUsesProcesses()) {
+            if (kill(processTable.pid[i], SIGTERM) == 0) {
                 if (logfile != NULL) {
-                    fprintf(logfile, "Sent SIGTERM to child PID %d\n", childPIDs[i]);
+                    fprintf(logfile, "Sent SIGTERM to child PID %d\n", processTable.pid[i]);
                 }
             }
         }
     }
 
-    // Wait for all children to terminate with a timeout
-    int status;
-    pid_t wpid;
-    time_t startTime = time(NULL);
+    // Parked pre-forked workers are children too
+    launcherSignalSpares(SIGTERM);
 
-    while ((wpid = waitpid(-1, &status, WNOHANG)) > 0 || time(NULL) - startTime < 2) {
-        if (wpid > 0 && logfile != NULL) {
-            fprintf(logfile, "Child PID %d terminated with status %d\n", wpid, status);
-        }
-        // Small delay to avoid busy waiting
-        usleep(10000);
+    // Collect children as they exit; done as soon as the last one is gone
+    uint64_t deadline = monotonicNs() + SHUTDOWN_GRACE_NS;
+    uint64_t now;
+    while (reaperLiveChildren() > 0 && (now = monotonicNs()) < deadline) {
+        reaperPoll((int)((deadline - now) / NANO_PER_MS) + 1, onShutdownExit);
     }
 
     // Force kill any lingering processes
-    for (int i = 0; i < MAX_PROCESSES; i++) {
-        if (childPIDs[i] > 0) {
-            if (kill(childPIDs[i], SIGKILL) == 0 && logfile != NULL) {
-                fprintf(logfile, "Sent SIGKILL to lingering child PID %d\n", childPIDs[i]);
+    if (reaperLiveChildren() > 0) {
+        for (int i = 0; i < processTable.capacity; i++) {
+            if (processTable.occupied[i] && processTable.pid[i] > 0 && launcherUsesProcesses()) {
+                if (kill(processTable.pid[i], SIGKILL) == 0 && logfile != NULL) {
+                    fprintf(logfile, "Sent SIGKILL to lingering child PID %d\n", processTable.pid[i]);
+                }
             }
         }
-    }
 
-    // Detach and remove shared memory
-    if (systemClock != (void *)-1) {
-        if (shmdt(systemClock) == 0 && logfile != NULL) {
-            fprintf(logfile, "Detached from shared memory\n");
-        }
+        launcherSignalSpares(SIGKILL);
+        reaperWaitAll(onShutdownExit);
     }
 
-    if (shmid != -1) {
-        if (shmctl(shmid, IPC_RMID, NULL) == 0 && logfile != NULL) {
-            fprintf(logfile, "Removed shared memory segment\n");
+    shardsStop();
+    transportClose(&transport);
+    remoteStop();
+    serverClose();
+    reaperClose();
+    launcherCleanup();
+    statsClose();
+    traceClose();
+    traceUnmap(&replay);
+
+    // Unmap and remove the control region
+    if (region.header != NULL) {
+        regionDestroy(&region);
+        systemClock = NULL;
+        transport.mailboxes = NULL;
+        if (logfile != NULL) {
+            fprintf(logfile, "Removed control region\n");
         }
     }
 
@@ -549,8 +2443,20 @@ void cleanup() {
     }
 
     // Free process table
-    if (processTable != NULL) {
-        free(processTable);
+    free(pendingSlots);
+    free(slowSlots);
+    free(shardJobs);
+    schedFree();
+    if (eventMode) {
+        eventQueueFree(&events);
+    }
+    free(exitedSlots);
+    free(checkpointEntries);
+    free(checkpointOrder);
+    checkpointUnmap(&resume);
+    free(shownRows);
+    if (processTable.capacity > 0) {
+        pcbTableFree(&processTable);
         if (logfile != NULL) {
             fprintf(logfile, "Freed process table memory\n");
         }
@@ -0,0 +1,297 @@
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include "common.h"
+#include "latency.h"
+#include "trace.h"
+
+#define DEFAULT_WINDOWS 20          // Concurrency windows when -w is not given
+#define BAR_WIDTH 40                // Width of the longest histogram bar
+
+// What is known about the current occupant of a process table entry
+typedef struct {
+    pid_t pid;
+    uint64_t launchNs;          // simulated launch time
+    uint64_t lifetimeNs;        // lifetime oss gave the worker
+    uint64_t firstDispatchNs;   // simulated time of the first quantum
+    uint64_t quanta;
+    uint64_t sentWallNs;        // wall time of the unanswered quantum, 0 if none
+    uint64_t rttMaxNs;
+} Occupant;
+
+/**
+ * Occupant record of an entry, growing the array to cover it
+ * @return The record, or NULL on allocation failure
+ */
+static Occupant *occupantOf(Occupant **occupants, int *capacity, int slot) {
+    if (slot >= *capacity) {
+        int grown = slot + 1 > 2 * *capacity ? slot + 1 : 2 * *capacity;
+        Occupant *bigger = realloc(*occupants, grown * sizeof(Occupant));
+        if (bigger == NULL) {
+            return NULL;
+        }
+        memset(bigger + *capacity, 0, (grown - *capacity) * sizeof(Occupant));
+        *occupants = bigger;
+        *capacity = grown;
+    }
+    return &(*occupants)[slot];
+}
+
+/**
+ * Stream the per-process timelines (one line as each process ends) and
+ * collect the send -> reply wall-time distribution
+ * @return 0 on success, -1 on allocation failure
+ */
+static int analyzeTimelines(const TraceFile *trace, int quiet, LatencyHistogram *dispatch,
+                            uint64_t log2Buckets[64]) {
+    int capacity = trace->header->s > 0 ? trace->header->s : 1;
+    Occupant *occupants = calloc(capacity, sizeof(Occupant));
+    if (occupants == NULL) {
+        return -1;
+    }
+    unsigned long long launched = 0, terminated = 0, unexpected = 0, signalled = 0, timeouts = 0;
+
+    if (!quiet) {
+        printf("\nProcess timelines (simulated seconds; RTT in wall microseconds):\n");
+        printf("%8s %5s %12s %12s %12s %10s %10s %8s %10s %s\n", "PID", "Entry", "Launch", "FirstQuant",
+               "End", "Turnaround", "Lifetime", "Quanta", "RTTmax_us", "Outcome");
+    }
+
+    for (size_t r = 0; r < trace->count; r++) {
+        const TraceRecord *rec = &trace->records[r];
+        if (rec->slot < 0) {
+            continue;       // A reaped worker that no longer held an entry
+        }
+        Occupant *o = occupantOf(&occupants, &capacity, rec->slot);
+        if (o == NULL) {
+            free(occupants);
+            return -1;
+        }
+
+        switch (rec->type) {
+            case TRACE_LAUNCH:
+                memset(o, 0, sizeof(*o));
+                o->pid = rec->pid;
+                o->launchNs = rec->simNs;
+                o->lifetimeNs = rec->arg;
+                launched++;
+                break;
+            case TRACE_SEND:
+                if (o->quanta++ == 0) {
+                    o->firstDispatchNs = rec->simNs;
+                }
+                o->sentWallNs = rec->wallNs;
+                break;
+            case TRACE_RECEIVE:
+                if (o->sentWallNs != 0) {
+                    uint64_t rtt = rec->wallNs - o->sentWallNs;
+                    latencyRecord(dispatch, rtt);
+                    log2Buckets[rtt == 0 ? 0 : 63 - __builtin_clzll(rtt)]++;
+                    if (rtt > o->rttMaxNs) {
+                        o->rttMaxNs = rtt;
+                    }
+                    o->sentWallNs = 0;
+                }
+                break;
+            case TRACE_TERMINATE:
+            case TRACE_UNEXPECTED_EXIT:
+                if (rec->type == TRACE_TERMINATE) {
+                    terminated++;
+                } else {
+                    unexpected++;
+                }
+                if (!quiet) {
+                    printf("%8d %5d %12.6f %12.6f %12.6f %10.6f %10.6f %8llu %10.1f %s\n", o->pid, rec->slot,
+                           o->launchNs / 1e9, o->quanta > 0 ? o->firstDispatchNs / 1e9 : 0.0, rec->simNs / 1e9,
+                           (rec->simNs - o->launchNs) / 1e9, o->lifetimeNs / 1e9,
+                           (unsigned long long)o->quanta, o->rttMaxNs / 1e3,
+                           rec->type == TRACE_TERMINATE ? "terminated" : "unexpected exit");
+                }
+                break;
+            case TRACE_REAP:
+                if (WIFSIGNALED(rec->status)) {
+                    signalled++;
+                }
+                break;
+            case TRACE_TIMEOUT:
+                timeouts++;
+                break;
+            default:
+                break;
+        }
+    }
+
+    printf("\nProcesses: %llu launched, %llu terminated, %llu exited unexpectedly, %llu killed by a signal\n",
+           launched, terminated, unexpected, signalled);
+    if (timeouts > 0) {
+        printf("Replies that missed the oss -q budget: %llu\n", timeouts);
+    }
+    free(occupants);
+    return 0;
+}
+
+/**
+ * Print the send -> reply wall-time distribution with a log2 histogram
+ */
+static void printDispatchLatency(const LatencyHistogram *h, const uint64_t log2Buckets[64]) {
+    printf("\nDispatch latency (send -> reply, wall clock) over %llu round trips:\n",
+           (unsigned long long)h->count);
+    if (h->count == 0) {
+        return;
+    }
+    printf("  mean %.1f us, min %.1f us, p50 %.1f us, p90 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+           latencyMeanNs(h) / 1e3, h->minNs / 1e3, latencyPercentile(h, 50) / 1e3,
+           latencyPercentile(h, 90) / 1e3, latencyPercentile(h, 99) / 1e3,
+           latencyPercentile(h, 99.9) / 1e3, h->maxNs / 1e3);
+
+    uint64_t most = 0;
+    for (int b = 0; b < 64; b++) {
+        if (log2Buckets[b] > most) {
+            most = log2Buckets[b];
+        }
+    }
+    for (int b = 0; b < 64; b++) {
+        if (log2Buckets[b] == 0) {
+            continue;
+        }
+        int width = (int)((log2Buckets[b] * BAR_WIDTH + most - 1) / most);
+        printf("  [%10.1f, %10.1f) us %10llu ", (double)(1ULL << b) / 1e3, (double)(2ULL << b) / 1e3,
+               (unsigned long long)log2Buckets[b]);
+        for (int k = 0; k < width; k++) {
+            putchar('#');
+        }
+        putchar('\n');
+    }
+}
+
+/**
+ * Stream the number of running workers over simulated time: per window, the
+ * time-weighted average, the peak and the launches and ends inside it
+ * @param windowNs Window length in simulated nanoseconds
+ */
+static void analyzeConcurrency(const TraceFile *trace, uint64_t windowNs) {
+    printf("\nConcurrency over simulated time (%.3f s windows):\n", windowNs / 1e9);
+    printf("%12s %12s %8s %6s %8s %6s\n", "From", "To", "Average", "Peak", "Launches", "Ends");
+
+    uint64_t windowStart = 0;
+    uint64_t last = 0;          // time of the previous change
+    uint64_t area = 0;          // running-worker nanoseconds in the window
+    int active = 0, peak = 0;
+    int launches = 0, ends = 0;
+
+    for (size_t r = 0; r < trace->count; r++) {
+        const TraceRecord *rec = &trace->records[r];
+        int delta;
+        if (rec->type == TRACE_LAUNCH) {
+            delta = 1;
+        } else if (rec->type == TRACE_TERMINATE || rec->type == TRACE_UNEXPECTED_EXIT) {
+            delta = -1;
+        } else {
+            continue;
+        }
+
+        // Close every window that ends at or before this change
+        while (rec->simNs >= windowStart + windowNs) {
+            uint64_t end = windowStart + windowNs;
+            area += (uint64_t)active * (end - last);
+            printf("%12.3f %12.3f %8.2f %6d %8d %6d\n", windowStart / 1e9, end / 1e9,
+                   (double)area / windowNs, peak, launches, ends);
+            windowStart = last = end;
+            area = 0;
+            peak = active;
+            launches = ends = 0;
+        }
+
+        area += (uint64_t)active * (rec->simNs - last);
+        last = rec->simNs;
+        active += delta;
+        if (active > peak) {
+            peak = active;
+        }
+        if (delta > 0) {
+            launches++;
+        } else {
+            ends++;
+        }
+    }
+
+    // The last, partial window ends with the last change
+    if (last > windowStart) {
+        printf("%12.3f %12.3f %8.2f %6d %8d %6d\n", windowStart / 1e9, last / 1e9,
+               (double)area / (last - windowStart), peak, launches, ends);
+    }
+}
+
+/**
+ * Map an oss -B trace and stream its summaries
+ */
+int main(int argc, char *argv[]) {
+    int opt;
+    int quiet = 0;
+    uint64_t windowNs = 0;      // 0 = split the run into DEFAULT_WINDOWS windows
+
+    while ((opt = getopt(argc, argv, "hqw:")) != -1) {
+        switch (opt) {
+            case 'h':
+                printf("Usage: %s [-h] [-q] [-w windowMs] trace\n", argv[0]);
+                printf("  -q          : Skip the per-process timelines\n");
+                printf("  -w windowMs : Concurrency window in simulated milliseconds (default: run / %d)\n",
+                       DEFAULT_WINDOWS);
+                exit(EXIT_SUCCESS);
+            case 'q':
+                quiet = 1;
+                break;
+            case 'w':
+                windowNs = strtoull(optarg, NULL, 10) * NANO_PER_MS;
+                if (windowNs == 0) {
+                    fprintf(stderr, "Invalid window. Using default: run / %d\n", DEFAULT_WINDOWS);
+                }
+                break;
+            default:
+                fprintf(stderr, "Invalid option. Use -h for help.\n");
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "Usage: %s [-h] [-q] [-w windowMs] trace\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    TraceFile trace;
+    if (traceMap(argv[optind], &trace) == -1) {
+        if (errno == EINVAL) {
+            fprintf(stderr, "ossanalyze: %s is not an oss trace\n", argv[optind]);
+        } else {
+            perror(argv[optind]);
+        }
+        exit(EXIT_FAILURE);
+    }
+
+    const TraceHeader *h = trace.header;
+    uint64_t endNs = trace.count > 0 ? trace.records[trace.count - 1].simNs : 0;
+    double wallS = trace.count > 0 ? (trace.records[trace.count - 1].wallNs - h->startWallNs) / 1e9 : 0.0;
+    printf("Trace %s: %zu records, n=%d s=%d t=%d i=%d S=%u, simulated %.3f s in %.3f s wall\n",
+           argv[optind], trace.count, h->n, h->s, h->t, h->i, h->seed, endNs / 1e9, wallS);
+
+    LatencyHistogram dispatch;
+    uint64_t log2Buckets[64] = { 0 };
+    latencyReset(&dispatch);
+    if (analyzeTimelines(&trace, quiet, &dispatch, log2Buckets) == -1) {
+        perror("malloc");
+        traceUnmap(&trace);
+        exit(EXIT_FAILURE);
+    }
+    printDispatchLatency(&dispatch, log2Buckets);
+
+    if (windowNs == 0) {
+        windowNs = (endNs + DEFAULT_WINDOWS - 1) / DEFAULT_WINDOWS;
+        windowNs = windowNs < NANO_PER_MS ? NANO_PER_MS : (windowNs + NANO_PER_MS - 1) / NANO_PER_MS * NANO_PER_MS;
+    }
+    analyzeConcurrency(&trace, windowNs);
+
+    traceUnmap(&trace);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "server.h"
+
+/**
+ * Connect to an oss serving jobs (oss -u)
+ * @return Connected socket, or -1 with errno set
+ */
+static int connectToServer(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = SERVER_DEFAULT_PATH;
+    ServerRequest request = { SERVER_RUN, 0, 0, 0, 0 };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "hu:n:s:t:i:x")) != -1) {
+        switch (opt) {
+            case 'h':
+                printf("Usage: %s [-h] [-u socket] [-n proc] [-s simul] [-t timelimitForChildren] "
+                       "[-i intervalInMsToLaunchChildren] [-x]\n", argv[0]);
+                printf("  -u socket : Unix socket the oss serves jobs on (oss -u) (default: %s)\n",
+                       SERVER_DEFAULT_PATH);
+                printf("  -n, -s, -t, -i : The job's parameters, as for oss (default: those oss was started with)\n");
+                printf("  -x        : Ask the oss to stop serving instead of running a job\n");
+                exit(EXIT_SUCCESS);
+            case 'u':
+                path = optarg;
+                break;
+            case 'n':
+                request.processes = atoi(optarg);
+                break;
+            case 's':
+                request.simultaneous = atoi(optarg);
+                break;
+            case 't':
+                request.timelimit = atoi(optarg);
+                break;
+            case 'i':
+                request.launchInterval = atoi(optarg);
+                break;
+            case 'x':
+                request.type = SERVER_STOP;
+                break;
+            default:
+                fprintf(stderr, "Invalid option. Use -h for help.\n");
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (request.processes < 0 || request.simultaneous < 0 || request.timelimit < 0 || request.launchInterval < 0) {
+        fprintf(stderr, "Job parameters must not be negative.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    char line[SERVER_REQUEST_MAX];
+    serverFormatRequest(&request, line, sizeof(line));
+    int fd = connectToServer(path);
+    if (fd == -1) {
+        fprintf(stderr, "ossctl: cannot reach an oss on %s: %s\n", path, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    if (write(fd, line, strlen(line)) != (ssize_t)strlen(line)) {
+        perror("ossctl: sending the job");
+        close(fd);
+        exit(EXIT_FAILURE);
+    }
+    shutdown(fd, SHUT_WR);
+
+    // Print what oss sends back; its last line says how the job ended
+    FILE *in = fdopen(fd, "r");
+    if (in == NULL) {
+        perror("ossctl");
+        close(fd);
+        exit(EXIT_FAILURE);
+    }
+    int status = -1;
+    char reply[1024];
+    while (fgets(reply, sizeof(reply), in) != NULL) {
+        if (strncmp(reply, "end ", 4) == 0) {
+            status = atoi(reply + 4);
+            break;
+        }
+        if (strncmp(reply, "error ", 6) == 0) {
+            fprintf(stderr, "ossctl: oss refused the job: %s", reply + 6);
+            fclose(in);
+            exit(EXIT_FAILURE);
+        }
+        fputs(reply, stdout);
+    }
+    fclose(in);
+
+    if (status == -1) {
+        fprintf(stderr, "ossctl: oss hung up before the job ended\n");
+        exit(EXIT_FAILURE);
+    }
+    if (status == SERVER_JOB_TIMED_OUT) {
+        fprintf(stderr, "ossctl: the job ran out of time (oss -a)\n");
+    }
+    return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,232 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "common.h"
+#include "region.h"
+#include "statseg.h"
+
+#define DEFAULT_DELAY_MS 1000       // Refresh interval
+#define DEFAULT_ROWS 20             // Entries shown per refresh
+
+// One displayed entry
+typedef struct {
+    int slot;
+    SlotStats s;
+    uint64_t quantaDelta;           // quanta since the previous refresh
+} Row;
+
+/**
+ * Real CPU time (ms) and resident set (KB) of a live worker from /proc
+ * @return 0 on success, -1 if the process is gone
+ */
+static int readProc(pid_t pid, double *cpuMs, long *rssKb) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+
+    char buf[1024];
+    size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[len] = '\0';
+
+    // Fields after the parenthesised command name start at field 3 (state)
+    char *p = strrchr(buf, ')');
+    if (p == NULL) {
+        return -1;
+    }
+    unsigned long utime = 0, stime = 0;
+    long rssPages = 0;
+    if (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu %*d %*d %*d %*d %*d %*d %*u %*u %ld",
+               &utime, &stime, &rssPages) != 3) {
+        return -1;
+    }
+
+    long ticks = sysconf(_SC_CLK_TCK);
+    *cpuMs = (utime + stime) * 1000.0 / ticks;
+    *rssKb = rssPages * (sysconf(_SC_PAGESIZE) / 1024);
+    return 0;
+}
+
+/**
+ * Sort rows by activity since the last refresh, then by entry
+ */
+static int compareRows(const void *a, const void *b) {
+    const Row *ra = a, *rb = b;
+    if (ra->quantaDelta != rb->quantaDelta) {
+        return ra->quantaDelta < rb->quantaDelta ? 1 : -1;
+    }
+    return ra->slot - rb->slot;
+}
+
+/**
+ * Map the running oss's control region read-only and print a live view of
+ * its statistics until oss finishes
+ */
+int main(int argc, char *argv[]) {
+    int opt;
+    int delayMs = DEFAULT_DELAY_MS;
+    int maxRows = DEFAULT_ROWS;
+    int iterations = 0;     // 0 = until oss finishes
+    int batch = 0;
+    char path[320] = "";
+    pid_t ossPid = 0;
+
+    while ((opt = getopt(argc, argv, "hd:n:r:bi:p:")) != -1) {
+        switch (opt) {
+            case 'h':
+                printf("Usage: %s [-h] [-d delayMs] [-n iterations] [-r rows] [-b] [-i region | -p ossPid]\n", argv[0]);
+                printf("  -d delayMs    : Refresh interval in milliseconds (default: %d)\n", DEFAULT_DELAY_MS);
+                printf("  -n iterations : Stop after this many refreshes (default: until oss finishes)\n");
+                printf("  -r rows       : Entries shown per refresh, busiest first (default: %d)\n", DEFAULT_ROWS);
+                printf("  -b            : Batch mode: append refreshes instead of redrawing the screen\n");
+                printf("  -i region     : Control region to watch (oss logs its path at startup)\n");
+                printf("  -p ossPid     : Watch the oss with this PID (default: the most recently started)\n");
+                exit(EXIT_SUCCESS);
+            case 'd':
+                delayMs = atoi(optarg);
+                if (delayMs <= 0) {
+                    fprintf(stderr, "Invalid delay. Using default: %d\n", DEFAULT_DELAY_MS);
+                    delayMs = DEFAULT_DELAY_MS;
+                }
+                break;
+            case 'n':
+                iterations = atoi(optarg);
+                break;
+            case 'r':
+                maxRows = atoi(optarg);
+                if (maxRows <= 0) {
+                    fprintf(stderr, "Invalid number of rows. Using default: %d\n", DEFAULT_ROWS);
+                    maxRows = DEFAULT_ROWS;
+                }
+                break;
+            case 'b':
+                batch = 1;
+                break;
+            case 'i':
+                snprintf(path, sizeof(path), "%s", optarg);
+                break;
+            case 'p':
+                ossPid = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Invalid option. Use -h for help.\n");
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (path[0] == '\0' && regionFind(ossPid, path, sizeof(path)) == -1) {
+        fprintf(stderr, "ossstat: no control region; is oss running?\n");
+        exit(EXIT_FAILURE);
+    }
+    Region region;
+    if (regionAttachPath(&region, path) == -1) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+
+    // Wait briefly for oss to finish initializing the region
+    const StatsSegment *seg = region.stats;
+    for (int i = 0; i < 100 && (region.header->magic != REGION_MAGIC || seg->magic != STATS_MAGIC); i++) {
+        usleep(10000);
+    }
+    if (region.header->magic != REGION_MAGIC || seg->magic != STATS_MAGIC) {
+        fprintf(stderr, "ossstat: control region is not initialized\n");
+        exit(EXIT_FAILURE);
+    }
+    const SystemClock *clock = region.clock;
+
+    int slots = seg->slots;
+    Row *rows = malloc(slots * sizeof(Row));
+    uint64_t *lastQuanta = calloc(slots, sizeof(uint64_t));
+    pid_t *lastPid = calloc(slots, sizeof(pid_t));
+    if (rows == NULL || lastQuanta == NULL || lastPid == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t lastMessages = atomic_load(&seg->totalMessages);
+    uint64_t lastWall = monotonicNs();
+
+    for (int iter = 0; iterations == 0 || iter < iterations; iter++) {
+        usleep(delayMs * 1000);
+
+        int finished = atomic_load(&seg->finished) || kill(seg->ossPid, 0) == -1;
+        uint64_t now = monotonicNs();
+        uint64_t messages = atomic_load(&seg->totalMessages);
+        double rate = (messages - lastMessages) * 1e9 / (double)(now - lastWall);
+        lastMessages = messages;
+        lastWall = now;
+
+        int count = 0;
+        for (int i = 0; i < slots; i++) {
+            Row *r = &rows[count];
+            if (statsReadSlot(seg, i, &r->s) == -1 || (!r->s.occupied && r->s.completed == 0)) {
+                continue;
+            }
+            if (r->s.pid != lastPid[i]) {
+                lastPid[i] = r->s.pid;
+                lastQuanta[i] = 0;
+            }
+            r->slot = i;
+            r->quantaDelta = r->s.quanta - lastQuanta[i];
+            lastQuanta[i] = r->s.quanta;
+            count++;
+        }
+        qsort(rows, count, sizeof(Row), compareRows);
+
+        if (!batch) {
+            printf("\033[H\033[2J");
+        }
+        uint64_t clockNs = clockRead(clock);
+        printf("oss PID %d  SysClock %llu:%09u  processes %llu  active %llu  messages %llu  (%.0f/s)%s\n",
+               seg->ossPid, CLOCK_SECONDS(clockNs), CLOCK_NANOS(clockNs),
+               (unsigned long long)atomic_load(&seg->totalProcesses),
+               (unsigned long long)atomic_load(&seg->activeCount),
+               (unsigned long long)messages, rate, finished ? "  [finished]" : "");
+        printf("collected workers: user %.3f s  system %.3f s\n\n",
+               atomic_load(&seg->childUserCpuUs) / 1e6, atomic_load(&seg->childSysCpuUs) / 1e6);
+        printf("%5s %8s %3s %9s %9s %9s %9s %9s %9s %9s %8s %5s\n", "Entry", "PID", "Run", "Quanta",
+               "SimCPU_s", "Wait_s", "RTTp50_us", "RTTp99_us", "RTTmax_us", "CPU_ms", "RSS_KB", "Done");
+
+        for (int k = 0; k < count && k < maxRows; k++) {
+            const SlotStats *s = &rows[k].s;
+            double cpuMs = 0.0;
+            long rssKb = 0;
+
+            // Live workers are read from /proc; collected ones from wait4
+            int live = s->occupied && seg->workerProcesses && readProc(s->pid, &cpuMs, &rssKb) == 0;
+            if (!live && s->exitedPid == s->pid) {
+                cpuMs = (s->userCpuUs + s->sysCpuUs) / 1e3;
+                rssKb = s->maxRssKb;
+            }
+
+            printf("%5d %8d %3s %9llu %9.3f %9.3f %9.1f %9.1f %9.1f %9.1f %8ld %5llu\n",
+                   rows[k].slot, s->pid, s->occupied ? "yes" : "no", (unsigned long long)s->quanta,
+                   s->simCpuNs / 1e9, s->waitNs / 1e9, statsRttPercentile(s, 50) / 1e3,
+                   statsRttPercentile(s, 99) / 1e3, s->rttMaxNs / 1e3, cpuMs, rssKb,
+                   (unsigned long long)s->completed);
+        }
+        if (batch) {
+            printf("\n");
+        }
+        fflush(stdout);
+
+        if (finished) {
+            break;
+        }
+    }
+
+    free(rows);
+    free(lastQuanta);
+    free(lastPid);
+    regionDetach(&region);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,344 @@
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "common.h"
+
+#define MAX_VALUES 32               // Values per swept parameter
+#define DIMENSIONS 8                // Swept oss parameters
+
+// One swept oss option and its comma-separated values
+typedef struct {
+    char flag;                      // oss option letter
+    char *values[MAX_VALUES];
+    int count;
+} Dimension;
+
+// One oss run of the sweep
+typedef struct {
+    int point;                      // Grid point (parameter combination)
+    unsigned int seed;
+    pid_t pid;                      // 0 until started
+    int exitStatus;                 // -1 until finished or if it did not exit normally
+    char *stats;                    // Contents of its -j file, NULL if unavailable
+} Run;
+
+static Dimension dimensions[DIMENSIONS] = {
+    { 'n', { "100" }, 1 },
+    { 's', { "18" }, 1 },
+    { 't', { "2" }, 1 },
+    { 'i', { "0" }, 1 },
+    { 'T', { "msg" }, 1 },
+    { 'd', { "serial" }, 1 },
+    { 'L', { "exec" }, 1 },
+    { 'p', { "rr" }, 1 },
+};
+
+/**
+ * Replace a dimension's values with a comma-separated list
+ * @return 0 on success, -1 if the list is empty or too long
+ */
+static int setValues(char flag, char *list) {
+    for (int d = 0; d < DIMENSIONS; d++) {
+        if (dimensions[d].flag != flag) {
+            continue;
+        }
+        Dimension *dim = &dimensions[d];
+        dim->count = 0;
+        for (char *v = strtok(list, ","); v != NULL; v = strtok(NULL, ",")) {
+            if (dim->count == MAX_VALUES) {
+                return -1;
+            }
+            dim->values[dim->count++] = v;
+        }
+        return dim->count > 0 ? 0 : -1;
+    }
+    return -1;
+}
+
+/**
+ * oss arguments of a grid point; the last dimension varies fastest
+ */
+static void pointArgs(int point, char *out, size_t size) {
+    int digit[DIMENSIONS];
+    for (int d = DIMENSIONS - 1; d >= 0; d--) {
+        digit[d] = point % dimensions[d].count;
+        point /= dimensions[d].count;
+    }
+
+    size_t len = 0;
+    out[0] = '\0';
+    for (int d = 0; d < DIMENSIONS && len < size; d++) {
+        len += snprintf(out + len, size - len, "%s-%c %s", d > 0 ? " " : "", dimensions[d].flag,
+                        dimensions[d].values[digit[d]]);
+    }
+}
+
+/**
+ * Read a whole file into memory, without its trailing newline
+ * @return The contents (to be freed), or NULL if the file could not be read
+ */
+static char *readFile(const char *path) {
+    FILE *in = fopen(path, "r");
+    if (in == NULL) {
+        return NULL;
+    }
+    fseek(in, 0, SEEK_END);
+    long size = ftell(in);
+    rewind(in);
+
+    char *text = size > 0 ? malloc(size + 1) : NULL;
+    if (text != NULL) {
+        size_t len = fread(text, 1, size, in);
+        while (len > 0 && text[len - 1] == '\n') {
+            len--;
+        }
+        text[len] = '\0';
+    }
+    fclose(in);
+    return text;
+}
+
+/**
+ * First number following "key": in a run's JSON statistics
+ * @return The number, or 0 if the key is missing
+ */
+static double jsonNumber(const char *json, const char *key) {
+    char quoted[64];
+    snprintf(quoted, sizeof(quoted), "\"%s\":", key);
+    const char *p = json != NULL ? strstr(json, quoted) : NULL;
+    return p != NULL ? strtod(p + strlen(quoted), NULL) : 0.0;
+}
+
+/**
+ * Start one run in the background; its output goes to /dev/null and its
+ * statistics to dir/runK.json
+ * @return PID of the run, or -1 on failure
+ */
+static pid_t startRun(int k, const Run *run, const char *dir, const char *extra) {
+    char args[512], command[1024];
+    pointArgs(run->point, args, sizeof(args));
+    snprintf(command, sizeof(command), "exec ./oss %s -v 0 -S %u -f /dev/null -j %s/run%d.json %s > /dev/null",
+             args, run->seed, dir, k, extra);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        execl("/bin/sh", "sh", "-c", command, (char *)NULL);
+        _exit(127);
+    }
+    return pid;
+}
+
+/**
+ * Write every run and the per-point summary (mean over repeats) as one JSON
+ * document, and print the summary as a table
+ */
+static void writeResults(FILE *out, FILE *table, const Run *runs, int runCount, int points, int repeats, int jobs,
+                         double wallSec) {
+    char args[512];
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"jobs\": %d,\n", jobs);
+    fprintf(out, "  \"wallSec\": %.3f,\n", wallSec);
+    fprintf(out, "  \"runs\": [\n");
+    for (int k = 0; k < runCount; k++) {
+        pointArgs(runs[k].point, args, sizeof(args));
+        fprintf(out, "    {\"args\": \"%s -S %u\", \"exitStatus\": %d, \"stats\": %s}%s\n", args, runs[k].seed,
+                runs[k].exitStatus, runs[k].stats != NULL ? runs[k].stats : "null", k + 1 < runCount ? "," : "");
+    }
+    fprintf(out, "  ],\n");
+
+    fprintf(table, "%-70s %4s %12s %10s %10s %10s %11s\n", "Parameters", "OK", "Messages/s", "Elapsed_s",
+                   "RTTp50_us", "RTTp99_us", "Turnaround");
+
+    fprintf(out, "  \"points\": [\n");
+    for (int p = 0; p < points; p++) {
+        int ok = 0;
+        double rate = 0, rateMin = 0, rateMax = 0, elapsed = 0, p50 = 0, p99 = 0, turnaround = 0;
+
+        for (int k = p * repeats; k < (p + 1) * repeats; k++) {
+            const char *json = runs[k].stats;
+            if (runs[k].exitStatus != 0 || json == NULL) {
+                continue;
+            }
+            double r = jsonNumber(json, "messagesPerSec");
+            rateMin = ok == 0 || r < rateMin ? r : rateMin;
+            rateMax = ok == 0 || r > rateMax ? r : rateMax;
+            rate += r;
+            elapsed += jsonNumber(json, "elapsedSec");
+            p50 += jsonNumber(json, "p50Ns");      // The first latency object is the round trip
+            p99 += jsonNumber(json, "p99Ns");
+            turnaround += jsonNumber(json, "turnaroundSec");
+            ok++;
+        }
+        double n = ok > 0 ? ok : 1;
+
+        pointArgs(p, args, sizeof(args));
+        fprintf(out, "    {\"args\": \"%s\", \"runs\": %d, \"succeeded\": %d, "
+                "\"messagesPerSec\": {\"mean\": %.1f, \"min\": %.1f, \"max\": %.1f}, \"elapsedSec\": %.6f, "
+                "\"roundTripP50Ns\": %.0f, \"roundTripP99Ns\": %.0f, \"turnaroundSec\": %.6f}%s\n",
+                args, repeats, ok, rate / n, rateMin, rateMax, elapsed / n, p50 / n, p99 / n, turnaround / n,
+                p + 1 < points ? "," : "");
+        fprintf(table, "%-70s %2d/%-2d %11.1f %10.3f %10.1f %10.1f %11.3f\n", args, ok, repeats, rate / n, elapsed / n,
+                   p50 / n / 1e3, p99 / n / 1e3, turnaround / n);
+    }
+    fprintf(out, "  ]\n");
+    fprintf(out, "}\n");
+}
+
+/**
+ * Run a grid of oss parameter combinations concurrently and merge their
+ * -j statistics. Every run has its own private IPC resources, so runs never
+ * interfere through the clock, queue or segments.
+ */
+int main(int argc, char *argv[]) {
+    int opt;
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    int jobs = online > 0 ? (int)online : 1;
+    int repeats = 1;
+    unsigned int seed = 4760;
+    const char *extra = "";
+    FILE *out = stdout;
+    FILE *table = stdout;
+
+    while ((opt = getopt(argc, argv, "hn:s:t:i:T:d:L:p:a:r:S:j:o:")) != -1) {
+        switch (opt) {
+            case 'h':
+                printf("Usage: %s [-h] [-n list] [-s list] [-t list] [-i list] [-T list] [-d list] [-L list] "
+                       "[-p list] [-a args] [-r repeats] [-S seed] [-j jobs] [-o file]\n", argv[0]);
+                printf("  -n -s -t -i -T -d -L -p list : Comma-separated values of that oss option; every\n");
+                printf("                                 combination is run (default: -n 100 -s 18 -t 2 -i 0)\n");
+                printf("  -a args     : Further oss options passed to every run\n");
+                printf("  -r repeats  : Runs per combination, seeds -S to -S + repeats - 1 (default: 1)\n");
+                printf("  -S seed     : First seed of every combination (default: 4760)\n");
+                printf("  -j jobs     : Runs at a time (default: online CPUs, %d)\n", jobs);
+                printf("  -o file     : Write the merged JSON to file (default: stdout)\n");
+                exit(EXIT_SUCCESS);
+            case 'a':
+                extra = optarg;
+                break;
+            case 'r':
+                repeats = atoi(optarg);
+                if (repeats <= 0) {
+                    fprintf(stderr, "Invalid number of repeats. Using default: 1\n");
+                    repeats = 1;
+                }
+                break;
+            case 'S':
+                seed = (unsigned int)strtoul(optarg, NULL, 10);
+                break;
+            case 'j':
+                jobs = atoi(optarg);
+                if (jobs <= 0) {
+                    fprintf(stderr, "Invalid number of jobs. Using default: %ld\n", online > 0 ? online : 1);
+                    jobs = online > 0 ? (int)online : 1;
+                }
+                break;
+            case 'o':
+                out = fopen(optarg, "w");
+                if (out == NULL) {
+                    perror("Error opening output file");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case '?':
+                fprintf(stderr, "Invalid option. Use -h for help.\n");
+                exit(EXIT_FAILURE);
+            default:
+                if (setValues(opt, optarg) == -1) {
+                    fprintf(stderr, "Invalid list for -%c (at most %d values)\n", opt, MAX_VALUES);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+        }
+    }
+
+    // The JSON owns stdout unless it goes to a file
+    if (out == stdout) {
+        table = stderr;
+    }
+
+    int points = 1;
+    for (int d = 0; d < DIMENSIONS; d++) {
+        points *= dimensions[d].count;
+    }
+    int runCount = points * repeats;
+
+    Run *runs = calloc(runCount, sizeof(Run));
+    char dir[] = "/tmp/osssweep.XXXXXX";
+    if (runs == NULL || mkdtemp(dir) == NULL) {
+        perror("osssweep");
+        exit(EXIT_FAILURE);
+    }
+    for (int k = 0; k < runCount; k++) {
+        runs[k].point = k / repeats;
+        runs[k].seed = seed + k % repeats;   // Every combination runs the same seeds
+        runs[k].exitStatus = -1;
+    }
+
+    fprintf(stderr, "osssweep: %d runs (%d combinations x %d), %d at a time\n", runCount, points, repeats, jobs);
+    uint64_t start = monotonicNs();
+    int next = 0, running = 0, finished = 0;
+
+    while (finished < runCount) {
+        while (running < jobs && next < runCount) {
+            runs[next].pid = startRun(next, &runs[next], dir, extra);
+            if (runs[next].pid == -1) {
+                perror("fork");
+                finished++;
+            } else {
+                running++;
+            }
+            next++;
+        }
+        if (running == 0) {
+            continue;
+        }
+
+        int status;
+        pid_t pid = wait(&status);
+        if (pid == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("wait");
+            break;
+        }
+        for (int k = 0; k < next; k++) {
+            if (runs[k].pid != pid) {
+                continue;
+            }
+            char path[64];
+            snprintf(path, sizeof(path), "%s/run%d.json", dir, k);
+            runs[k].exitStatus = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+            runs[k].stats = readFile(path);
+            unlink(path);
+            if (isatty(STDERR_FILENO)) {
+                fprintf(stderr, "osssweep: %d/%d done\r", finished + 1, runCount);
+            }
+            break;
+        }
+        running--;
+        finished++;
+    }
+    double wallSec = (monotonicNs() - start) / 1e9;
+    fprintf(stderr, "%sosssweep: finished in %.3f s\n", isatty(STDERR_FILENO) ? "\n" : "", wallSec);
+    rmdir(dir);
+
+    writeResults(out, table, runs, runCount, points, repeats, jobs, wallSec);
+
+    int failed = 0;
+    for (int k = 0; k < runCount; k++) {
+        failed += runs[k].exitStatus != 0;
+        free(runs[k].stats);
+    }
+    free(runs);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
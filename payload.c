@@ -0,0 +1,82 @@
+#include <stddef.h>
+#include "payload.h"
+
+/**
+ * Round a payload length up to PAYLOAD_ALIGN
+ */
+static uint32_t payloadSpan(uint32_t length) {
+    return (length + PAYLOAD_ALIGN - 1) & ~(uint32_t)(PAYLOAD_ALIGN - 1);
+}
+
+/**
+ * Allocate a payload from the entry's slab (worker side). Never waits: a
+ * slab without room counts a drop, and the reply goes out status-only.
+ * @param length Bytes wanted, at most PAYLOAD_SLAB_SIZE
+ * @param offset Set to the payload's offset in the arena, for the reply
+ * @return Where to write the payload, or NULL if the slab is full
+ */
+void *payloadReserve(PayloadSlab *slab, uint32_t length, uint32_t *offset) {
+    uint32_t span = payloadSpan(length);
+    uint32_t allocated = atomic_load_explicit(&slab->allocated, memory_order_relaxed);
+    uint32_t released = atomic_load_explicit(&slab->released, memory_order_acquire);
+    uint32_t position = allocated % PAYLOAD_SLAB_SIZE;
+    uint32_t skip = position + span > PAYLOAD_SLAB_SIZE ? PAYLOAD_SLAB_SIZE - position : 0;
+
+    // An empty slab always has room: the skipped tail then holds nothing
+    uint32_t used = allocated - released;
+    if (span == 0 || span > PAYLOAD_SLAB_SIZE || (used != 0 && used + skip + span > PAYLOAD_SLAB_SIZE)) {
+        atomic_fetch_add_explicit(&slab->dropped, 1, memory_order_relaxed);
+        return NULL;
+    }
+    position = (position + skip) % PAYLOAD_SLAB_SIZE;
+    atomic_store_explicit(&slab->allocated, allocated + skip + span, memory_order_relaxed);
+    *offset = slab->base + position;
+    return slab->data + position;
+}
+
+/**
+ * Number the slabs of a freshly zeroed arena with their offsets (oss)
+ */
+void payloadArenaInit(PayloadSlab *slabs, int slots) {
+    for (int i = 0; i < slots; i++) {
+        slabs[i].base = i * sizeof(PayloadSlab) + offsetof(PayloadSlab, data);
+    }
+}
+
+/**
+ * Empty an entry's slab for its next worker; only safe once the previous
+ * one is gone, so payloads a dying worker never sent do not leak space
+ */
+void payloadReset(PayloadSlab *slab) {
+    atomic_store(&slab->allocated, 0);
+    atomic_store(&slab->released, 0);
+}
+
+/**
+ * Locate a payload an entry's worker sent (oss side)
+ * @param slots Entries in the arena
+ * @return The payload, or NULL if the descriptor does not lie inside the
+ *         entry's slab
+ */
+const void *payloadAt(PayloadSlab *slabs, int slots, int slot, uint32_t offset, uint32_t length) {
+    if (slot < 0 || slot >= slots || length == 0) {
+        return NULL;
+    }
+    PayloadSlab *slab = &slabs[slot];
+    if (length > PAYLOAD_SLAB_SIZE || offset < slab->base || offset - slab->base > PAYLOAD_SLAB_SIZE - length) {
+        return NULL;
+    }
+    return slab->data + (offset - slab->base);
+}
+
+/**
+ * Give a payload's space back to the worker (oss side). Payloads are
+ * released in the order they were allocated; the span between the last
+ * release and this payload is a tail the worker skipped.
+ */
+void payloadRelease(PayloadSlab *slab, uint32_t offset, uint32_t length) {
+    uint32_t released = atomic_load_explicit(&slab->released, memory_order_relaxed);
+    uint32_t position = offset - slab->base;
+    uint32_t skipped = (position - released % PAYLOAD_SLAB_SIZE) % PAYLOAD_SLAB_SIZE;
+    atomic_store_explicit(&slab->released, released + skipped + payloadSpan(length), memory_order_release);
+}
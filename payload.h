@@ -0,0 +1,44 @@
+#ifndef PAYLOAD_H
+#define PAYLOAD_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include "transport.h"
+
+#define PAYLOAD_SLAB_SIZE 1024      // Bytes of the arena per process table entry (power of two)
+#define PAYLOAD_ALIGN 8             // Payloads start on 8-byte boundaries
+
+// One entry's slab of the payload arena: a byte ring the entry's worker
+// allocates payloads from and oss releases once it has read them. A
+// payload never wraps; the worker skips the slab's tail instead. Replies
+// carry the payload's offset in the arena and its length, so the data
+// itself never passes through the message queue or the mailbox rings.
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic uint32_t allocated;    // Bytes handed out (worker)
+    _Atomic uint32_t dropped;                           // Payloads that found no room
+    uint32_t base;                                      // Arena offset of data, set by oss
+    _Alignas(CACHE_LINE) _Atomic uint32_t released;     // Bytes given back (oss)
+    _Alignas(CACHE_LINE) unsigned char data[PAYLOAD_SLAB_SIZE];
+} PayloadSlab;
+
+// What a worker reports about each quantum (oss -W)
+typedef struct {
+    uint32_t iterations;    // Quanta completed, this one included
+    int32_t error;          // errno of a failure the worker hit, 0 if none
+    uint64_t clockNs;       // Simulated clock the worker read
+    uint64_t workNs;        // Wall time of the quantum's workload
+    uint32_t kernels;       // Kernels sampled, one bit per WorkloadKernel
+    uint32_t sampleCount;   // Samples that follow
+    uint64_t samples[];     // Wall ns of each sampled kernel, in kernel order
+} WorkerReport;
+
+// Worker side
+void *payloadReserve(PayloadSlab *slab, uint32_t length, uint32_t *offset);
+
+// oss side
+void payloadArenaInit(PayloadSlab *slabs, int slots);
+void payloadReset(PayloadSlab *slab);
+const void *payloadAt(PayloadSlab *slabs, int slots, int slot, uint32_t offset, uint32_t length);
+void payloadRelease(PayloadSlab *slab, uint32_t offset, uint32_t length);
+
+#endif /* PAYLOAD_H */
@@ -0,0 +1,261 @@
+#include <stdlib.h>
+#include <string.h>
+#include "pcbtable.h"
+
+/**
+ * Home bucket of a PID in the PID index
+ */
+static int pidBucket(const ProcessTable *table, pid_t pid) {
+    return (int)(((uint32_t)pid * 2654435761u) & (uint32_t)table->pidIndexMask);
+}
+
+/**
+ * Insert an occupied entry into the PID index
+ */
+static void pidIndexInsert(ProcessTable *table, int index) {
+    int b = pidBucket(table, table->pid[index]);
+    while (table->pidIndex[b] != -1) {
+        b = (b + 1) & table->pidIndexMask;
+    }
+    table->pidIndex[b] = index;
+}
+
+/**
+ * Remove an entry from the PID index, shifting later probes back so no
+ * tombstones are needed
+ */
+static void pidIndexRemove(ProcessTable *table, int index) {
+    int mask = table->pidIndexMask;
+    int hole = pidBucket(table, table->pid[index]);
+    while (table->pidIndex[hole] != index) {
+        hole = (hole + 1) & mask;
+    }
+
+    int probe = hole;
+    for (;;) {
+        probe = (probe + 1) & mask;
+        int moved = table->pidIndex[probe];
+        if (moved == -1) {
+            break;
+        }
+        // Move the entry back unless its home bucket lies cyclically in (hole, probe]
+        int home = pidBucket(table, table->pid[moved]);
+        if (((probe - home) & mask) >= ((probe - hole) & mask)) {
+            table->pidIndex[hole] = moved;
+            hole = probe;
+        }
+    }
+    table->pidIndex[hole] = -1;
+}
+
+/**
+ * Size the PID index for the current capacity and re-insert every entry
+ * @return 0 on success, -1 on allocation failure
+ */
+static int pidIndexRebuild(ProcessTable *table) {
+    int size = 16;
+    while (size < table->capacity * 2) {
+        size *= 2;
+    }
+
+    int *index = malloc(size * sizeof(int));
+    if (index == NULL) {
+        return -1;
+    }
+    free(table->pidIndex);
+    table->pidIndex = index;
+    table->pidIndexMask = size - 1;
+    memset(table->pidIndex, 0xff, size * sizeof(int));
+
+    for (int i = 0; i < table->capacity; i++) {
+        if (table->occupied[i]) {
+            pidIndexInsert(table, i);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Grow every per-entry array to a new capacity
+ * @return 0 on success, -1 on allocation failure
+ */
+static int pcbTableGrow(ProcessTable *table, int newCapacity) {
+    int oldCapacity = table->capacity;
+
+#define GROW(field) do { \
+        void *p = realloc(table->field, newCapacity * sizeof(*table->field)); \
+        if (p == NULL) return -1; \
+        table->field = p; \
+    } while (0)
+
+    GROW(pid);
+    GROW(occupied);
+    GROW(messagesSent);
+    GROW(pcb);
+    GROW(freeList);
+    GROW(ringNext);
+    GROW(ringPrev);
+#undef GROW
+
+    for (int i = oldCapacity; i < newCapacity; i++) {
+        table->pid[i] = 0;
+        table->occupied[i] = 0;
+        table->messagesSent[i] = 0;
+        memset(&table->pcb[i], 0, sizeof(struct PCB));
+        table->ringNext[i] = -1;
+        table->ringPrev[i] = -1;
+    }
+
+    // Push new entries highest first so the lowest index is handed out next
+    for (int i = newCapacity - 1; i >= oldCapacity; i--) {
+        table->freeList[table->freeCount++] = i;
+    }
+
+    table->capacity = newCapacity;
+    return pidIndexRebuild(table);
+}
+
+/**
+ * Initialize an empty process table
+ * @param initialCapacity Entries to allocate up front
+ * @param maxCapacity Upper bound the table may grow to
+ * @return 0 on success, -1 on allocation failure
+ */
+int pcbTableInit(ProcessTable *table, int initialCapacity, int maxCapacity) {
+    memset(table, 0, sizeof(*table));
+    table->maxCapacity = maxCapacity;
+    table->ringHead = -1;
+    table->cursor = -1;
+
+    if (initialCapacity > maxCapacity) {
+        initialCapacity = maxCapacity;
+    }
+    return pcbTableGrow(table, initialCapacity);
+}
+
+/**
+ * Release all memory held by the table
+ */
+void pcbTableFree(ProcessTable *table) {
+    free(table->pid);
+    free(table->occupied);
+    free(table->messagesSent);
+    free(table->pcb);
+    free(table->freeList);
+    free(table->ringNext);
+    free(table->ringPrev);
+    free(table->pidIndex);
+    memset(table, 0, sizeof(*table));
+}
+
+/**
+ * Take a free entry off the free list, growing the table if needed
+ * @return Index of the reserved entry, or -1 if the table is full
+ */
+int pcbReserve(ProcessTable *table) {
+    if (table->freeCount == 0) {
+        if (table->capacity >= table->maxCapacity) {
+            return -1;
+        }
+        int newCapacity = table->capacity * 2;
+        if (newCapacity > table->maxCapacity) {
+            newCapacity = table->maxCapacity;
+        }
+        if (pcbTableGrow(table, newCapacity) == -1) {
+            return -1;
+        }
+    }
+    return table->freeList[--table->freeCount];
+}
+
+/**
+ * Return a reserved entry that was never activated to the free list
+ */
+void pcbUnreserve(ProcessTable *table, int index) {
+    table->freeList[table->freeCount++] = index;
+}
+
+/**
+ * Mark a reserved entry occupied by pid and append it to the active ring
+ */
+void pcbActivate(ProcessTable *table, int index, pid_t pid) {
+    table->pid[index] = pid;
+    table->occupied[index] = 1;
+    table->messagesSent[index] = 0;
+    pidIndexInsert(table, index);
+
+    if (table->ringHead == -1) {
+        table->ringNext[index] = index;
+        table->ringPrev[index] = index;
+        table->ringHead = index;
+    } else {
+        // Insert before the head, i.e. at the tail of the round-robin order
+        int tail = table->ringPrev[table->ringHead];
+        table->ringNext[tail] = index;
+        table->ringPrev[index] = tail;
+        table->ringNext[index] = table->ringHead;
+        table->ringPrev[table->ringHead] = index;
+    }
+    table->activeCount++;
+}
+
+/**
+ * Mark an entry free, unlink it from the active ring and recycle it
+ */
+void pcbRelease(ProcessTable *table, int index) {
+    if (!table->occupied[index]) {
+        return;
+    }
+
+    pidIndexRemove(table, index);
+
+    int next = table->ringNext[index];
+    int prev = table->ringPrev[index];
+    if (next == index) {
+        table->ringHead = -1;
+        table->cursor = -1;
+    } else {
+        table->ringNext[prev] = next;
+        table->ringPrev[next] = prev;
+        if (table->ringHead == index) {
+            table->ringHead = next;
+        }
+        // Keep the round-robin position: the successor is still next in line
+        if (table->cursor == index) {
+            table->cursor = prev;
+        }
+    }
+    table->ringNext[index] = -1;
+    table->ringPrev[index] = -1;
+
+    table->occupied[index] = 0;
+    table->activeCount--;
+    table->freeList[table->freeCount++] = index;
+}
+
+/**
+ * Advance the round-robin cursor to the next occupied entry
+ * @return Index of the next entry, or -1 if none are occupied
+ */
+int pcbNextActive(ProcessTable *table) {
+    if (table->ringHead == -1) {
+        return -1;
+    }
+    table->cursor = (table->cursor == -1) ? table->ringHead : table->ringNext[table->cursor];
+    return table->cursor;
+}
+
+/**
+ * Look up the occupied entry belonging to a PID
+ * @return Index of the entry, or -1 if no occupied entry has this PID
+ */
+int pcbFindByPid(const ProcessTable *table, pid_t pid) {
+    int b = pidBucket(table, pid);
+    while (table->pidIndex[b] != -1) {
+        if (table->pid[table->pidIndex[b]] == pid) {
+            return table->pidIndex[b];
+        }
+        b = (b + 1) & table->pidIndexMask;
+    }
+    return -1;
+}
@@ -0,0 +1,49 @@
+#ifndef PCBTABLE_H
+#define PCBTABLE_H
+
+#include <sys/types.h>
+#include "common.h"
+
+#define PCB_TABLE_INITIAL 20  // Entries allocated before the table first grows
+
+// Growable process table. The fields touched on every dispatch are kept
+// as parallel arrays (struct-of-arrays) so scans stay within a few cache
+// lines; per-entry data used only at launch and display lives in pcb[].
+typedef struct {
+    int capacity;           // Entries currently allocated
+    int maxCapacity;        // Upper bound on entries (simultaneous limit)
+    int activeCount;        // Occupied entries, maintained on every change
+
+    // Hot per-entry fields
+    pid_t *pid;             // process id of this child
+    unsigned char *occupied;  // either true (1) or false (0)
+    uint64_t *messagesSent; // total times oss sent a message to this process
+
+    // Cold per-entry fields
+    struct PCB *pcb;
+
+    // Free entries, used as a stack for O(1) allocation
+    int *freeList;
+    int freeCount;
+
+    // Intrusive circular list of occupied entries for round-robin
+    int *ringNext;
+    int *ringPrev;
+    int ringHead;           // -1 when no entry is occupied
+    int cursor;             // Entry most recently handed out by pcbNextActive
+
+    // PID -> entry index (open addressing, linear probing)
+    int *pidIndex;
+    int pidIndexMask;
+} ProcessTable;
+
+int pcbTableInit(ProcessTable *table, int initialCapacity, int maxCapacity);
+void pcbTableFree(ProcessTable *table);
+int pcbReserve(ProcessTable *table);
+void pcbActivate(ProcessTable *table, int index, pid_t pid);
+void pcbUnreserve(ProcessTable *table, int index);
+void pcbRelease(ProcessTable *table, int index);
+int pcbNextActive(ProcessTable *table);
+int pcbFindByPid(const ProcessTable *table, pid_t pid);
+
+#endif /* PCBTABLE_H */
@@ -0,0 +1,287 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "placement.h"
+
+#define CACHE_INDEXES 8     // cache/indexN directories probed per CPU
+
+static PlacementPolicy placementPolicy = PLACE_NONE;
+static int placementActive = 0;     // Any placement option was given
+static int dispatcherCpu = -1;      // -1 = dispatcher not pinned to one CPU
+static cpu_set_t dispatcherSet;     // Where the dispatcher runs
+static cpu_set_t workerSet;         // Where workers run
+static int workerCpus[CPU_SETSIZE]; // CPUs of workerSet in ascending order
+static int workerCpuCount = 0;
+static int clusterCpu = -1;         // CPU whose cache cluster workers are packed on
+
+/**
+ * Parse a placement policy name given on the command line
+ * @return 0 on success, -1 if the name is unknown
+ */
+int parsePlacementPolicy(const char *name, PlacementPolicy *policy) {
+    if (strcmp(name, "spread") == 0) {
+        *policy = PLACE_SPREAD;
+    } else if (strcmp(name, "pack") == 0) {
+        *policy = PLACE_PACK;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Name of a placement policy for logs and statistics
+ */
+const char *placementPolicyName(PlacementPolicy policy) {
+    switch (policy) {
+        case PLACE_SPREAD:
+            return "spread";
+        case PLACE_PACK:
+            return "pack";
+        default:
+            return "none";
+    }
+}
+
+/**
+ * Parse a CPU list such as "0-3,8,10-11" (the format of sysfs and taskset -c)
+ * @return 0 on success, -1 with errno EINVAL if the list is malformed
+ */
+static int parseCpuList(const char *list, cpu_set_t *set) {
+    CPU_ZERO(set);
+    const char *p = list;
+
+    while (*p != '\0' && *p != '\n') {
+        char *end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p) {
+            errno = EINVAL;
+            return -1;
+        }
+        if (*end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+            if (end == p) {
+                errno = EINVAL;
+                return -1;
+            }
+        }
+        if (first < 0 || last < first || last >= CPU_SETSIZE) {
+            errno = EINVAL;
+            return -1;
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            CPU_SET(cpu, set);
+        }
+        p = end;
+        if (*p == ',') {
+            p++;
+        } else if (*p != '\0' && *p != '\n') {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Format a CPU set as a CPU list ("0-3,8")
+ */
+static void formatCpuList(const cpu_set_t *set, char *out, size_t size) {
+    size_t len = 0;
+    out[0] = '\0';
+
+    for (int cpu = 0; cpu < CPU_SETSIZE && len < size; cpu++) {
+        if (!CPU_ISSET(cpu, set)) {
+            continue;
+        }
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, set)) {
+            last++;
+        }
+        len += snprintf(out + len, size - len, last > cpu ? "%s%d-%d" : "%s%d",
+                        len > 0 ? "," : "", cpu, last);
+        cpu = last;
+    }
+}
+
+/**
+ * CPUs sharing a CPU's last-level cache, from sysfs
+ * @return 0 on success, -1 if the cache topology is not available
+ */
+static int cacheCluster(int cpu, cpu_set_t *cluster) {
+    int bestLevel = -1;
+    char path[128], line[256];
+
+    for (int index = 0; index < CACHE_INDEXES; index++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+        FILE *f = fopen(path, "r");
+        if (f == NULL) {
+            continue;
+        }
+        int level = 0;
+        int ok = fscanf(f, "%d", &level) == 1;
+        fclose(f);
+        if (!ok || level <= bestLevel) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+        f = fopen(path, "r");
+        if (f == NULL) {
+            continue;
+        }
+        ok = fgets(line, sizeof(line), f) != NULL;
+        fclose(f);
+        if (ok && parseCpuList(line, cluster) == 0 && CPU_COUNT(cluster) > 0) {
+            bestLevel = level;
+        }
+    }
+    return bestLevel == -1 ? -1 : 0;
+}
+
+/**
+ * Work out where the dispatcher and the workers run
+ * @param cpu CPU to pin the dispatcher to, or -1
+ * @param cpuList CPUs workers may use, or NULL for every CPU oss may use
+ * @param policy How workers are placed within their CPUs
+ * @return 0 on success, -1 with errno EINVAL if a CPU is not available
+ */
+int placementInit(int cpu, const char *cpuList, PlacementPolicy policy) {
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1) {
+        return -1;
+    }
+
+    placementPolicy = policy;
+    placementActive = cpu >= 0 || cpuList != NULL || policy != PLACE_NONE;
+    dispatcherCpu = cpu;
+    dispatcherSet = allowed;
+    workerSet = allowed;
+
+    if (cpu >= 0) {
+        if (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed)) {
+            errno = EINVAL;
+            return -1;
+        }
+        CPU_ZERO(&dispatcherSet);
+        CPU_SET(cpu, &dispatcherSet);
+    }
+
+    if (cpuList != NULL) {
+        cpu_set_t requested;
+        if (parseCpuList(cpuList, &requested) == -1) {
+            return -1;
+        }
+        CPU_AND(&workerSet, &requested, &allowed);
+        if (!CPU_EQUAL(&workerSet, &requested) || CPU_COUNT(&workerSet) == 0) {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+
+    // Packing keeps workers and the dispatcher on one last-level cache
+    if (policy == PLACE_PACK) {
+        clusterCpu = cpu >= 0 ? cpu : sched_getcpu();
+        cpu_set_t cluster;
+        if (clusterCpu >= 0 && cacheCluster(clusterCpu, &cluster) == 0) {
+            cpu_set_t packed;
+            CPU_AND(&packed, &workerSet, &cluster);
+            if (CPU_COUNT(&packed) > 0) {
+                workerSet = packed;
+            }
+            if (cpu < 0) {
+                CPU_AND(&dispatcherSet, &dispatcherSet, &cluster);
+            }
+        } else {
+            clusterCpu = -1;    // No topology: pack degenerates to the worker CPU set
+        }
+    }
+
+    // Keep workers off the dispatcher's CPU when there is anywhere else to go
+    if (cpu >= 0 && CPU_ISSET(cpu, &workerSet) && CPU_COUNT(&workerSet) > 1) {
+        CPU_CLR(cpu, &workerSet);
+    }
+
+    workerCpuCount = 0;
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, &workerSet)) {
+            workerCpus[workerCpuCount++] = c;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Restrict the calling thread (the dispatcher) to its CPU. Threads started
+ * earlier, such as the log writer and the dispatcher shards (-m), keep the
+ * original affinity.
+ * @return 0 on success (or nothing to do), -1 on failure
+ */
+int placementPinDispatcher(void) {
+    if (dispatcherCpu < 0 && placementPolicy != PLACE_PACK) {
+        return 0;
+    }
+    return sched_setaffinity(0, sizeof(dispatcherSet), &dispatcherSet);
+}
+
+/**
+ * CPUs a worker on a process table entry may run on
+ */
+static void workerMask(int slot, cpu_set_t *mask) {
+    if (placementPolicy == PLACE_SPREAD) {
+        CPU_ZERO(mask);
+        CPU_SET(workerCpus[slot % workerCpuCount], mask);
+    } else {
+        *mask = workerSet;
+    }
+}
+
+/**
+ * Place a worker process. Workers started after the dispatcher was pinned
+ * would otherwise inherit its CPU, so every worker gets an explicit mask
+ * once any placement option is given.
+ * @param pid Worker process, or 0 for the calling process or thread
+ * @param slot Process table entry of the worker
+ * @return 0 on success (or nothing to do), -1 on failure
+ */
+int placementApply(pid_t pid, int slot) {
+    if (!placementActive) {
+        return 0;
+    }
+    cpu_set_t mask;
+    workerMask(slot, &mask);
+    return sched_setaffinity(pid, sizeof(mask), &mask);
+}
+
+/**
+ * CPU a worker on an entry is pinned to
+ * @return The CPU, or -1 if workers are not pinned to single CPUs
+ */
+int placementWorkerCpu(int slot) {
+    return placementPolicy == PLACE_SPREAD ? workerCpus[slot % workerCpuCount] : -1;
+}
+
+/**
+ * One-line description of the placement for the log and statistics
+ */
+void placementDescribe(char *out, size_t size) {
+    if (!placementActive) {
+        snprintf(out, size, "none (kernel default)");
+        return;
+    }
+
+    char dispatcher[256], workers[256];
+    formatCpuList(&dispatcherSet, dispatcher, sizeof(dispatcher));
+    formatCpuList(&workerSet, workers, sizeof(workers));
+
+    int len = snprintf(out, size, "dispatcher on CPU %s, workers on CPU %s (%s)", dispatcher, workers,
+                       placementPolicyName(placementPolicy));
+    if (clusterCpu >= 0 && len > 0 && (size_t)len < size) {
+        snprintf(out + len, size - len, " (last-level cache of CPU %d)", clusterCpu);
+    }
+}
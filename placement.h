@@ -0,0 +1,23 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+// Where worker processes (and thread workers) are allowed to run
+typedef enum {
+    PLACE_NONE,             // Leave placement to the kernel (default)
+    PLACE_SPREAD,           // Entry i is pinned to CPU i mod |set| of the worker CPU set
+    PLACE_PACK              // Any CPU sharing the dispatcher's last-level cache
+} PlacementPolicy;
+
+int parsePlacementPolicy(const char *name, PlacementPolicy *policy);
+const char *placementPolicyName(PlacementPolicy policy);
+
+int placementInit(int dispatcherCpu, const char *cpuList, PlacementPolicy policy);
+int placementPinDispatcher(void);
+int placementApply(pid_t pid, int slot);
+int placementWorkerCpu(int slot);
+void placementDescribe(char *out, size_t size);
+
+#endif /* PLACEMENT_H */
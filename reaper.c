@@ -0,0 +1,219 @@
+#define _GNU_SOURCE    // pipe2
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include "reaper.h"
+
+static int epollFd = -1;
+static int selfPipe[2] = { -1, -1 };    // SIGCHLD handler -> epoll
+static volatile sig_atomic_t childEvents = 0;
+static int liveChildren = 0;            // Started but not yet collected
+static ChildWakeCallback wakeCallback = NULL;
+
+// Exits of workers that are not our children (reaperReportExit), delivered
+// by the next poll
+typedef struct {
+    pid_t pid;
+    int status;
+} ReportedExit;
+
+static ReportedExit *reported = NULL;
+static int reportedCount = 0;
+static int reportedCapacity = 0;
+
+/**
+ * SIGCHLD handler: record the event, make the self-pipe readable and let
+ * the owner interrupt any blocking receive
+ */
+static void sigchldHandler(int sig) {
+    int savedErrno = errno;
+    char byte = 0;
+
+    (void)sig;
+    childEvents = 1;
+    if (write(selfPipe[1], &byte, 1) == -1) {
+        // Pipe full: a wakeup is already pending
+    }
+    if (wakeCallback != NULL) {
+        wakeCallback();
+    }
+    errno = savedErrno;
+}
+
+/**
+ * Set up event-driven reaping: a SIGCHLD self-pipe registered with epoll.
+ * Ordinary syscalls are restarted after the handler; the wake callback is
+ * how a blocking receive in the dispatch loop learns about an exit.
+ * @param wake Async-signal-safe callback run on every SIGCHLD (may be NULL)
+ * @return 0 on success, -1 on failure
+ */
+int reaperInit(ChildWakeCallback wake) {
+    wakeCallback = wake;
+
+    if (pipe2(selfPipe, O_NONBLOCK | O_CLOEXEC) == -1) {
+        return -1;
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1) {
+        return -1;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = selfPipe[0];
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, selfPipe[0], &ev) == -1) {
+        return -1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = sigchldHandler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    return sigaction(SIGCHLD, &sa, NULL);
+}
+
+/**
+ * Account for a newly started child process
+ */
+void reaperChildStarted(void) {
+    liveChildren++;
+}
+
+/**
+ * Number of child processes not yet collected
+ */
+int reaperLiveChildren(void) {
+    return liveChildren;
+}
+
+/**
+ * Whether a SIGCHLD arrived since the last poll (no syscall)
+ */
+int reaperPending(void) {
+    return childEvents;
+}
+
+/**
+ * Report the exit of a worker that is not a child of this process (it ran
+ * on a worker agent); the next reaperPoll delivers it like a collected
+ * child, with zero resource usage
+ */
+void reaperReportExit(pid_t pid, int status) {
+    if (reportedCount == reportedCapacity) {
+        int capacity = reportedCapacity > 0 ? reportedCapacity * 2 : 16;
+        ReportedExit *grown = realloc(reported, capacity * sizeof(ReportedExit));
+        if (grown == NULL) {
+            perror("reaperReportExit");
+            return;
+        }
+        reported = grown;
+        reportedCapacity = capacity;
+    }
+    reported[reportedCount].pid = pid;
+    reported[reportedCount].status = status;
+    reportedCount++;
+    childEvents = 1;
+}
+
+/**
+ * Deliver the reported exits, then collect every child that has exited
+ * without blocking
+ * @return Number of exits delivered
+ */
+static int collectExited(ReapCallback onExit) {
+    int collected = 0;
+    int status;
+    struct rusage usage;
+    pid_t pid;
+
+    memset(&usage, 0, sizeof(usage));
+    for (int i = 0; i < reportedCount; i++) {
+        collected++;
+        if (onExit != NULL) {
+            onExit(reported[i].pid, reported[i].status, &usage);
+        }
+    }
+    reportedCount = 0;
+
+    while ((pid = wait4(-1, &status, WNOHANG, &usage)) > 0) {
+        liveChildren--;
+        collected++;
+        if (onExit != NULL) {
+            onExit(pid, status, &usage);
+        }
+    }
+    return collected;
+}
+
+/**
+ * Wait up to timeoutMs for child exits, then collect every exited child
+ * @param timeoutMs 0 to poll, -1 to wait indefinitely
+ * @return Number of children collected
+ */
+int reaperPoll(int timeoutMs, ReapCallback onExit) {
+    if (epollFd == -1) {
+        return 0;
+    }
+
+    if (!childEvents && timeoutMs != 0) {
+        struct epoll_event ev;
+        epoll_wait(epollFd, &ev, 1, timeoutMs);
+    }
+
+    // Drain the self-pipe before collecting so no exit is missed
+    char buf[64];
+    childEvents = 0;
+    while (read(selfPipe[0], buf, sizeof(buf)) > 0) {
+    }
+
+    return collectExited(onExit);
+}
+
+/**
+ * Block until every remaining child has been collected
+ */
+void reaperWaitAll(ReapCallback onExit) {
+    int status;
+    struct rusage usage;
+    pid_t pid;
+
+    while (liveChildren > 0) {
+        pid = wait4(-1, &status, 0, &usage);
+        if (pid > 0) {
+            liveChildren--;
+            if (onExit != NULL) {
+                onExit(pid, status, &usage);
+            }
+        } else if (errno == ECHILD) {
+            liveChildren = 0;
+        }
+    }
+}
+
+/**
+ * Close the reaper's descriptors and drop undelivered reported exits
+ */
+void reaperClose(void) {
+    free(reported);
+    reported = NULL;
+    reportedCount = reportedCapacity = 0;
+    if (epollFd != -1) {
+        close(epollFd);
+        epollFd = -1;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (selfPipe[i] != -1) {
+            close(selfPipe[i]);
+            selfPipe[i] = -1;
+        }
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef REAPER_H
+#define REAPER_H
+
+#include <sys/resource.h>
+#include <sys/types.h>
+
+// Called for every child collected by the reaper, with its resource usage
+typedef void (*ReapCallback)(pid_t pid, int status, const struct rusage *usage);
+
+// Called from the SIGCHLD handler; must be async-signal-safe
+typedef void (*ChildWakeCallback)(void);
+
+int reaperInit(ChildWakeCallback wake);
+void reaperChildStarted(void);
+int reaperLiveChildren(void);
+int reaperPending(void);
+void reaperReportExit(pid_t pid, int status);
+int reaperPoll(int timeoutMs, ReapCallback onExit);
+void reaperWaitAll(ReapCallback onExit);
+void reaperClose(void);
+
+#endif /* REAPER_H */
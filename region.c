@@ -0,0 +1,316 @@
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "region.h"
+
+#define HUGE_PAGE_SIZE (2UL * 1024 * 1024)  // x86-64 default huge page
+
+/**
+ * Round up to a multiple of a power of two
+ */
+static size_t alignUp(size_t value, size_t to) {
+    return (value + to - 1) & ~(to - 1);
+}
+
+/**
+ * Point a region's section pointers at a mapping and check its header
+ * @return 0 on success, -1 with errno EINVAL if it is not an oss region
+ */
+static int regionBind(Region *region, void *base, size_t size) {
+    RegionHeader *h = base;
+    if (size < sizeof(RegionHeader) || h->version != REGION_VERSION || h->size > size ||
+        h->statsOffset + STATS_SEGMENT_SIZE(h->slots) > h->size ||
+        h->logOffset + (size_t)h->slots * sizeof(WorkerLogRing) > h->size ||
+        h->payloadOffset + (size_t)h->slots * sizeof(PayloadSlab) > h->size) {
+        errno = EINVAL;
+        return -1;
+    }
+    region->header = h;
+    region->size = size;
+    region->clock = (SystemClock *)((char *)base + h->clockOffset);
+    region->control = (ControlLine *)((char *)base + h->controlOffset);
+    region->mailboxes = (MailboxSegment *)((char *)base + h->mailboxOffset);
+    region->stats = (StatsSegment *)((char *)base + h->statsOffset);
+    region->logs = (WorkerLogRing *)((char *)base + h->logOffset);
+    region->payloads = (PayloadSlab *)((char *)base + h->payloadOffset);
+    return 0;
+}
+
+/**
+ * Create and map the control region: header, clock, one control line per
+ * entry, the shared-memory mailboxes, the statistics segment, one worker
+ * log ring per entry and the payload arena, each starting on its own cache
+ * line
+ * @param slots Process table entries
+ * @param hugePages Back the region with huge pages if the system has them,
+ *                  otherwise advise transparent huge pages
+ * @return 0 on success, -1 with errno set
+ */
+int regionCreate(Region *region, int slots, int hugePages) {
+    memset(region, 0, sizeof(*region));
+    region->fd = -1;
+
+    size_t clockOffset = alignUp(sizeof(RegionHeader), CACHE_LINE);
+    size_t controlOffset = alignUp(clockOffset + sizeof(SystemClock), CACHE_LINE);
+    size_t mailboxOffset = alignUp(controlOffset + (size_t)slots * sizeof(ControlLine), CACHE_LINE);
+    size_t statsOffset = alignUp(mailboxOffset + MAILBOX_SEGMENT_SIZE(slots), CACHE_LINE);
+    size_t logOffset = alignUp(statsOffset + STATS_SEGMENT_SIZE(slots), CACHE_LINE);
+    size_t payloadOffset = alignUp(logOffset + (size_t)slots * sizeof(WorkerLogRing), CACHE_LINE);
+    size_t used = payloadOffset + (size_t)slots * sizeof(PayloadSlab);
+
+    uint32_t backing = REGION_PAGES;
+    void *base = MAP_FAILED;
+    size_t size = 0;
+
+    if (hugePages) {
+        char name[64];
+        snprintf(name, sizeof(name), "oss.%d", getpid());
+        size = alignUp(used, HUGE_PAGE_SIZE);
+        region->fd = memfd_create(name, MFD_HUGETLB);
+        if (region->fd != -1 && ftruncate(region->fd, size) == 0) {
+            base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, region->fd, 0);
+        }
+        if (base != MAP_FAILED) {
+            backing = REGION_HUGETLB;
+        } else if (region->fd != -1) {
+            close(region->fd);      // No huge pages reserved: fall back below
+            region->fd = -1;
+        }
+    }
+
+    if (base == MAP_FAILED) {
+        snprintf(region->name, sizeof(region->name), "/oss.%d", getpid());
+        size = alignUp(used, sysconf(_SC_PAGESIZE));
+        region->fd = shm_open(region->name, O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (region->fd == -1) {
+            region->name[0] = '\0';
+            return -1;
+        }
+        if (ftruncate(region->fd, size) == -1) {
+            regionDestroy(region);
+            return -1;
+        }
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, region->fd, 0);
+        if (base == MAP_FAILED) {
+            regionDestroy(region);
+            return -1;
+        }
+        if (hugePages && madvise(base, size, MADV_HUGEPAGE) == 0) {
+            backing = REGION_THP;
+        }
+    }
+
+    // Worker processes inherit the descriptor (shm_open sets FD_CLOEXEC)
+    fcntl(region->fd, F_SETFD, 0);
+
+    RegionHeader *h = base;
+    memset(base, 0, used);
+    h->version = REGION_VERSION;
+    h->size = size;
+    h->slots = slots;
+    h->ossPid = getpid();
+    h->backing = backing;
+    h->clockOffset = clockOffset;
+    h->controlOffset = controlOffset;
+    h->mailboxOffset = mailboxOffset;
+    h->statsOffset = statsOffset;
+    h->logOffset = logOffset;
+    h->payloadOffset = payloadOffset;
+    regionBind(region, base, size);
+    payloadArenaInit(region->payloads, slots);
+
+    atomic_thread_fence(memory_order_release);
+    h->magic = REGION_MAGIC;        // Set last: tools wait for it
+    return 0;
+}
+
+/**
+ * Unmap and remove the control region (oss)
+ */
+void regionDestroy(Region *region) {
+    regionDetach(region);
+    if (region->name[0] != '\0') {
+        shm_unlink(region->name);
+        region->name[0] = '\0';
+    }
+}
+
+/**
+ * Map a region from an inherited descriptor (worker processes)
+ * @return 0 on success, -1 with errno set
+ */
+int regionAttachFd(Region *region, int fd, int writable) {
+    memset(region, 0, sizeof(*region));
+    region->fd = -1;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        return -1;
+    }
+    void *base = mmap(NULL, st.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        return -1;
+    }
+    if (regionBind(region, base, st.st_size) == -1) {
+        munmap(base, st.st_size);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Map a region read-only by path: /dev/shm/oss.<pid>, or /proc/<pid>/fd/<n>
+ * for a huge page (memfd) region
+ * @return 0 on success, -1 with errno set
+ */
+int regionAttachPath(Region *region, const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+    int rc = regionAttachFd(region, fd, 0);
+    close(fd);
+    return rc;
+}
+
+/**
+ * Unmap the region and close its descriptor
+ */
+void regionDetach(Region *region) {
+    if (region->header != NULL) {
+        munmap(region->header, region->size);
+        region->header = NULL;
+    }
+    if (region->fd != -1) {
+        close(region->fd);
+        region->fd = -1;
+    }
+}
+
+/**
+ * Process start time (clock ticks since boot) from /proc, 0 if unknown
+ */
+static unsigned long long processStart(pid_t pid) {
+    char path[64], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return 0;
+    }
+    size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[len] = '\0';
+
+    unsigned long long start = 0;
+    char *p = strrchr(buf, ')');
+    if (p == NULL || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu",
+                            &start) != 1) {
+        return 0;
+    }
+    return start;
+}
+
+/**
+ * Path through which a running oss's region can be opened: any descriptor
+ * of the process that refers to /dev/shm/oss.<pid> or memfd:oss.<pid>
+ * @return 0 on success, -1 if the process has no region
+ */
+static int regionPathOf(pid_t pid, char *path, size_t size) {
+    char dirPath[64], linkPath[320], target[256], name[32];
+    snprintf(dirPath, sizeof(dirPath), "/proc/%d/fd", pid);
+    snprintf(name, sizeof(name), "oss.%d", pid);
+
+    DIR *dir = opendir(dirPath);
+    if (dir == NULL) {
+        return -1;
+    }
+    struct dirent *entry;
+    int found = -1;
+    while (found == -1 && (entry = readdir(dir)) != NULL) {
+        snprintf(linkPath, sizeof(linkPath), "%s/%s", dirPath, entry->d_name);
+        ssize_t len = readlink(linkPath, target, sizeof(target) - 1);
+        if (len <= 0) {
+            continue;
+        }
+        target[len] = '\0';
+        const char *base = strrchr(target, '/');
+        base = base != NULL ? base + 1 : target;
+        if (strncmp(base, "memfd:", 6) == 0) {
+            base += 6;
+        }
+        if (strncmp(base, name, strlen(name)) == 0 &&
+            (base[strlen(name)] == '\0' || base[strlen(name)] == ' ')) {
+            snprintf(path, size, "%s", linkPath);
+            found = 0;
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+/**
+ * Find the control region of a running oss
+ * @param ossPid PID of the oss, or 0 for the most recently started one
+ * @param path Set to a path the region can be opened with
+ * @return 0 on success, -1 if no running oss has a region
+ */
+int regionFind(pid_t ossPid, char *path, size_t size) {
+    if (ossPid != 0) {
+        return regionPathOf(ossPid, path, size);
+    }
+
+    DIR *proc = opendir("/proc");
+    if (proc == NULL) {
+        return -1;
+    }
+    struct dirent *entry;
+    unsigned long long newest = 0;
+    int found = -1;
+    while ((entry = readdir(proc)) != NULL) {
+        pid_t pid = atoi(entry->d_name);
+        char comm[64] = "", commPath[64], candidate[320];
+        if (pid <= 0) {
+            continue;
+        }
+        snprintf(commPath, sizeof(commPath), "/proc/%d/comm", pid);
+        FILE *f = fopen(commPath, "r");
+        if (f == NULL) {
+            continue;
+        }
+        int ok = fgets(comm, sizeof(comm), f) != NULL;
+        fclose(f);
+        if (!ok || strcmp(comm, "oss\n") != 0 || regionPathOf(pid, candidate, sizeof(candidate)) == -1) {
+            continue;
+        }
+        unsigned long long start = processStart(pid);
+        if (found == -1 || start >= newest) {
+            snprintf(path, size, "%s", candidate);
+            newest = start;
+            found = 0;
+        }
+    }
+    closedir(proc);
+    return found;
+}
+
+/**
+ * Name of a region backing for logs
+ */
+const char *regionBackingName(uint32_t backing) {
+    switch (backing) {
+        case REGION_HUGETLB:
+            return "huge pages";
+        case REGION_THP:
+            return "transparent huge pages advised";
+        default:
+            return "regular pages";
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef REGION_H
+#define REGION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "common.h"
+#include "payload.h"
+#include "statseg.h"
+#include "transport.h"
+#include "workerlog.h"
+
+#define REGION_MAGIC 0x4f535352u    // "OSSR"
+#define REGION_VERSION 4
+
+// Control line states; the state word doubles as the activation futex
+#define CONTROL_IDLE 0              // No lifetime yet (a parked worker waits here)
+#define CONTROL_ASSIGNED 1          // The worker fields are valid; the worker may start
+
+// How the region's memory is backed
+typedef enum {
+    REGION_PAGES,                   // Regular shared memory pages
+    REGION_HUGETLB,                 // Explicit huge pages (memfd, MFD_HUGETLB)
+    REGION_THP                      // Regular pages, transparent huge pages advised
+} RegionBacking;
+
+// One cache line per process table entry: the published part of the PCB.
+// oss writes it; only the worker of that entry reads it, so workers never
+// share a line.
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic uint32_t state;    // CONTROL_IDLE or CONTROL_ASSIGNED
+    uint32_t occupied;
+    pid_t pid;
+    int seconds;                    // Lifetime handed over on activation
+    int nanoseconds;
+    uint64_t startNs;               // Simulated launch time
+    _Atomic uint64_t messagesSent;  // Quanta sent to the occupant
+} ControlLine;
+
+// Start of the region; external tools find everything through the offsets
+typedef struct {
+    uint32_t magic;                 // Set last by oss
+    uint32_t version;
+    uint64_t size;                  // Bytes mapped
+    uint32_t slots;                 // Process table entries
+    pid_t ossPid;
+    uint32_t backing;               // RegionBacking
+    uint32_t workerOutput;          // WorkerOutput, set by oss before any launch
+    uint32_t workerReports;         // Workers send a WorkerReport per quantum (-W), likewise
+    uint64_t clockOffset;
+    uint64_t controlOffset;
+    uint64_t mailboxOffset;
+    uint64_t statsOffset;
+    uint64_t logOffset;
+    uint64_t payloadOffset;
+} RegionHeader;
+
+// A mapping of the region in this process
+typedef struct {
+    RegionHeader *header;           // Start of the mapping
+    size_t size;
+    int fd;                         // Inherited by worker processes, -1 once closed
+    char name[64];                  // shm_open name, "" for a memfd
+    SystemClock *clock;
+    ControlLine *control;
+    MailboxSegment *mailboxes;
+    StatsSegment *stats;
+    WorkerLogRing *logs;            // One per entry (-o ring)
+    PayloadSlab *payloads;          // The payload arena, one slab per entry (-W)
+} Region;
+
+int regionCreate(Region *region, int slots, int hugePages);
+void regionDestroy(Region *region);
+int regionAttachFd(Region *region, int fd, int writable);
+int regionAttachPath(Region *region, const char *path);
+void regionDetach(Region *region);
+int regionFind(pid_t ossPid, char *path, size_t size);
+const char *regionBackingName(uint32_t backing);
+
+#endif /* REGION_H */
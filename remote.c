@@ -0,0 +1,650 @@
+#define _GNU_SOURCE    // accept4, pipe2
+#include <endian.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "remote.h"
+
+#define REMOTE_ACCEPT_POLL_MS 100   // Accept wait between checks for a stop signal
+#define REMOTE_HANDSHAKE_MS 5000    // Longest wait for an agent's HELLO
+
+// One connected worker-agent, with a buffer for each direction
+typedef struct {
+    int fd;                 // -1 once the connection is lost
+    size_t outLength;       // Frames queued in out
+    size_t inLength;        // Bytes received in in, ending in a partial frame
+    unsigned char out[REMOTE_BUFFER];
+    unsigned char in[REMOTE_BUFFER];
+} Agent;
+
+static Agent *agents = NULL;
+static int agentCount = 0;
+static int listenFd = -1;
+static int wakePipe[2] = { -1, -1 };    // remoteInterrupt -> remoteRecv
+static const SystemClock *remoteClock = NULL;
+static RemoteExitCallback exitCallback = NULL;
+static int exitsReported = 0;           // An exit was reported since remoteRecv last looked
+
+// Per process table entry
+static int slotCount = 0;
+static int *slotAgent = NULL;           // Agent running the entry's worker
+static pid_t *slotWorker = NULL;        // Its worker ID, 0 once it is gone
+static uint64_t *slotSentNs = NULL;     // Wall time its last quantum was queued
+static pid_t nextWorkerId = 1;
+
+// Replies received but not yet handed to oss, oldest first
+static Message *replies = NULL;
+static int replyHead = 0;
+static int replyCount = 0;
+static int replyCapacity = 0;
+
+static LatencyHistogram networkHop;     // oss <-> agent share of each round trip
+static LatencyHistogram agentHop;       // agent <-> worker share
+
+/**
+ * Encode a frame into WIRE_FRAME_SIZE bytes, little-endian
+ */
+void wireEncode(const WireFrame *frame, unsigned char *out) {
+    uint16_t slot = htole16(frame->slot);
+    uint32_t value = htole32((uint32_t)frame->value);
+    uint64_t clockNs = htole64(frame->clockNs);
+    uint64_t arg = htole64(frame->arg);
+
+    out[0] = frame->type;
+    out[1] = 0;
+    memcpy(out + 2, &slot, sizeof(slot));
+    memcpy(out + 4, &value, sizeof(value));
+    memcpy(out + 8, &clockNs, sizeof(clockNs));
+    memcpy(out + 16, &arg, sizeof(arg));
+}
+
+/**
+ * Decode WIRE_FRAME_SIZE bytes written by wireEncode
+ */
+void wireDecode(const unsigned char *in, WireFrame *frame) {
+    uint16_t slot;
+    uint32_t value;
+    uint64_t clockNs, arg;
+
+    memcpy(&slot, in + 2, sizeof(slot));
+    memcpy(&value, in + 4, sizeof(value));
+    memcpy(&clockNs, in + 8, sizeof(clockNs));
+    memcpy(&arg, in + 16, sizeof(arg));
+    frame->type = in[0];
+    frame->slot = le16toh(slot);
+    frame->value = (int32_t)le32toh(value);
+    frame->clockNs = le64toh(clockNs);
+    frame->arg = le64toh(arg);
+}
+
+/**
+ * Resolve host:port (or just port) into a socket address
+ * @param passive Listening address: a bare port means every interface, not loopback
+ * @return 0 on success, -1 with errno set
+ */
+int wireParseAddress(const char *text, int passive, struct sockaddr_storage *addr, socklen_t *length) {
+    char host[256];
+    const char *port = strrchr(text, ':');
+    const char *node = NULL;
+
+    if (port == NULL) {
+        port = text;
+    } else {
+        size_t hostLength = (size_t)(port - text);
+        if (hostLength >= sizeof(host)) {
+            errno = ENAMETOOLONG;
+            return -1;
+        }
+        memcpy(host, text, hostLength);
+        host[hostLength] = '\0';
+        node = hostLength > 0 ? host : NULL;
+        port++;
+    }
+
+    struct addrinfo hints, *found;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+    if (getaddrinfo(node, port, &hints, &found) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    memcpy(addr, found->ai_addr, found->ai_addrlen);
+    *length = found->ai_addrlen;
+    freeaddrinfo(found);
+    return 0;
+}
+
+/**
+ * Write a whole buffer to a socket; a closed peer is an error, not SIGPIPE
+ * @return 0 on success, -1 with errno set
+ */
+int wireWriteAll(int fd, const void *buf, size_t len) {
+    const unsigned char *p = buf;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * Read exactly len bytes from a socket
+ * @return 0 on success, -1 with errno set (ECONNRESET at end of stream)
+ */
+int wireReadAll(int fd, void *buf, size_t len) {
+    unsigned char *p = buf;
+    while (len > 0) {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * Report the exit of every worker still running on a lost agent and close
+ * its connection
+ */
+static void agentLost(Agent *a) {
+    int index = (int)(a - agents);
+
+    fprintf(stderr, "OSS: Lost worker agent %d\n", index);
+    close(a->fd);
+    a->fd = -1;
+    a->outLength = 0;
+    for (int slot = 0; slot < slotCount; slot++) {
+        if (slotAgent[slot] == index && slotWorker[slot] != 0) {
+            pid_t id = slotWorker[slot];
+            slotWorker[slot] = 0;
+            exitCallback(id, SIGKILL);      // Reported as killed: it is unreachable
+            exitsReported = 1;
+        }
+    }
+}
+
+/**
+ * Send everything queued for an agent in one write
+ * @return 0 on success, -1 if the agent is lost
+ */
+static int flushAgent(Agent *a) {
+    if (a->fd == -1) {
+        return -1;
+    }
+    if (a->outLength == 0) {
+        return 0;
+    }
+    if (wireWriteAll(a->fd, a->out, a->outLength) == -1) {
+        agentLost(a);
+        return -1;
+    }
+    a->outLength = 0;
+    return 0;
+}
+
+/**
+ * Queue a frame for an agent; it goes out with the next flush
+ * @return 0 on success, -1 with errno set if the agent is lost
+ */
+static int queueFrame(Agent *a, const WireFrame *frame) {
+    if (a->outLength + WIRE_FRAME_SIZE > REMOTE_BUFFER && flushAgent(a) == -1) {
+        errno = ECONNRESET;
+        return -1;
+    }
+    if (a->fd == -1) {
+        errno = ECONNRESET;
+        return -1;
+    }
+    wireEncode(frame, a->out + a->outLength);
+    a->outLength += WIRE_FRAME_SIZE;
+    return 0;
+}
+
+/**
+ * Append a reply to the queue remoteRecv hands out
+ * @return 0 on success, -1 on allocation failure
+ */
+static int pushReply(pid_t workerId, int status) {
+    if (replyCount == replyCapacity) {
+        int capacity = replyCapacity * 2;
+        Message *grown = malloc(capacity * sizeof(Message));
+        if (grown == NULL) {
+            return -1;
+        }
+        for (int i = 0; i < replyCount; i++) {
+            grown[i] = replies[(replyHead + i) % replyCapacity];
+        }
+        free(replies);
+        replies = grown;
+        replyHead = 0;
+        replyCapacity = capacity;
+    }
+
+    Message *msg = &replies[(replyHead + replyCount) % replyCapacity];
+    msg->mtype = 0;
+    msg->pid = workerId;
+    msg->status = status;
+    msg->shard = 0;
+    msg->payloadOffset = 0;
+    msg->payloadLength = 0;
+    replyCount++;
+    return 0;
+}
+
+/**
+ * Act on one frame from an agent
+ */
+static void handleFrame(const WireFrame *frame) {
+    if (frame->slot >= slotCount) {
+        fprintf(stderr, "OSS: Ignoring frame for entry %d from a worker agent\n", frame->slot);
+        return;
+    }
+
+    switch (frame->type) {
+        case WIRE_REPLY:
+            // The agent measured its own share of the round trip
+            if (slotWorker[frame->slot] == frame->value) {
+                uint64_t total = monotonicNs() - slotSentNs[frame->slot];
+                latencyRecord(&agentHop, frame->clockNs);
+                latencyRecord(&networkHop, total > frame->clockNs ? total - frame->clockNs : 0);
+            }
+            if (pushReply(frame->value, (int)frame->arg) == -1) {
+                perror("OSS: reply from worker agent");
+            }
+            break;
+        case WIRE_EXIT:
+            if (slotWorker[frame->slot] == frame->value) {
+                slotWorker[frame->slot] = 0;
+            }
+            exitCallback(frame->value, (int)frame->arg);
+            exitsReported = 1;
+            break;
+        default:
+            fprintf(stderr, "OSS: Ignoring frame of type %d from a worker agent\n", frame->type);
+            break;
+    }
+}
+
+/**
+ * Read what an agent has sent and act on every complete frame
+ */
+static void readAgent(Agent *a) {
+    ssize_t n = recv(a->fd, a->in + a->inLength, REMOTE_BUFFER - a->inLength, 0);
+    if (n == 0 || (n == -1 && errno != EINTR && errno != EAGAIN)) {
+        agentLost(a);
+        return;
+    }
+    if (n == -1) {
+        return;
+    }
+    a->inLength += (size_t)n;
+
+    size_t used = 0;
+    while (a->inLength - used >= WIRE_FRAME_SIZE) {
+        WireFrame frame;
+        wireDecode(a->in + used, &frame);
+        used += WIRE_FRAME_SIZE;
+        handleFrame(&frame);
+    }
+
+    // Keep the partial frame at the front
+    memmove(a->in, a->in + used, a->inLength - used);
+    a->inLength -= used;
+}
+
+/**
+ * Take an agent's HELLO and send it the run's configuration
+ * @return 0 on success, -1 with errno set
+ */
+static int handshake(int fd, int slots, int workerOutput, const char *workload) {
+    struct timeval timeout = { REMOTE_HANDSHAKE_MS / 1000, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    unsigned char buf[WIRE_FRAME_SIZE];
+    WireFrame hello;
+    if (wireReadAll(fd, buf, sizeof(buf)) == -1) {
+        return -1;
+    }
+    wireDecode(buf, &hello);
+    if (hello.type != WIRE_HELLO || hello.value != REMOTE_PROTOCOL_VERSION) {
+        errno = EPROTO;
+        return -1;
+    }
+
+    // Receives wait indefinitely from here on; poll decides when to read
+    timeout.tv_sec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    size_t workloadLength = strlen(workload);
+    WireFrame config = { WIRE_CONFIG, 0, workerOutput, (uint64_t)slots, workloadLength };
+    wireEncode(&config, buf);
+    if (wireWriteAll(fd, buf, sizeof(buf)) == -1 || wireWriteAll(fd, workload, workloadLength) == -1) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Listen on address and wait until the given number of worker agents have
+ * connected and taken the run's configuration
+ * @param slots Process table entries; every agent can run a worker on each
+ * @param workerOutput WorkerOutput of the agents' workers
+ * @param workload -w spec handed to the agents' workers, "" for none
+ * @param clock oss's clock; launches and quanta carry its value
+ * @param onExit Called for a worker that exits without a final reply
+ * @param stop Set by oss's signal handlers; stops the wait with EINTR
+ * @return 0 on success, -1 with errno set
+ */
+int remoteStart(const char *address, int wanted, int slots, int workerOutput, const char *workload,
+                const SystemClock *clock, RemoteExitCallback onExit, volatile sig_atomic_t *stop) {
+    remoteClock = clock;
+    exitCallback = onExit;
+    slotCount = slots;
+    latencyReset(&networkHop);
+    latencyReset(&agentHop);
+
+    agents = calloc(wanted, sizeof(Agent));
+    slotAgent = calloc(slots, sizeof(int));
+    slotWorker = calloc(slots, sizeof(pid_t));
+    slotSentNs = calloc(slots, sizeof(uint64_t));
+    replyCapacity = slots + 1;
+    replies = malloc(replyCapacity * sizeof(Message));
+    if (agents == NULL || slotAgent == NULL || slotWorker == NULL || slotSentNs == NULL || replies == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    if (pipe2(wakePipe, O_NONBLOCK | O_CLOEXEC) == -1) {
+        return -1;
+    }
+
+    struct sockaddr_storage addr;
+    socklen_t length;
+    if (wireParseAddress(address, 1, &addr, &length) == -1) {
+        return -1;
+    }
+    listenFd = socket(addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd == -1) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(listenFd, (struct sockaddr *)&addr, length) == -1 || listen(listenFd, wanted) == -1) {
+        return -1;
+    }
+
+    while (agentCount < wanted) {
+        if (*stop) {
+            errno = EINTR;
+            return -1;
+        }
+
+        struct pollfd p = { listenFd, POLLIN, 0 };
+        int rc = poll(&p, 1, REMOTE_ACCEPT_POLL_MS);
+        if (rc == -1 && errno != EINTR) {
+            return -1;
+        }
+        if (rc <= 0) {
+            continue;
+        }
+
+        int fd = accept4(listenFd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            return -1;
+        }
+        if (handshake(fd, slots, workerOutput, workload) == -1) {
+            perror("OSS: worker agent handshake");
+            close(fd);
+            continue;
+        }
+        agents[agentCount].fd = fd;
+        agentCount++;
+    }
+
+    // Later agents are refused rather than left waiting in the backlog
+    close(listenFd);
+    listenFd = -1;
+    return 0;
+}
+
+/**
+ * Start a worker with a lifetime in a process table entry, on the entry's
+ * agent (entry modulo the agent count, or the next one still connected)
+ * @return Worker ID, or -1 with errno set
+ */
+pid_t remoteLaunch(int slot, uint64_t lifetimeNs) {
+    int chosen = -1;
+    for (int k = 0; k < agentCount && chosen == -1; k++) {
+        int index = (slot + k) % agentCount;
+        if (agents[index].fd != -1) {
+            chosen = index;
+        }
+    }
+    if (chosen == -1) {
+        errno = ENOTCONN;
+        return -1;
+    }
+
+    pid_t id = nextWorkerId++;
+    WireFrame frame = { WIRE_LAUNCH, (uint16_t)slot, id, clockRead(remoteClock), lifetimeNs };
+    if (queueFrame(&agents[chosen], &frame) == -1) {
+        return -1;
+    }
+    slotAgent[slot] = chosen;
+    slotWorker[slot] = id;
+    return id;
+}
+
+/**
+ * Queue a quantum for the worker of an entry; it carries the clock
+ * @return 0 on success, -1 with errno ESRCH if the worker is gone
+ */
+int remoteSend(int slot, pid_t workerId) {
+    if (slotWorker[slot] != workerId || agents[slotAgent[slot]].fd == -1) {
+        errno = ESRCH;
+        return -1;
+    }
+
+    WireFrame frame = { WIRE_QUANTUM, (uint16_t)slot, workerId, clockRead(remoteClock), 0 };
+    slotSentNs[slot] = monotonicNs();
+    if (queueFrame(&agents[slotAgent[slot]], &frame) == -1) {
+        errno = ESRCH;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Take the next reply from any agent. Queued frames are sent first, so a
+ * round's quanta leave in one write per agent.
+ * @param wait Block until a reply arrives, or only take those already here
+ * @param deadlineNs Monotonic wall time to stop blocking at, 0 for never
+ * @return 0 on success, -1 with errno EINTR if remoteInterrupt was called or
+ *         a worker exit was reported, EAGAIN if none is ready (wait == 0),
+ *         ETIMEDOUT if none came by the deadline
+ */
+int remoteRecv(Message *msg, int wait, uint64_t deadlineNs) {
+    int interrupted = 0;
+
+    for (;;) {
+        if (replyCount > 0) {
+            *msg = replies[replyHead];
+            replyHead = (replyHead + 1) % replyCapacity;
+            replyCount--;
+            return 0;
+        }
+        if (interrupted) {
+            errno = EINTR;
+            return -1;
+        }
+
+        struct pollfd fds[REMOTE_MAX_AGENTS + 1];
+        Agent *polled[REMOTE_MAX_AGENTS + 1];
+        int count = 0;
+        fds[count].fd = wakePipe[0];
+        fds[count].events = POLLIN;
+        polled[count++] = NULL;
+        for (int i = 0; i < agentCount; i++) {
+            flushAgent(&agents[i]);
+            if (agents[i].fd != -1) {
+                fds[count].fd = agents[i].fd;
+                fds[count].events = POLLIN;
+                polled[count++] = &agents[i];
+            }
+        }
+
+        int timeoutMs = exitsReported || !wait ? 0 : -1;
+        if (timeoutMs == -1 && deadlineNs != 0) {
+            uint64_t now = monotonicNs();
+            if (now >= deadlineNs) {
+                errno = ETIMEDOUT;
+                return -1;
+            }
+            timeoutMs = (int)((deadlineNs - now + NANO_PER_MS - 1) / NANO_PER_MS);
+        }
+        int rc = poll(fds, count, timeoutMs);
+        if (rc == -1) {
+            return -1;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            char buf[64];
+            while (read(wakePipe[0], buf, sizeof(buf)) > 0) {
+            }
+            interrupted = wait;
+        }
+        for (int k = 1; k < count; k++) {
+            if (fds[k].revents != 0) {
+                readAgent(polled[k]);
+            }
+        }
+
+        if (exitsReported) {
+            exitsReported = 0;
+            interrupted = wait;
+        }
+        if (!wait && replyCount == 0) {
+            errno = EAGAIN;
+            return -1;
+        }
+    }
+}
+
+/**
+ * Make a blocked or about-to-block remoteRecv return EINTR.
+ * Async-signal-safe: called from the SIGCHLD handler.
+ */
+int remoteInterrupt(void) {
+    char byte = 0;
+    if (wakePipe[1] != -1 && write(wakePipe[1], &byte, 1) == -1 && errno != EAGAIN) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Tell every agent the run is over, close the connections and release the
+ * tables; safe to call twice
+ */
+void remoteStop(void) {
+    for (int i = 0; i < agentCount; i++) {
+        Agent *a = &agents[i];
+        if (a->fd != -1) {
+            // Whatever is still queued is moot; only the shutdown goes out
+            unsigned char buf[WIRE_FRAME_SIZE];
+            WireFrame frame = { WIRE_SHUTDOWN, 0, 0, 0, 0 };
+            wireEncode(&frame, buf);
+            wireWriteAll(a->fd, buf, sizeof(buf));
+            close(a->fd);
+            a->fd = -1;
+        }
+    }
+    if (listenFd != -1) {
+        close(listenFd);
+        listenFd = -1;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (wakePipe[i] != -1) {
+            close(wakePipe[i]);
+            wakePipe[i] = -1;
+        }
+    }
+    free(agents);
+    free(slotAgent);
+    free(slotWorker);
+    free(slotSentNs);
+    free(replies);
+    agents = NULL;
+    slotAgent = NULL;
+    slotWorker = NULL;
+    slotSentNs = NULL;
+    replies = NULL;
+    agentCount = 0;
+    replyCount = 0;
+}
+
+/**
+ * Agents connected at the start of the run
+ */
+int remoteAgentCount(void) {
+    return agentCount;
+}
+
+/**
+ * Agents still connected
+ */
+int remoteAgentsConnected(void) {
+    int connected = 0;
+    for (int i = 0; i < agentCount; i++) {
+        connected += agents[i].fd != -1;
+    }
+    return connected;
+}
+
+/**
+ * Wall time of each round trip spent between oss and the agent: the round
+ * trip as oss measured it, less the agent's share
+ */
+const LatencyHistogram *remoteNetworkHop(void) {
+    return &networkHop;
+}
+
+/**
+ * Wall time of each round trip spent between the agent and its worker
+ */
+const LatencyHistogram *remoteAgentHop(void) {
+    return &agentHop;
+}
@@ -0,0 +1,68 @@
+#ifndef REMOTE_H
+#define REMOTE_H
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include "common.h"
+#include "latency.h"
+
+#define REMOTE_DEFAULT_ADDRESS "127.0.0.1:7070"   // Where oss listens for worker agents (-X)
+#define REMOTE_MAX_AGENTS 64        // Most agents one oss accepts (-N)
+#define REMOTE_PROTOCOL_VERSION 1
+#define REMOTE_BUFFER (64 * 1024)   // Bytes buffered per connection and direction
+#define WIRE_FRAME_SIZE 24          // Bytes of an encoded frame
+
+// Frame types of the oss <-> worker-agent protocol
+typedef enum {
+    WIRE_HELLO = 1,         // agent -> oss: value = protocol version
+    WIRE_CONFIG,            // oss -> agent: value = WorkerOutput, clockNs = slots,
+                            //   arg = bytes of workload spec that follow
+    WIRE_LAUNCH,            // oss -> agent: start a worker on slot; value = worker ID,
+                            //   clockNs = simulated clock, arg = lifetime ns
+    WIRE_QUANTUM,           // oss -> agent: hand slot a quantum; value = worker ID,
+                            //   clockNs = simulated clock
+    WIRE_REPLY,             // agent -> oss: value = worker ID, arg = status,
+                            //   clockNs = wall ns the agent held the quantum
+    WIRE_EXIT,              // agent -> oss: worker exited without a final reply;
+                            //   value = worker ID, arg = wait status
+    WIRE_SHUTDOWN           // oss -> agent: the run is over
+} WireType;
+
+// One frame; encoded little-endian in WIRE_FRAME_SIZE bytes. Frames are
+// written in batches: everything queued for a connection goes out in one
+// send when the sender is about to wait.
+typedef struct {
+    uint8_t type;           // WireType
+    uint16_t slot;          // Process table entry
+    int32_t value;
+    uint64_t clockNs;
+    uint64_t arg;
+} WireFrame;
+
+// Called when an agent reports that a worker exited without a final reply
+typedef void (*RemoteExitCallback)(pid_t workerId, int status);
+
+// Frame helpers, shared with worker-agent
+void wireEncode(const WireFrame *frame, unsigned char *out);
+void wireDecode(const unsigned char *in, WireFrame *frame);
+int wireParseAddress(const char *text, int passive, struct sockaddr_storage *addr, socklen_t *length);
+int wireWriteAll(int fd, const void *buf, size_t len);
+int wireReadAll(int fd, void *buf, size_t len);
+
+// oss side; all return 0 on success or -1 with errno set unless noted
+int remoteStart(const char *address, int agents, int slots, int workerOutput, const char *workload,
+                const SystemClock *clock, RemoteExitCallback onExit, volatile sig_atomic_t *stop);
+pid_t remoteLaunch(int slot, uint64_t lifetimeNs);
+int remoteSend(int slot, pid_t workerId);
+int remoteRecv(Message *msg, int wait, uint64_t deadlineNs);
+int remoteInterrupt(void);
+void remoteStop(void);
+int remoteAgentCount(void);
+int remoteAgentsConnected(void);
+const LatencyHistogram *remoteNetworkHop(void);
+const LatencyHistogram *remoteAgentHop(void);
+
+#endif /* REMOTE_H */
@@ -0,0 +1,62 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// xoshiro256** generator: one per run, seeded from -S. Unlike rand(), its
+// whole state is this struct, so it can be checkpointed and restored.
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+/**
+ * Rotate left
+ */
+static inline uint64_t rngRotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * Seed the generator; splitmix64 spreads the seed over the four words so
+ * small or similar seeds still give unrelated streams
+ */
+static inline void rngSeed(Rng *rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        rng->s[i] = z ^ (z >> 31);
+    }
+}
+
+/**
+ * Next 64 random bits
+ */
+static inline uint64_t rngNext(Rng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rngRotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rngRotl(s[3], 45);
+    return result;
+}
+
+/**
+ * Uniform integer in [0, bound), bound > 0 (multiply-shift, no division)
+ */
+static inline uint64_t rngBelow(Rng *rng, uint64_t bound) {
+    return (uint64_t)(((unsigned __int128)rngNext(rng) * bound) >> 64);
+}
+
+/**
+ * Uniform double in [0, 1)
+ */
+static inline double rngDouble(Rng *rng) {
+    return (rngNext(rng) >> 11) * 0x1.0p-53;
+}
+
+#endif /* RNG_H */
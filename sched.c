@@ -0,0 +1,374 @@
+#include <stdlib.h>
+#include <string.h>
+#include "eventq.h"
+#include "sched.h"
+
+static SchedPolicy schedPolicy = SCHED_RR;
+static ProcessTable *schedTable = NULL;
+static SchedStats stats;
+static Rng *lotteryRng = NULL;
+
+// MLFQ: one intrusive FIFO per level plus a bitmap of non-empty levels
+static int *mlfqLevel = NULL;
+static int *mlfqNext = NULL;
+static int *mlfqPrev = NULL;
+static int mlfqHead[MLFQ_LEVELS];
+static int mlfqTail[MLFQ_LEVELS];
+static uint32_t mlfqBitmap = 0;
+static uint64_t lastBoostNs = 0;
+
+// SRT: min-heap of entries keyed by termination deadline
+static EventQueue deadlines;
+
+// Lottery: dense array of ready entries for O(1) draws and removal
+static int *ready = NULL;
+static int *readyPos = NULL;
+static int readyCount = 0;
+
+/**
+ * Parse a scheduling policy name given on the command line
+ * @return 0 on success, -1 if the name is unknown
+ */
+int parseSchedPolicy(const char *name, SchedPolicy *policy) {
+    if (strcmp(name, "rr") == 0) {
+        *policy = SCHED_RR;
+    } else if (strcmp(name, "mlfq") == 0) {
+        *policy = SCHED_MLFQ;
+    } else if (strcmp(name, "srt") == 0) {
+        *policy = SCHED_SRT;
+    } else if (strcmp(name, "lottery") == 0) {
+        *policy = SCHED_LOTTERY;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Name of a scheduling policy for logs and statistics
+ */
+const char *schedPolicyName(SchedPolicy policy) {
+    switch (policy) {
+        case SCHED_MLFQ:
+            return "mlfq";
+        case SCHED_SRT:
+            return "srt";
+        case SCHED_LOTTERY:
+            return "lottery";
+        default:
+            return "rr";
+    }
+}
+
+/**
+ * Append an entry to the tail of an MLFQ level
+ */
+static void mlfqPush(int index, int level) {
+    mlfqLevel[index] = level;
+    mlfqNext[index] = -1;
+    mlfqPrev[index] = mlfqTail[level];
+    if (mlfqTail[level] == -1) {
+        mlfqHead[level] = index;
+    } else {
+        mlfqNext[mlfqTail[level]] = index;
+    }
+    mlfqTail[level] = index;
+    mlfqBitmap |= 1u << level;
+}
+
+/**
+ * Unlink an entry from its MLFQ level
+ */
+static void mlfqUnlink(int index) {
+    int level = mlfqLevel[index];
+    int next = mlfqNext[index];
+    int prev = mlfqPrev[index];
+
+    if (prev == -1) {
+        mlfqHead[level] = next;
+    } else {
+        mlfqNext[prev] = next;
+    }
+    if (next == -1) {
+        mlfqTail[level] = prev;
+    } else {
+        mlfqPrev[next] = prev;
+    }
+    if (mlfqHead[level] == -1) {
+        mlfqBitmap &= ~(1u << level);
+    }
+}
+
+/**
+ * Move every entry back to the top level so demoted processes cannot starve
+ */
+static void mlfqBoost(void) {
+    for (int level = 1; level < MLFQ_LEVELS; level++) {
+        while (mlfqHead[level] != -1) {
+            int index = mlfqHead[level];
+            mlfqUnlink(index);
+            mlfqPush(index, 0);
+        }
+    }
+}
+
+/**
+ * Set up the scheduler for a process table
+ * @param policy Policy to dispatch with
+ * @param table Process table; per-entry state is sized for its maximum capacity
+ * @param rng Generator the lottery draws from
+ * @return 0 on success, -1 on allocation failure
+ */
+int schedInit(SchedPolicy policy, ProcessTable *table, Rng *rng) {
+    int entries = table->maxCapacity;
+
+    schedPolicy = policy;
+    schedTable = table;
+    lotteryRng = rng;
+    memset(&stats, 0, sizeof(stats));
+
+    switch (policy) {
+        case SCHED_MLFQ:
+            mlfqLevel = malloc(entries * sizeof(int));
+            mlfqNext = malloc(entries * sizeof(int));
+            mlfqPrev = malloc(entries * sizeof(int));
+            if (mlfqLevel == NULL || mlfqNext == NULL || mlfqPrev == NULL) {
+                return -1;
+            }
+            for (int level = 0; level < MLFQ_LEVELS; level++) {
+                mlfqHead[level] = -1;
+                mlfqTail[level] = -1;
+            }
+            mlfqBitmap = 0;
+            lastBoostNs = 0;
+            break;
+        case SCHED_SRT:
+            return eventQueueInit(&deadlines, entries);
+        case SCHED_LOTTERY:
+            ready = malloc(entries * sizeof(int));
+            readyPos = malloc(entries * sizeof(int));
+            if (ready == NULL || readyPos == NULL) {
+                return -1;
+            }
+            readyCount = 0;
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+/**
+ * Release the scheduler's per-entry state
+ */
+void schedFree(void) {
+    free(mlfqLevel);
+    free(mlfqNext);
+    free(mlfqPrev);
+    free(ready);
+    free(readyPos);
+    if (schedPolicy == SCHED_SRT) {
+        eventQueueFree(&deadlines);
+    }
+    mlfqLevel = mlfqNext = mlfqPrev = NULL;
+    ready = readyPos = NULL;
+    readyCount = 0;
+    mlfqBitmap = 0;
+}
+
+/**
+ * Make a newly activated entry ready to run
+ * @param nowNs Simulated launch time
+ * @param deadlineNs Simulated time at which the worker will terminate
+ */
+void schedAdmit(int index, uint64_t nowNs, uint64_t deadlineNs) {
+    struct PCB *pcb = &schedTable->pcb[index];
+    pcb->launchNs = nowNs;
+    pcb->deadlineNs = deadlineNs;
+    pcb->firstDispatchNs = 0;
+    pcb->cpuNs = 0;
+    pcb->dispatched = 0;
+    schedReadmit(index, 0);
+}
+
+/**
+ * Make an activated entry ready to run with the accounting already in its
+ * PCB; entries readmitted in schedOrder order are dispatched in that order
+ * @param level MLFQ level to queue it on
+ */
+void schedReadmit(int index, int level) {
+    switch (schedPolicy) {
+        case SCHED_MLFQ:
+            mlfqPush(index, level);
+            break;
+        case SCHED_SRT:
+            eventSchedule(&deadlines, index, schedTable->pcb[index].deadlineNs);
+            break;
+        case SCHED_LOTTERY:
+            readyPos[index] = readyCount;
+            ready[readyCount++] = index;
+            break;
+        default:
+            break;      // The active ring is maintained by the process table
+    }
+}
+
+/**
+ * Drop an entry that is being released from the ready structures
+ */
+void schedRemove(int index) {
+    switch (schedPolicy) {
+        case SCHED_MLFQ:
+            mlfqUnlink(index);
+            break;
+        case SCHED_SRT:
+            eventCancel(&deadlines, index);
+            break;
+        case SCHED_LOTTERY: {
+            int pos = readyPos[index];
+            int last = ready[--readyCount];
+            ready[pos] = last;
+            readyPos[last] = pos;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/**
+ * Pick the entry to dispatch next; it stays ready until removed
+ * @param nowNs Current simulated time
+ * @return Index of the entry, or -1 if none are ready
+ */
+int schedNext(uint64_t nowNs) {
+    switch (schedPolicy) {
+        case SCHED_MLFQ:
+            if (nowNs - lastBoostNs >= MLFQ_BOOST_NS) {
+                mlfqBoost();
+                lastBoostNs = nowNs;
+            }
+            return mlfqBitmap == 0 ? -1 : mlfqHead[__builtin_ctz(mlfqBitmap)];
+        case SCHED_SRT: {
+            uint64_t deadline;
+            return eventPeek(&deadlines, &deadline);
+        }
+        case SCHED_LOTTERY:
+            return readyCount == 0 ? -1 : ready[rngBelow(lotteryRng, readyCount)];
+        default:
+            return pcbNextActive(schedTable);
+    }
+}
+
+/**
+ * Account a quantum handed to an entry. Under MLFQ a process that used its
+ * whole quantum drops one level (workers never yield early).
+ * @param nowNs Simulated time of the dispatch
+ * @param quantumNs Simulated time the quantum covers
+ */
+void schedCharge(int index, uint64_t nowNs, uint64_t quantumNs) {
+    schedChargeQuanta(index, nowNs, quantumNs, 1);
+}
+
+/**
+ * Account several quanta handed to an entry at once, as fast-forward does
+ * for the passes it skips; MLFQ demotes it once per quantum
+ * @param firstNs Simulated time of the first of them
+ * @param quantumNs Simulated time each one covers
+ * @param count Quanta
+ */
+void schedChargeQuanta(int index, uint64_t firstNs, uint64_t quantumNs, uint64_t count) {
+    struct PCB *pcb = &schedTable->pcb[index];
+    if (!pcb->dispatched) {
+        pcb->dispatched = 1;
+        pcb->firstDispatchNs = firstNs;
+    }
+    pcb->cpuNs += count * quantumNs;
+
+    if (schedPolicy == SCHED_MLFQ) {
+        int level = mlfqLevel[index];
+        mlfqUnlink(index);
+        mlfqPush(index, count < (uint64_t)(MLFQ_LEVELS - 1 - level) ? level + (int)count : MLFQ_LEVELS - 1);
+    }
+}
+
+/**
+ * Record the timing of a process that terminated normally
+ * @param nowNs Simulated time its final reply was received
+ */
+void schedComplete(int index, uint64_t nowNs) {
+    const struct PCB *pcb = &schedTable->pcb[index];
+    uint64_t turnaround = nowNs - pcb->launchNs;
+
+    stats.completed++;
+    stats.turnaroundNs += turnaround;
+    stats.waitNs += turnaround > pcb->cpuNs ? turnaround - pcb->cpuNs : 0;
+    stats.responseNs += pcb->firstDispatchNs - pcb->launchNs;
+}
+
+/**
+ * Timing totals over every completed process
+ */
+const SchedStats *schedStats(void) {
+    return &stats;
+}
+
+/**
+ * Ready entries in the order the policy holds them: the active ring from
+ * the next round-robin position (rr, srt), each MLFQ level front to back,
+ * or the lottery's ready array
+ * @param order Filled with entry indices
+ * @return Number of entries
+ */
+int schedOrder(int *order) {
+    int count = 0;
+    switch (schedPolicy) {
+        case SCHED_MLFQ:
+            for (int level = 0; level < MLFQ_LEVELS; level++) {
+                for (int index = mlfqHead[level]; index != -1; index = mlfqNext[index]) {
+                    order[count++] = index;
+                }
+            }
+            break;
+        case SCHED_LOTTERY:
+            memcpy(order, ready, readyCount * sizeof(int));
+            count = readyCount;
+            break;
+        default: {
+            const ProcessTable *t = schedTable;
+            if (t->ringHead == -1) {
+                break;
+            }
+            int first = t->cursor == -1 ? t->ringHead : t->ringNext[t->cursor];
+            int index = first;
+            do {
+                order[count++] = index;
+                index = t->ringNext[index];
+            } while (index != first);
+            break;
+        }
+    }
+    return count;
+}
+
+/**
+ * MLFQ level of an entry (0 under other policies)
+ */
+int schedLevel(int index) {
+    return schedPolicy == SCHED_MLFQ ? mlfqLevel[index] : 0;
+}
+
+/**
+ * Simulated time of the last MLFQ priority boost
+ */
+uint64_t schedLastBoostNs(void) {
+    return lastBoostNs;
+}
+
+/**
+ * Take over the completed-process totals and boost time of a checkpoint
+ */
+void schedResume(const SchedStats *saved, uint64_t boostNs) {
+    stats = *saved;
+    lastBoostNs = boostNs;
+}
@@ -0,0 +1,47 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+#include "pcbtable.h"
+#include "rng.h"
+
+#define MLFQ_LEVELS 8                   // Priority levels (bitmap fits in 32 bits)
+#define MLFQ_BOOST_NS (NANO_PER_SEC)    // Simulated time between priority boosts
+
+// Which occupied entry oss dispatches next
+typedef enum {
+    SCHED_RR,               // Round-robin over the active ring (default)
+    SCHED_MLFQ,             // Multi-level feedback queue, O(1) bitmap lookup
+    SCHED_SRT,              // Shortest remaining time: earliest termination deadline first
+    SCHED_LOTTERY           // Random draw; every process holds the same number of tickets
+} SchedPolicy;
+
+// Completed-process timing, all in simulated nanoseconds
+typedef struct {
+    int completed;          // Processes that terminated normally
+    uint64_t turnaroundNs;  // Sum of launch -> termination
+    uint64_t waitNs;        // Sum of turnaround minus quanta received
+    uint64_t responseNs;    // Sum of launch -> first dispatch
+} SchedStats;
+
+int parseSchedPolicy(const char *name, SchedPolicy *policy);
+const char *schedPolicyName(SchedPolicy policy);
+
+int schedInit(SchedPolicy policy, ProcessTable *table, Rng *rng);
+void schedFree(void);
+void schedAdmit(int index, uint64_t nowNs, uint64_t deadlineNs);
+void schedRemove(int index);
+int schedNext(uint64_t nowNs);
+void schedCharge(int index, uint64_t nowNs, uint64_t quantumNs);
+void schedChargeQuanta(int index, uint64_t firstNs, uint64_t quantumNs, uint64_t count);
+void schedComplete(int index, uint64_t nowNs);
+const SchedStats *schedStats(void);
+
+// Checkpoint and resume
+int schedOrder(int *order);
+int schedLevel(int index);
+uint64_t schedLastBoostNs(void);
+void schedReadmit(int index, int level);
+void schedResume(const SchedStats *saved, uint64_t boostNs);
+
+#endif /* SCHED_H */
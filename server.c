@@ -0,0 +1,257 @@
+#define _GNU_SOURCE    // accept4
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "server.h"
+
+#define SERVER_BACKLOG 16           // Clients waiting while a job runs
+#define SERVER_REQUEST_TIMEOUT_S 5  // Longest wait for a client's request line
+
+static int listenFd = -1;
+static char socketPath[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static int clientFd = -1;           // Client of the current job
+static FILE *output = NULL;         // What the job sends back, until serverFinish
+static char *outputBuffer = NULL;
+static size_t outputLength = 0;
+
+/**
+ * Format a request as the line a client sends
+ * @return 0 on success, -1 with errno EINVAL if it does not fit
+ */
+int serverFormatRequest(const ServerRequest *request, char *out, size_t size) {
+    int len = request->type == SERVER_STOP ? snprintf(out, size, "stop\n") :
+              snprintf(out, size, "run %d %d %d %d\n", request->processes, request->simultaneous,
+                       request->timelimit, request->launchInterval);
+    if (len < 0 || (size_t)len >= size) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Parse a request line
+ * @return 0 on success, -1 with errno EINVAL if it is malformed
+ */
+int serverParseRequest(const char *line, ServerRequest *request) {
+    memset(request, 0, sizeof(*request));
+    if (strcmp(line, "stop") == 0) {
+        request->type = SERVER_STOP;
+        return 0;
+    }
+
+    char rest;
+    if (sscanf(line, "run %d %d %d %d %c", &request->processes, &request->simultaneous,
+               &request->timelimit, &request->launchInterval, &rest) != 4 ||
+        request->processes < 0 || request->simultaneous < 0 || request->timelimit < 0 ||
+        request->launchInterval < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    request->type = SERVER_RUN;
+    return 0;
+}
+
+/**
+ * Write a whole buffer to a client; a client that went away is not an
+ * error worth a signal
+ */
+static int sendAll(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/**
+ * Hang up on the current client and drop whatever was written for it
+ */
+static void dropClient(void) {
+    if (output != NULL) {
+        fclose(output);
+        output = NULL;
+    }
+    free(outputBuffer);
+    outputBuffer = NULL;
+    outputLength = 0;
+    if (clientFd != -1) {
+        close(clientFd);
+        clientFd = -1;
+    }
+}
+
+/**
+ * Serve jobs on a Unix domain socket. A socket file left behind by an oss
+ * that is gone is replaced; one that still answers is not.
+ * @return 0 on success, -1 with errno set (EADDRINUSE if another oss serves
+ *         on the path)
+ */
+int serverListen(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe == -1) {
+        return -1;
+    }
+    int answered = connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+    int stale = !answered && errno == ECONNREFUSED;
+    close(probe);
+    if (answered) {
+        errno = EADDRINUSE;
+        return -1;
+    }
+    if (stale) {
+        unlink(path);
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd == -1) {
+        return -1;
+    }
+    if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(listenFd, SERVER_BACKLOG) == -1) {
+        int saved = errno;
+        close(listenFd);
+        listenFd = -1;
+        errno = saved;
+        return -1;
+    }
+    snprintf(socketPath, sizeof(socketPath), "%s", path);
+    return 0;
+}
+
+/**
+ * Wait for the next client and read its request. A client that sends a
+ * malformed request is told so and dropped.
+ * @param timeoutMs Longest wait for a client, so the caller can look after
+ *                  its workers and signals in between
+ * @return 0 with a request from the new current client, -1 with errno
+ *         EAGAIN if none came in time, EINTR if interrupted
+ */
+int serverAccept(ServerRequest *request, int timeoutMs) {
+    struct pollfd p = { listenFd, POLLIN, 0 };
+    int rc = poll(&p, 1, timeoutMs);
+    if (rc <= 0) {
+        if (rc == 0) {
+            errno = EAGAIN;
+        }
+        return -1;
+    }
+
+    clientFd = accept4(listenFd, NULL, NULL, SOCK_CLOEXEC);
+    if (clientFd == -1) {
+        if (errno != EINTR) {
+            errno = EAGAIN;     // The client gave up before we got to it
+        }
+        return -1;
+    }
+    struct timeval timeout = { SERVER_REQUEST_TIMEOUT_S, 0 };
+    setsockopt(clientFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // One line; a client sends nothing after it
+    char line[SERVER_REQUEST_MAX];
+    size_t len = 0;
+    while (len < sizeof(line) - 1) {
+        ssize_t n = recv(clientFd, line + len, sizeof(line) - 1 - len, 0);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        len += n;
+        if (memchr(line, '\n', len) != NULL) {
+            break;
+        }
+    }
+    line[len] = '\0';
+    char *end = strchr(line, '\n');
+    if (end != NULL) {
+        *end = '\0';
+    }
+    if (end == NULL || serverParseRequest(line, request) == -1) {
+        serverReject("malformed request");
+        errno = EAGAIN;
+        return -1;
+    }
+
+    output = open_memstream(&outputBuffer, &outputLength);
+    if (output == NULL) {
+        serverReject("out of memory");
+        errno = EAGAIN;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Stream to the current client's output, sent by serverFinish
+ */
+FILE *serverOutput(void) {
+    return output;
+}
+
+/**
+ * Refuse the current client's request and hang up
+ */
+void serverReject(const char *reason) {
+    if (clientFd != -1) {
+        char line[SERVER_REQUEST_MAX];
+        snprintf(line, sizeof(line), "error %s\n", reason);
+        sendAll(clientFd, line, strlen(line));
+    }
+    dropClient();
+}
+
+/**
+ * Send the current client its output and the job's status, and hang up
+ * @param status 0 if the job ran to completion, else why it did not
+ */
+void serverFinish(int status) {
+    if (clientFd == -1) {
+        return;
+    }
+    char line[32];
+    snprintf(line, sizeof(line), "end %d\n", status);
+    if (output != NULL) {
+        fclose(output);
+        output = NULL;
+        sendAll(clientFd, outputBuffer, outputLength);
+    }
+    sendAll(clientFd, line, strlen(line));
+    dropClient();
+}
+
+/**
+ * Stop serving: hang up on any client and remove the socket; safe to call
+ * twice
+ */
+void serverClose(void) {
+    dropClient();
+    if (listenFd != -1) {
+        close(listenFd);
+        listenFd = -1;
+        unlink(socketPath);
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdio.h>
+
+#define SERVER_DEFAULT_PATH "/tmp/oss.sock"  // Unix socket oss serves jobs on (-u, ossctl -u)
+#define SERVER_REQUEST_MAX 256      // Longest request line
+#define SERVER_POLL_MS 100          // Wait for a client between checks for signals and dead workers
+#define SERVER_JOB_TIMED_OUT 1      // End status of a job cut short by oss -a
+
+// What a client asks of a serving oss; one request per connection
+typedef enum {
+    SERVER_RUN,             // Run a job and send back its final statistics
+    SERVER_STOP             // Stop serving once the current job is done
+} ServerRequestType;
+
+// A request: "run <n> <s> <t> <i>" or "stop"; 0 takes the value oss was started with
+typedef struct {
+    int type;               // ServerRequestType
+    int processes;          // -n
+    int simultaneous;       // -s, at most the -s oss was started with
+    int timelimit;          // -t
+    int launchInterval;     // -i
+} ServerRequest;
+
+// Request line helpers, shared with ossctl
+int serverFormatRequest(const ServerRequest *request, char *out, size_t size);
+int serverParseRequest(const char *line, ServerRequest *request);
+
+// oss side; all return 0 on success or -1 with errno set
+int serverListen(const char *path);
+int serverAccept(ServerRequest *request, int timeoutMs);
+FILE *serverOutput(void);
+void serverReject(const char *reason);
+void serverFinish(int status);
+void serverClose(void);
+
+#endif /* SERVER_H */
@@ -0,0 +1,363 @@
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "common.h"
+#include "futex.h"
+#include "shard.h"
+
+// What the shards do in a round
+typedef enum {
+    ROUND_EXCHANGE,         // Send the queued quanta, then take their replies
+    ROUND_COLLECT,          // Wait for the replies still awaited
+    ROUND_POLL              // Take the replies that have already arrived
+} RoundMode;
+
+// One dispatcher thread. Its transport copy carries its shard number, so
+// the replies to what it sends come back on its own channel: its message
+// type on the queue, or its doorbell for the mailboxes.
+typedef struct {
+    pthread_t thread;
+    int id;
+    Transport transport;
+    int *queue;             // Jobs this shard owns this round
+    int queued;
+    int *pending;           // Jobs it sent whose reply it awaits
+    int *slots;             // Their entries, for the receive
+    int pendingCount;
+    int result;             // 0, or -1 if the round's receive failed
+    int error;              // errno of that failure
+    uint64_t steals;        // Jobs taken from another shard's queue
+    _Alignas(CACHE_LINE) _Atomic int claimed;  // Next queue position to send, claimed by the owner or a thief
+} Shard;
+
+static Shard shards[SHARD_MAX];
+static int shardCount = 0;
+static pid_t ossPid;
+static uint64_t replyBudgetNs;          // Longest wait for a quantum's reply, 0 = none (oss -q)
+static ShardJob *roundJobs = NULL;
+static RoundMode roundMode;
+static _Atomic uint32_t generation;     // Bumped to start a round; idle shards wait on it
+static _Atomic uint32_t running;        // Shards still in the round; oss waits on it
+static _Atomic int stopping;
+
+/**
+ * Send one job's quantum; the reply will come back to this shard
+ * @param job Position in the round's jobs
+ */
+static void sendJob(Shard *s, int job) {
+    ShardJob *j = &roundJobs[job];
+    j->shard = s->id;
+    j->sentWallNs = monotonicNs();
+    if (transportSendToWorkerUntil(&s->transport, j->index, j->pid, 1,
+                                   replyBudgetNs != 0 ? j->sentWallNs + replyBudgetNs : 0) == -1) {
+        j->error = errno;
+        j->state = SHARD_JOB_FAILED;
+        return;
+    }
+    j->state = SHARD_JOB_SENT;
+    s->pending[s->pendingCount] = job;
+    s->slots[s->pendingCount] = j->index;
+    s->pendingCount++;
+}
+
+/**
+ * Send the shard's own queue, then help the others: claim whatever is left
+ * in their queues, so a shard that falls behind does not hold up the round
+ */
+static void sendJobs(Shard *s) {
+    for (int k = 0; k < shardCount; k++) {
+        Shard *victim = &shards[(s->id + k) % shardCount];
+        int pos;
+        while ((pos = atomic_fetch_add_explicit(&victim->claimed, 1, memory_order_relaxed)) < victim->queued) {
+            if (victim != s) {
+                s->steals++;
+            }
+            sendJob(s, victim->queue[pos]);
+        }
+    }
+}
+
+/**
+ * Wall time by which the earliest quantum this shard awaits must be answered
+ * @return The deadline, or 0 if there is no budget
+ */
+static uint64_t replyDeadline(const Shard *s) {
+    if (replyBudgetNs == 0) {
+        return 0;
+    }
+    uint64_t earliest = UINT64_MAX;
+    for (int p = 0; p < s->pendingCount; p++) {
+        if (roundJobs[s->pending[p]].sentWallNs < earliest) {
+            earliest = roundJobs[s->pending[p]].sentWallNs;
+        }
+    }
+    return earliest + replyBudgetNs;
+}
+
+/**
+ * Stop waiting for the jobs whose reply is past the budget; oss decides
+ * what becomes of their workers
+ */
+static void markOverdue(Shard *s) {
+    uint64_t now = monotonicNs();
+    int kept = 0;
+    for (int p = 0; p < s->pendingCount; p++) {
+        ShardJob *j = &roundJobs[s->pending[p]];
+        if (now - j->sentWallNs >= replyBudgetNs) {
+            j->state = SHARD_JOB_OVERDUE;
+            continue;
+        }
+        s->pending[kept] = s->pending[p];
+        s->slots[kept] = s->slots[p];
+        kept++;
+    }
+    s->pendingCount = kept;
+}
+
+/**
+ * Take replies to the jobs this shard sent until none is awaited
+ * @param wait Block for them, or only take those already there; a job
+ *             not answered within the budget is marked SHARD_JOB_OVERDUE
+ * @return 0 on success, -1 with errno set (EINTR if interrupted)
+ */
+static int takeReplies(Shard *s, int wait) {
+    while (s->pendingCount > 0) {
+        Message reply;
+        int rc = wait ? transportRecvAnyFromWorkerUntil(&s->transport, s->slots, s->pendingCount, ossPid, &reply,
+                                                        replyDeadline(s))
+                      : transportTryRecvAnyFromWorker(&s->transport, s->slots, s->pendingCount, ossPid, &reply);
+        if (rc == -1 && errno == ETIMEDOUT) {
+            markOverdue(s);
+            continue;
+        }
+        if (rc == -1) {
+            return !wait && errno == EAGAIN ? 0 : -1;
+        }
+
+        int match = -1;
+        for (int p = 0; p < s->pendingCount; p++) {
+            if (roundJobs[s->pending[p]].pid == reply.pid) {
+                match = p;
+                break;
+            }
+        }
+        if (match == -1) {
+            fprintf(stderr, "OSS: Ignoring reply from unknown PID %d\n", reply.pid);
+            continue;
+        }
+
+        ShardJob *j = &roundJobs[s->pending[match]];
+        j->status = reply.status;
+        j->payloadOffset = reply.payloadOffset;
+        j->payloadLength = reply.payloadLength;
+        j->replyWallNs = monotonicNs();
+        j->state = SHARD_JOB_REPLIED;
+        s->pendingCount--;
+        s->pending[match] = s->pending[s->pendingCount];
+        s->slots[match] = s->slots[s->pendingCount];
+    }
+    return 0;
+}
+
+/**
+ * A shard's part of one round
+ */
+static void runRound(Shard *s) {
+    if (roundMode == ROUND_EXCHANGE) {
+        sendJobs(s);
+    } else {
+        // oss stops waiting for jobs whose worker it has retired
+        int kept = 0;
+        for (int p = 0; p < s->pendingCount; p++) {
+            if (roundJobs[s->pending[p]].state == SHARD_JOB_SENT) {
+                s->pending[kept] = s->pending[p];
+                s->slots[kept] = s->slots[p];
+                kept++;
+            }
+        }
+        s->pendingCount = kept;
+    }
+
+    s->result = takeReplies(s, roundMode != ROUND_POLL);
+    s->error = errno;
+}
+
+/**
+ * Dispatcher thread: run every round oss starts until told to stop
+ */
+static void *shardMain(void *arg) {
+    Shard *s = arg;
+    uint32_t seen = 0;
+
+    for (;;) {
+        uint32_t current;
+        while ((current = atomic_load(&generation)) == seen) {
+            futexWait(&generation, seen);
+        }
+        seen = current;
+        if (atomic_load(&stopping)) {
+            break;
+        }
+
+        runRound(s);
+        if (atomic_fetch_sub(&running, 1) == 1) {
+            futexWake(&running);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Run a round on every shard and wait for all of them to finish it. Signals
+ * still reach oss while it waits; a SIGCHLD interrupts the shards through
+ * transportInterrupt.
+ * @return 0 on success, -1 with errno set (EINTR if a shard was interrupted)
+ */
+static int runShards(ShardJob *jobs, RoundMode mode) {
+    roundJobs = jobs;
+    roundMode = mode;
+    atomic_store(&running, shardCount);
+    atomic_fetch_add(&generation, 1);
+    futexWakeAll(&generation);
+
+    uint32_t left;
+    while ((left = atomic_load(&running)) != 0) {
+        futexWait(&running, left);
+    }
+
+    // A failed receive outranks an interrupted one
+    int rc = 0, error = 0;
+    for (int i = 0; i < shardCount; i++) {
+        if (shards[i].result == -1 && (rc == 0 || error == EINTR)) {
+            rc = -1;
+            error = shards[i].error;
+        }
+    }
+    errno = error;
+    return rc;
+}
+
+/**
+ * Start the dispatcher threads
+ * @param count Number of shards, at most SHARD_MAX
+ * @param transport oss's transport; each shard gets a copy on its own channel
+ * @param pid oss's PID (reply message type)
+ * @param capacity Most entries in a round
+ * @param budgetNs Longest wait for a quantum's reply, 0 for no limit
+ * @return 0 on success, -1 with errno set
+ */
+int shardsStart(int count, const Transport *transport, pid_t pid, int capacity, uint64_t budgetNs) {
+    ossPid = pid;
+    replyBudgetNs = budgetNs;
+    atomic_store(&stopping, 0);
+    atomic_store(&generation, 0);
+
+    for (int i = 0; i < count; i++) {
+        Shard *s = &shards[i];
+        s->id = i;
+        s->transport = *transport;
+        s->transport.shard = i;
+        s->transport.shards = count;
+        s->transport.timeoutTimerReady = 0;     // Each shard times its own receives
+        s->queue = malloc(capacity * sizeof(int));
+        s->pending = malloc(capacity * sizeof(int));
+        s->slots = malloc(capacity * sizeof(int));
+        s->steals = 0;
+        if (s->queue == NULL || s->pending == NULL || s->slots == NULL) {
+            shardCount = i + 1;
+            shardsStop();
+            errno = ENOMEM;
+            return -1;
+        }
+
+        // Shards never handle signals; they stay with the main thread (a
+        // shard's own receive timer, oss -q, unblocks its signal)
+        sigset_t all, previous;
+        sigfillset(&all);
+        pthread_sigmask(SIG_BLOCK, &all, &previous);
+        int rc = pthread_create(&s->thread, NULL, shardMain, s);
+        pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+        if (rc != 0) {
+            free(s->queue);
+            free(s->pending);
+            free(s->slots);
+            shardCount = i;
+            shardsStop();
+            errno = rc;
+            return -1;
+        }
+    }
+    shardCount = count;
+    return 0;
+}
+
+/**
+ * Stop and join the dispatcher threads; safe to call twice. Shards caught
+ * in a round (oss exiting from a signal handler) are left to exit().
+ */
+void shardsStop(void) {
+    if (shardCount == 0 || atomic_load(&running) != 0) {
+        return;
+    }
+
+    atomic_store(&stopping, 1);
+    atomic_fetch_add(&generation, 1);
+    futexWakeAll(&generation);
+    for (int i = 0; i < shardCount; i++) {
+        if (shards[i].queue != NULL && shards[i].pending != NULL && shards[i].slots != NULL) {
+            pthread_join(shards[i].thread, NULL);
+        }
+        transportClose(&shards[i].transport);
+        free(shards[i].queue);
+        free(shards[i].pending);
+        free(shards[i].slots);
+        shards[i].queue = shards[i].pending = shards[i].slots = NULL;
+    }
+    shardCount = 0;
+}
+
+/**
+ * Send every job's quantum and take the replies, spread over the shards.
+ * The caller must make a child exit interrupt the receive (transportInterrupt)
+ * and then finish the round with shardsCollect.
+ * @param jobs index and pid set; the rest is filled in
+ * @return 0 once every sent job has replied, -1 with errno set (EINTR if
+ *         children exited)
+ */
+int shardsExchange(ShardJob *jobs, int count) {
+    for (int i = 0; i < shardCount; i++) {
+        shards[i].queued = 0;
+        shards[i].pendingCount = 0;
+        atomic_store_explicit(&shards[i].claimed, 0, memory_order_relaxed);
+    }
+    for (int job = 0; job < count; job++) {
+        Shard *owner = &shards[jobs[job].index % shardCount];
+        jobs[job].state = SHARD_JOB_QUEUED;
+        owner->queue[owner->queued++] = job;
+    }
+    return runShards(jobs, ROUND_EXCHANGE);
+}
+
+/**
+ * Take the replies to the round's jobs that are still SHARD_JOB_SENT, each
+ * on the shard that sent it. Mark a job SHARD_JOB_DONE to stop waiting for it.
+ * @param wait Block until they have all arrived, or only take those already there
+ * @return 0 on success, -1 with errno set (EINTR if children exited)
+ */
+int shardsCollect(ShardJob *jobs, int wait) {
+    return runShards(jobs, wait ? ROUND_COLLECT : ROUND_POLL);
+}
+
+/**
+ * Jobs sent by a shard other than their owner over the run
+ */
+uint64_t shardsSteals(void) {
+    uint64_t steals = 0;
+    for (int i = 0; i < shardCount; i++) {
+        steals += shards[i].steals;
+    }
+    return steals;
+}
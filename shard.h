@@ -0,0 +1,42 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "transport.h"
+
+#define SHARD_MAX TRANSPORT_MAX_SHARDS  // Most dispatcher threads (-m)
+
+// Where one entry's quantum of a sharded round stands
+typedef enum {
+    SHARD_JOB_QUEUED,       // Not sent yet
+    SHARD_JOB_SENT,         // Sent; its reply is awaited
+    SHARD_JOB_REPLIED,      // Reply taken into status
+    SHARD_JOB_FAILED,       // Send failed (error holds errno): the worker is gone
+    SHARD_JOB_OVERDUE,      // No reply within the budget (oss -q); no longer waited for
+    SHARD_JOB_DONE          // Handled by oss, or no longer waited for
+} ShardJobState;
+
+// One entry's quantum in a sharded round. Entry index modulo the shard
+// count picks the shard that owns it; an idle shard may steal it, and the
+// shard that sends it takes its reply.
+typedef struct {
+    int index;              // Process table entry (mailbox slot)
+    pid_t pid;              // Its worker
+    int shard;              // Shard that sent the quantum
+    int state;              // ShardJobState
+    int status;             // Reply status
+    uint32_t payloadOffset; // Reply's payload descriptor (oss -W)
+    uint32_t payloadLength;
+    int error;              // errno of a failed send
+    uint64_t sentWallNs;    // Wall time the quantum was sent
+    uint64_t replyWallNs;   // Wall time the reply was taken
+} ShardJob;
+
+int shardsStart(int count, const Transport *transport, pid_t ossPid, int capacity, uint64_t budgetNs);
+void shardsStop(void);
+int shardsExchange(ShardJob *jobs, int count);
+int shardsCollect(ShardJob *jobs, int wait);
+uint64_t shardsSteals(void);
+
+#endif /* SHARD_H */
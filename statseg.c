@@ -0,0 +1,231 @@
+#include <string.h>
+#include <unistd.h>
+#include "common.h"
+#include "statseg.h"
+
+static StatsSegment *stats = NULL;
+
+/**
+ * Open a slot for writing: readers retry while seq is odd
+ */
+static SlotStats *beginWrite(int slot) {
+    SlotStats *s = &stats->slot[slot];
+    atomic_store_explicit(&s->seq, atomic_load_explicit(&s->seq, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    return s;
+}
+
+/**
+ * Publish a slot's updates
+ */
+static void endWrite(SlotStats *s) {
+    atomic_store_explicit(&s->seq, atomic_load_explicit(&s->seq, memory_order_relaxed) + 1,
+                          memory_order_release);
+}
+
+/**
+ * Start publishing into a statistics segment; ossstat maps it read-only
+ * @param seg Segment memory (inside the control region)
+ * @param slots Process table entries to cover
+ * @param workerProcesses Whether workers are local processes, which ossstat
+ *        reads from /proc; not threads, nor agents' workers under virtual IDs
+ */
+void statsInit(StatsSegment *seg, int slots, int workerProcesses) {
+    stats = seg;
+    memset(stats, 0, STATS_SEGMENT_SIZE(slots));
+    stats->slots = slots;
+    stats->ossPid = getpid();
+    stats->workerProcesses = workerProcesses;
+    atomic_store(&stats->finished, 0);
+    atomic_thread_fence(memory_order_release);
+    stats->magic = STATS_MAGIC;     // Set last: readers wait for it
+}
+
+/**
+ * Stop publishing; the memory belongs to the control region
+ */
+void statsClose(void) {
+    stats = NULL;
+}
+
+/**
+ * A worker has been launched into an entry
+ */
+void statsSlotStart(int slot, pid_t pid, uint64_t launchNs) {
+    if (stats == NULL) {
+        return;
+    }
+    SlotStats *s = beginWrite(slot);
+    s->occupied = 1;
+    s->pid = pid;
+    s->launchNs = launchNs;
+    s->quanta = 0;
+    s->simCpuNs = 0;
+    s->waitNs = 0;
+    s->rttCount = 0;
+    s->rttSumNs = 0;
+    s->rttMaxNs = 0;
+    memset(s->rttBuckets, 0, sizeof(s->rttBuckets));
+    endWrite(s);
+}
+
+/**
+ * A quantum has been granted to an entry's worker
+ * @param nowNs Simulated time of the dispatch
+ * @param quantumNs Simulated CPU time the quantum covers
+ */
+void statsDispatch(int slot, uint64_t nowNs, uint64_t quantumNs) {
+    statsDispatchQuanta(slot, nowNs, quantumNs, 1);
+}
+
+/**
+ * Several quanta have been granted to an entry's worker at once
+ * @param lastNs Simulated time of the last of them
+ * @param quantumNs Simulated CPU time each one covers
+ * @param count Quanta
+ */
+void statsDispatchQuanta(int slot, uint64_t lastNs, uint64_t quantumNs, uint64_t count) {
+    if (stats == NULL) {
+        return;
+    }
+    SlotStats *s = beginWrite(slot);
+    s->quanta += count;
+    s->simCpuNs += count * quantumNs;
+    uint64_t resident = lastNs - s->launchNs;
+    s->waitNs = resident > s->simCpuNs ? resident - s->simCpuNs : 0;
+    endWrite(s);
+}
+
+/**
+ * A reply has arrived from an entry's worker
+ * @param rttNs Wall time since its quantum was sent
+ */
+void statsReply(int slot, uint64_t rttNs) {
+    if (stats == NULL) {
+        return;
+    }
+    int bucket = rttNs == 0 ? 0 : 63 - __builtin_clzll(rttNs);
+    if (bucket >= STATS_RTT_BUCKETS) {
+        bucket = STATS_RTT_BUCKETS - 1;
+    }
+
+    SlotStats *s = beginWrite(slot);
+    s->rttCount++;
+    s->rttSumNs += rttNs;
+    if (rttNs > s->rttMaxNs) {
+        s->rttMaxNs = rttNs;
+    }
+    s->rttBuckets[bucket]++;
+    endWrite(s);
+}
+
+/**
+ * An entry's worker has left the process table
+ */
+void statsSlotEnd(int slot) {
+    if (stats == NULL) {
+        return;
+    }
+    SlotStats *s = beginWrite(slot);
+    s->occupied = 0;
+    s->completed++;
+    endWrite(s);
+}
+
+/**
+ * Record the resource usage of a collected worker process against the
+ * entry it occupied last
+ */
+void statsExit(pid_t pid, int status, const struct rusage *usage) {
+    if (stats == NULL) {
+        return;
+    }
+
+    uint64_t userUs = usage->ru_utime.tv_sec * 1000000ULL + usage->ru_utime.tv_usec;
+    uint64_t sysUs = usage->ru_stime.tv_sec * 1000000ULL + usage->ru_stime.tv_usec;
+    atomic_fetch_add_explicit(&stats->childUserCpuUs, userUs, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->childSysCpuUs, sysUs, memory_order_relaxed);
+
+    // Exits are rare next to dispatches, so a scan is cheap enough
+    for (uint32_t i = 0; i < stats->slots; i++) {
+        if (stats->slot[i].pid == pid) {
+            SlotStats *s = beginWrite(i);
+            s->exitedPid = pid;
+            s->exitStatus = status;
+            s->userCpuUs = userUs;
+            s->sysCpuUs = sysUs;
+            s->maxRssKb = usage->ru_maxrss;
+            endWrite(s);
+            return;
+        }
+    }
+}
+
+/**
+ * Publish the run-wide counters
+ */
+void statsTotals(int totalProcesses, uint64_t totalMessages, int activeCount) {
+    if (stats == NULL) {
+        return;
+    }
+    atomic_store_explicit(&stats->totalProcesses, totalProcesses, memory_order_relaxed);
+    atomic_store_explicit(&stats->totalMessages, totalMessages, memory_order_relaxed);
+    atomic_store_explicit(&stats->activeCount, activeCount, memory_order_relaxed);
+}
+
+/**
+ * Tell readers the run is over
+ */
+void statsFinish(void) {
+    if (stats != NULL) {
+        atomic_store(&stats->finished, 1);
+    }
+}
+
+/**
+ * Take a consistent copy of one slot
+ * @return 0 on success, -1 if oss kept it busy for too long
+ */
+int statsReadSlot(const StatsSegment *seg, int slot, SlotStats *copy) {
+    const SlotStats *s = &seg->slot[slot];
+
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        uint32_t before = atomic_load_explicit((_Atomic uint32_t *)&s->seq, memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        memcpy(copy, (const void *)s, sizeof(*copy));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit((_Atomic uint32_t *)&s->seq, memory_order_relaxed) == before) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Round-trip time at or below which the given share of a slot's samples fall
+ * @param percentile 0-100
+ * @return Upper bound of the log2 bucket holding that sample, 0 if empty
+ */
+uint64_t statsRttPercentile(const SlotStats *s, double percentile) {
+    if (s->rttCount == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(percentile / 100.0 * s->rttCount + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int b = 0; b < STATS_RTT_BUCKETS; b++) {
+        seen += s->rttBuckets[b];
+        if (seen >= rank) {
+            uint64_t upper = (2ULL << b) - 1;
+            return upper < s->rttMaxNs ? upper : s->rttMaxNs;
+        }
+    }
+    return s->rttMaxNs;
+}
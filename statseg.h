@@ -0,0 +1,68 @@
+#ifndef STATSEG_H
+#define STATSEG_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+
+#define STATS_MAGIC 0x4f535354u     // "OSST"
+#define STATS_RTT_BUCKETS 40        // log2 round-trip buckets: [2^b, 2^(b+1)) ns
+
+// Per process table entry. oss is the only writer; a reader copies the
+// slot and retries if 'seq' was odd or changed (seqlock), so oss never
+// waits for a reader.
+typedef struct {
+    _Alignas(64) _Atomic uint32_t seq;
+    uint32_t occupied;
+    pid_t pid;                  // current (or last) occupant
+    uint64_t launchNs;          // simulated launch time of the occupant
+    uint64_t quanta;            // quanta granted to the occupant
+    uint64_t simCpuNs;          // simulated CPU time granted to the occupant
+    uint64_t waitNs;            // simulated time the occupant spent ready but not running
+    uint64_t rttCount;          // round trips of the occupant
+    uint64_t rttSumNs;
+    uint64_t rttMaxNs;
+    uint64_t rttBuckets[STATS_RTT_BUCKETS];
+    uint64_t completed;         // occupants that have left this entry
+    pid_t exitedPid;            // last occupant collected with wait4
+    int exitStatus;
+    uint64_t userCpuUs;         // its real CPU time and peak RSS
+    uint64_t sysCpuUs;
+    long maxRssKb;
+} SlotStats;
+
+// Statistics segment header, followed by one SlotStats per entry
+typedef struct {
+    uint32_t magic;
+    uint32_t slots;             // entries that follow
+    pid_t ossPid;
+    uint32_t workerProcesses;   // workers are local processes (not -L thread or -T sock)
+    _Atomic uint32_t finished;  // oss has left its main loop
+    _Atomic uint64_t totalProcesses;
+    _Atomic uint64_t totalMessages;
+    _Atomic uint64_t activeCount;
+    _Atomic uint64_t childUserCpuUs;    // summed over collected workers
+    _Atomic uint64_t childSysCpuUs;
+    SlotStats slot[];
+} StatsSegment;
+
+#define STATS_SEGMENT_SIZE(slots) (sizeof(StatsSegment) + (size_t)(slots) * sizeof(SlotStats))
+
+// Writer side (oss)
+void statsInit(StatsSegment *seg, int slots, int workerProcesses);
+void statsClose(void);
+void statsSlotStart(int slot, pid_t pid, uint64_t launchNs);
+void statsDispatch(int slot, uint64_t nowNs, uint64_t quantumNs);
+void statsDispatchQuanta(int slot, uint64_t lastNs, uint64_t quantumNs, uint64_t count);
+void statsReply(int slot, uint64_t rttNs);
+void statsSlotEnd(int slot);
+void statsExit(pid_t pid, int status, const struct rusage *usage);
+void statsTotals(int totalProcesses, uint64_t totalMessages, int activeCount);
+void statsFinish(void);
+
+// Reader side (ossstat)
+int statsReadSlot(const StatsSegment *seg, int slot, SlotStats *copy);
+uint64_t statsRttPercentile(const SlotStats *s, double percentile);
+
+#endif /* STATSEG_H */
@@ -1,8 +1,7 @@
-# Ensure IPC resources are cleared before starting
-echo "Cleaning up any existing IPC resources..."
-ipcs -m | grep $(whoami) | awk '{print $2}' | xargs -r ipcrm -m
-ipcs -q | grep $(whoami) | awk '{print $2}' | xargs -r ipcrm -q
-echo "Clean-up complete."
+# Every oss run creates its own control region (/dev/shm/oss.<pid>) and a
+# private message queue, so the test cases run concurrently in this directory
+ipcBefore=$(ipcs -m -q | grep -c $(whoami))
+regionsBefore=$(ls /dev/shm | grep -c '^oss\.')
 
 # Make sure the project is compiled
 echo "Compiling project..."
@@ -10,35 +9,63 @@ make clean
 make
 echo "Compilation complete."
 
-# Run several test cases
-echo "===== Running Test Case 1: Basic Functionality ====="
-echo "Running with default parameters..."
-./oss -f test1.log
-echo "Test 1 completed. Check test1.log for results."
+# Run several test cases at once
+echo "===== Test Case 1: Basic Functionality (default parameters) ====="
+./oss -S 1 -f test1.log > test1.out &
 
-echo "===== Running Test Case 2: Multiple Simultaneous Processes ====="
-echo "Running with 10 total processes, 5 simultaneous..."
-./oss -n 10 -s 5 -f test2.log
-echo "Test 2 completed. Check test2.log for results."
+echo "===== Test Case 2: Multiple Simultaneous Processes (10 total, 5 simultaneous) ====="
+./oss -n 10 -s 5 -S 2 -f test2.log > test2.out &
 
-echo "===== Running Test Case 3: Short Launch Interval ====="
-echo "Running with 8 processes, 3 simultaneous, 200ms launch interval..."
-./oss -n 8 -s 3 -i 200 -f test3.log
-echo "Test 3 completed. Check test3.log for results."
+echo "===== Test Case 3: Short Launch Interval (8 processes, 3 simultaneous, 200ms) ====="
+./oss -n 8 -s 3 -i 200 -S 3 -f test3.log > test3.out &
 
-echo "===== Running Test Case 4: Long Process Lifetimes ====="
-echo "Running with 5 processes, 2 simultaneous, 10 second max lifetime..."
-./oss -n 5 -s 2 -t 10 -f test4.log
-echo "Test 4 completed. Check test4.log for results."
+echo "===== Test Case 4: Long Process Lifetimes (5 processes, 2 simultaneous, 10s max) ====="
+./oss -n 5 -s 2 -t 10 -S 4 -f test4.log > test4.out &
+
+echo "===== Test Case 5: Worker Agent over Loopback (20 total, 4 simultaneous, -T sock) ====="
+./worker-agent -X 127.0.0.1:7171 > test5-agent.out &
+./oss -T sock -X 127.0.0.1:7171 -n 20 -s 4 -d pipelined -S 5 -f test5.log > test5.out &
+
+wait
+for i in 1 2 3 4 5; do
+    echo "Test $i: $(grep 'Total processes launched' test$i.out). Check test$i.log for results."
+done
+if grep -q 'Total processes launched: 20$' test5.out && grep -q 'over 20 processes$' test5.out; then
+    echo "Test 5: the agent launched and terminated all 20 workers."
+else
+    echo "Test 5 FAILED: the agent did not launch and terminate all 20 workers."
+fi
+
+echo "===== Test Case 6: Checkpoint and Resume (30 total, stopped after 1s, then resumed) ====="
+rm -f test6.ck
+./oss -n 30 -s 3 -t 3 -i 100 -S 6 -w sleep:20000 -k test6.ck -a 1 -f test6.log > test6.out 2>&1
+./oss -r test6.ck -f test6r.log > test6r.out
+# The resumed run relaunches the running workers and launches the rest of -n
+resumed=$(sed -n 's/^OSS: Resumed test6.ck at [0-9:]*: \([0-9]*\) launched, \([0-9]*\) running.*/\1 \2/p' test6r.out)
+launched=${resumed% *}
+running=${resumed#* }
+launches=$(grep -c 'OSS: Launching worker process' test6r.log)
+if [ -n "$resumed" ] && [ "$launched" -lt 30 ] && [ "$launches" -eq $((30 - launched + running)) ] &&
+   grep -q 'Total processes launched: 30$' test6r.out; then
+    echo "Test 6: resumed after $launched launches ($running running) and launched the other $((30 - launched))."
+else
+    echo "Test 6 FAILED: the resumed run did not launch exactly the rest of the 30 processes."
+fi
+
+echo "===== Parameter sweep ====="
+./osssweep -n 20,50 -s 2,8 -T msg,shm -o test_sweep.json
+echo "Sweep completed. Merged statistics are in test_sweep.json."
 
 # Check for remaining IPC resources
 echo "Checking for any remaining IPC resources..."
-ipcs -m | grep $(whoami)
-ipcs -q | grep $(whoami)
-
-# Clean up remaining resources if any
-echo "Final cleanup..."
-ipcs -m | grep $(whoami) | awk '{print $2}' | xargs -r ipcrm -m
-ipcs -q | grep $(whoami) | awk '{print $2}' | xargs -r ipcrm -q
+ipcAfter=$(ipcs -m -q | grep -c $(whoami))
+if [ "$ipcAfter" -gt "$ipcBefore" ]; then
+    echo "Leaked IPC resources:"
+    ipcs -m -q | grep $(whoami)
+fi
+if [ "$(ls /dev/shm | grep -c '^oss\.')" -gt "$regionsBefore" ]; then
+    echo "Leaked control regions:"
+    ls /dev/shm | grep '^oss\.'
+fi
 
 echo "All tests completed."
@@ -0,0 +1,171 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "common.h"
+#include "trace.h"
+
+#define TRACE_BUFFER_RECORDS 4096   // Records buffered per write()
+
+static int traceFd = -1;
+static TraceRecord *buffer = NULL;
+static int buffered = 0;
+
+/**
+ * Write the buffered records to the trace file
+ */
+static void traceFlush(void) {
+    const char *p = (const char *)buffer;
+    size_t left = buffered * sizeof(TraceRecord);
+
+    while (left > 0) {
+        ssize_t n = write(traceFd, p, left);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        p += n;
+        left -= n;
+    }
+    buffered = 0;
+}
+
+/**
+ * Create a trace file and write its header
+ * @return 0 on success, -1 on failure
+ */
+int traceOpen(const char *path, int n, int s, int t, int i, unsigned int seed) {
+    traceFd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (traceFd == -1) {
+        return -1;
+    }
+
+    buffer = malloc(TRACE_BUFFER_RECORDS * sizeof(TraceRecord));
+    if (buffer == NULL) {
+        close(traceFd);
+        traceFd = -1;
+        return -1;
+    }
+
+    TraceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.recordSize = sizeof(TraceRecord);
+    header.startWallNs = monotonicNs();
+    header.n = n;
+    header.s = s;
+    header.t = t;
+    header.i = i;
+    header.seed = seed;
+
+    if (write(traceFd, &header, sizeof(header)) != sizeof(header)) {
+        traceClose();
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Whether events are being traced
+ */
+int traceEnabled(void) {
+    return traceFd != -1;
+}
+
+/**
+ * Append one event; does nothing unless tracing is enabled
+ */
+void traceEvent(TraceType type, int slot, pid_t pid, int status, uint64_t simNs, uint64_t arg) {
+    if (traceFd == -1) {
+        return;
+    }
+
+    TraceRecord *rec = &buffer[buffered++];
+    rec->type = type;
+    rec->reserved = 0;
+    rec->slot = slot;
+    rec->pid = pid;
+    rec->status = status;
+    rec->simNs = simNs;
+    rec->wallNs = monotonicNs();
+    rec->arg = arg;
+
+    if (buffered == TRACE_BUFFER_RECORDS) {
+        traceFlush();
+    }
+}
+
+/**
+ * Flush and close the trace file; safe to call twice
+ */
+void traceClose(void) {
+    if (traceFd == -1) {
+        return;
+    }
+    traceFlush();
+    close(traceFd);
+    traceFd = -1;
+    free(buffer);
+    buffer = NULL;
+}
+
+/**
+ * Map a trace file read-only and check its header
+ * @return 0 on success, -1 with errno set (EINVAL for a malformed file)
+ */
+int traceMap(const char *path, TraceFile *trace) {
+    memset(trace, 0, sizeof(*trace));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return -1;
+    }
+    if ((size_t)st.st_size < sizeof(TraceHeader)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+    const TraceHeader *header = map;
+    if (memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != TRACE_VERSION || header->recordSize != sizeof(TraceRecord)) {
+        munmap(map, st.st_size);
+        errno = EINVAL;
+        return -1;
+    }
+
+    trace->header = header;
+    trace->records = (const TraceRecord *)(header + 1);
+    trace->count = (st.st_size - sizeof(TraceHeader)) / sizeof(TraceRecord);
+    trace->mappedSize = st.st_size;
+    return 0;
+}
+
+/**
+ * Unmap a trace file
+ */
+void traceUnmap(TraceFile *trace) {
+    if (trace->header != NULL) {
+        munmap((void *)trace->header, trace->mappedSize);
+    }
+    memset(trace, 0, sizeof(*trace));
+}
@@ -0,0 +1,63 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define TRACE_MAGIC "OSSTRACE"
+#define TRACE_VERSION 1
+
+// Event types
+typedef enum {
+    TRACE_LAUNCH = 1,       // arg = lifetime ns, status = pinned CPU (-1 if none)
+    TRACE_SEND,             // quantum sent
+    TRACE_RECEIVE,          // status = reply status
+    TRACE_TERMINATE,        // worker announced it is terminating
+    TRACE_UNEXPECTED_EXIT,  // worker exited without a final reply
+    TRACE_REAP,             // status = wait status, arg = user + system CPU us
+    TRACE_TIMEOUT           // reply missed the budget (oss -q); status = 1 if killed, arg = wall ns waited
+} TraceType;
+
+// File header; records follow immediately
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t startWallNs;   // monotonic wall clock when tracing started
+    int32_t n, s, t, i;     // oss parameters
+    uint32_t seed;
+    uint32_t reserved[5];
+} TraceHeader;
+
+// One fixed-size event
+typedef struct {
+    uint16_t type;
+    uint16_t reserved;
+    int32_t slot;
+    int32_t pid;
+    int32_t status;
+    uint64_t simNs;         // simulated clock
+    uint64_t wallNs;        // monotonic wall clock
+    uint64_t arg;
+} TraceRecord;
+
+// A trace file mapped for reading
+typedef struct {
+    const TraceHeader *header;
+    const TraceRecord *records;
+    size_t count;
+    size_t mappedSize;
+} TraceFile;
+
+// Writer (oss -B)
+int traceOpen(const char *path, int n, int s, int t, int i, unsigned int seed);
+int traceEnabled(void);
+void traceEvent(TraceType type, int slot, pid_t pid, int status, uint64_t simNs, uint64_t arg);
+void traceClose(void);
+
+// Reader (ossanalyze, oss -R)
+int traceMap(const char *path, TraceFile *trace);
+void traceUnmap(TraceFile *trace);
+
+#endif /* TRACE_H */
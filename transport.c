@@ -0,0 +1,532 @@
+#define _GNU_SOURCE    // gettid, SIGEV_THREAD_ID
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/msg.h>
+#include "futex.h"
+#include "remote.h"
+#include "transport.h"
+
+#define RING_SPIN_LIMIT 128  // Polls before the consumer parks on the futex
+#define TIMEOUT_SIGNAL SIGRTMIN  // Interrupts a timed send or receive on the queue at its deadline
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid   // glibc before 2.41 only has the raw field
+#endif
+
+/**
+ * Reset a ring to the empty state; only safe while neither side is using it
+ */
+void ringReset(MessageRing *ring) {
+    atomic_store(&ring->head, 0);
+    atomic_store(&ring->tail, 0);
+    atomic_store(&ring->sleeping, 0);
+}
+
+/**
+ * Append a message to the ring, waking the consumer if it is asleep
+ * @return 0 on success, -1 with errno EAGAIN if the ring is full
+ */
+int ringPush(MessageRing *ring, const Message *msg) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail >= RING_CAPACITY) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    ring->slots[head % RING_CAPACITY] = *msg;
+    atomic_store(&ring->head, head + 1);
+
+    // Pairs with the consumer's store to 'sleeping' before it re-checks head
+    if (atomic_load(&ring->sleeping)) {
+        futexWake(&ring->head);
+    }
+    return 0;
+}
+
+/**
+ * Remove the oldest message from the ring, blocking until one is available
+ * @return 0 on success
+ */
+int ringPop(MessageRing *ring, Message *msg) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    int spins = 0;
+
+    while (atomic_load_explicit(&ring->head, memory_order_acquire) == tail) {
+        if (spins < RING_SPIN_LIMIT) {
+            spins++;
+            continue;
+        }
+
+        // Announce that we are going to sleep, then re-check before parking
+        atomic_store(&ring->sleeping, 1);
+        if (atomic_load(&ring->head) == tail) {
+            futexWait(&ring->head, tail);
+        }
+        atomic_store(&ring->sleeping, 0);
+    }
+
+    *msg = ring->slots[tail % RING_CAPACITY];
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+/**
+ * Remove the oldest message from the ring without blocking
+ * @return 0 on success, -1 with errno EAGAIN if the ring is empty
+ */
+int ringTryPop(MessageRing *ring, Message *msg) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    if (atomic_load_explicit(&ring->head, memory_order_acquire) == tail) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    *msg = ring->slots[tail % RING_CAPACITY];
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+/**
+ * Parse a transport name given on the command line
+ * @return 0 on success, -1 if the name is unknown
+ */
+int parseTransportKind(const char *name, TransportKind *kind) {
+    if (strcmp(name, "msg") == 0) {
+        *kind = TRANSPORT_MSG;
+    } else if (strcmp(name, "shm") == 0) {
+        *kind = TRANSPORT_SHM;
+    } else if (strcmp(name, "sock") == 0) {
+        *kind = TRANSPORT_SOCK;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Name of a transport for logs and statistics
+ */
+const char *transportName(TransportKind kind) {
+    switch (kind) {
+        case TRANSPORT_SHM:
+            return "shm";
+        case TRANSPORT_SOCK:
+            return "sock";
+        default:
+            return "msg";
+    }
+}
+
+/**
+ * Message type of the replies taken by a dispatcher shard: oss's PID for
+ * shard 0, so a single dispatcher uses the same types as ever
+ */
+static long replyType(pid_t ossPid, int shard) {
+    return shard == 0 ? ossPid : TRANSPORT_SHARD_TYPE_BASE + shard;
+}
+
+/**
+ * Quanta oss can have outstanding at once without filling the queue. Each
+ * one sits on the queue as either the quantum or its reply, so staying
+ * under the limit keeps a send from blocking while the workers wait to
+ * queue their replies. Room is left for one interrupt message per shard.
+ * @return The limit, or INT_MAX if sends cannot block on the others' replies
+ */
+int transportSendWindow(Transport *t) {
+    struct msqid_ds ds;
+    if (t->kind != TRANSPORT_MSG || msgctl(t->msgqid, IPC_STAT, &ds) == -1) {
+        return INT_MAX;
+    }
+    int shards = t->shards > 1 ? t->shards : 1;
+    int window = (int)(ds.msg_qbytes / MSG_SIZE) - shards;
+    return window > 1 ? window : 1;
+}
+
+/**
+ * Receive the next message addressed to oss from the queue, reporting the
+ * synthetic interrupt message as EINTR
+ * @param flags 0 or IPC_NOWAIT
+ */
+static int recvFromQueue(Transport *t, pid_t ossPid, Message *msg, int flags) {
+    if (msgrcv(t->msgqid, msg, MSG_SIZE, replyType(ossPid, t->shard), flags) == -1) {
+        if (errno == ENOMSG) {
+            errno = EAGAIN;
+        }
+        return -1;
+    }
+    if (msg->pid == 0 && msg->status == MSG_STATUS_INTERRUPT) {
+        errno = EINTR;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * TIMEOUT_SIGNAL handler; the signal is only there to interrupt msgrcv or msgsnd
+ */
+static void timeoutSignal(int sig) {
+    (void)sig;
+}
+
+/**
+ * Arm the calling thread's timeout timer to interrupt it at a deadline,
+ * creating the timer on first use. Its signal is handled without SA_RESTART
+ * and unblocked in the calling thread only, so it cuts short that thread's
+ * msgrcv and nothing else.
+ * @return 0 on success, -1 with errno set
+ */
+static int armTimeout(Transport *t, uint64_t deadlineNs) {
+    if (!t->timeoutTimerReady) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = timeoutSignal;
+        sigemptyset(&sa.sa_mask);
+        if (sigaction(TIMEOUT_SIGNAL, &sa, NULL) == -1) {
+            return -1;
+        }
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, TIMEOUT_SIGNAL);
+        pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+
+        struct sigevent ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.sigev_notify = SIGEV_THREAD_ID;
+        ev.sigev_signo = TIMEOUT_SIGNAL;
+        ev.sigev_notify_thread_id = gettid();
+        if (timer_create(CLOCK_MONOTONIC, &ev, &t->timeoutTimer) == -1) {
+            return -1;
+        }
+        t->timeoutTimerReady = 1;
+    }
+
+    struct itimerspec when = { { 0, 0 }, { deadlineNs / NANO_PER_SEC, deadlineNs % NANO_PER_SEC } };
+    return timer_settime(t->timeoutTimer, TIMER_ABSTIME, &when, NULL);
+}
+
+/**
+ * Disarm the timeout timer, keeping errno. A timer that fires after this
+ * only interrupts a later wait, which retries.
+ */
+static void disarmTimeout(Transport *t) {
+    int saved = errno;
+    struct itimerspec off = { { 0, 0 }, { 0, 0 } };
+    timer_settime(t->timeoutTimer, 0, &off, NULL);
+    errno = saved;
+}
+
+/**
+ * Block on the queue until a message addressed to oss arrives or the
+ * deadline passes. A message queue has no timed receive, so a timer
+ * interrupts msgrcv at the deadline; a reply in time costs only arming and
+ * disarming the timer.
+ * @return 0 on success, -1 with errno EINTR or ETIMEDOUT
+ */
+static int recvFromQueueUntil(Transport *t, pid_t ossPid, Message *msg, uint64_t deadlineNs) {
+    if (armTimeout(t, deadlineNs) == -1) {
+        return -1;
+    }
+
+    int rc;
+    for (;;) {
+        rc = msgrcv(t->msgqid, msg, MSG_SIZE, replyType(ossPid, t->shard), 0);
+        if (rc != -1) {
+            if (msg->pid == 0 && msg->status == MSG_STATUS_INTERRUPT) {
+                errno = EINTR;
+                rc = -1;
+            } else {
+                rc = 0;
+            }
+            break;
+        }
+        if (errno != EINTR) {
+            break;
+        }
+        if (monotonicNs() >= deadlineNs) {
+            errno = ETIMEDOUT;
+            break;
+        }
+        // Another signal; an exit also queues the interrupt message
+    }
+
+    disarmTimeout(t);
+    return rc;
+}
+
+/**
+ * Send a message from oss to the worker occupying a slot; the worker
+ * replies to the shard of this transport. A full queue is waited on until
+ * the deadline, and any signal ends the wait.
+ * @param deadlineNs Monotonic wall time (monotonicNs) to give up at, 0 for never
+ * @return 0 on success, -1 with errno EINTR if a signal arrived while the
+ *         queue was full, ETIMEDOUT if it was still full at the deadline
+ */
+int transportSendToWorkerUntil(Transport *t, int slot, pid_t workerPid, int status, uint64_t deadlineNs) {
+    Message msg;
+    msg.mtype = workerPid;
+    msg.pid = 0;
+    msg.status = status;
+    msg.shard = t->shard;
+    msg.payloadOffset = 0;
+    msg.payloadLength = 0;
+
+    if (t->kind == TRANSPORT_SHM) {
+        return ringPush(&t->mailboxes->boxes[slot].toWorker, &msg);
+    }
+    if (t->kind == TRANSPORT_SOCK) {
+        return remoteSend(slot, workerPid);
+    }
+
+    // Only a full queue arms the timer
+    if (msgsnd(t->msgqid, &msg, MSG_SIZE, IPC_NOWAIT) == 0) {
+        return 0;
+    }
+    if (errno != EAGAIN) {
+        return -1;
+    }
+    if (deadlineNs != 0 && armTimeout(t, deadlineNs) == -1) {
+        return -1;
+    }
+    int rc = msgsnd(t->msgqid, &msg, MSG_SIZE, 0);
+    if (rc == -1 && errno == EINTR && deadlineNs != 0 && monotonicNs() >= deadlineNs) {
+        errno = ETIMEDOUT;
+    }
+    if (deadlineNs != 0) {
+        disarmTimeout(t);
+    }
+    return rc;
+}
+
+/**
+ * Send a message from oss to the worker occupying a slot, waiting as long
+ * as the queue is full
+ */
+int transportSendToWorker(Transport *t, int slot, pid_t workerPid, int status) {
+    int rc;
+    while ((rc = transportSendToWorkerUntil(t, slot, workerPid, status, 0)) == -1 && errno == EINTR) {
+    }
+    return rc;
+}
+
+/**
+ * Receive the reply of the worker occupying a slot
+ * @return 0 on success, -1 with errno EINTR if transportInterrupt was called
+ */
+int transportRecvFromWorker(Transport *t, int slot, pid_t ossPid, Message *msg) {
+    return transportRecvAnyFromWorkerUntil(t, &slot, 1, ossPid, msg, 0);
+}
+
+/**
+ * Receive the next reply from any of the given slots, in arrival order
+ * for the message queue and as soon as one is ready for shared memory
+ * @return 0 on success, -1 with errno EINTR if transportInterrupt was called
+ */
+int transportRecvAnyFromWorker(Transport *t, const int *slots, int count, pid_t ossPid, Message *msg) {
+    return transportRecvAnyFromWorkerUntil(t, slots, count, ossPid, msg, 0);
+}
+
+/**
+ * Like transportRecvAnyFromWorker, but give up at a deadline
+ * @param deadlineNs Monotonic wall time (monotonicNs) to give up at, 0 for never
+ * @return 0 on success, -1 with errno EINTR if transportInterrupt was called,
+ *         ETIMEDOUT if no reply came in time
+ */
+int transportRecvAnyFromWorkerUntil(Transport *t, const int *slots, int count, pid_t ossPid, Message *msg,
+                                    uint64_t deadlineNs) {
+    if (t->kind == TRANSPORT_SOCK) {
+        return remoteRecv(msg, 1, deadlineNs);
+    }
+    if (t->kind != TRANSPORT_SHM) {
+        return deadlineNs == 0 ? recvFromQueue(t, ossPid, msg, 0) : recvFromQueueUntil(t, ossPid, msg, deadlineNs);
+    }
+
+    MailboxSegment *seg = t->mailboxes;
+    Doorbell *doorbell = &seg->doorbells[t->shard];
+    int spins = 0;
+
+    for (;;) {
+        uint32_t bell = atomic_load(&doorbell->ring);
+
+        uint32_t interrupts = atomic_load(&seg->interrupts);
+        if (interrupts != t->seenInterrupts) {
+            t->seenInterrupts = interrupts;
+            errno = EINTR;
+            return -1;
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (ringTryPop(&seg->boxes[slots[i]].toOss, msg) == 0) {
+                return 0;
+            }
+        }
+
+        if (spins < RING_SPIN_LIMIT) {
+            spins++;
+            continue;
+        }
+
+        // Nothing ready: sleep until some worker rings the doorbell or the deadline
+        struct timespec timeout;
+        if (deadlineNs != 0) {
+            uint64_t now = monotonicNs();
+            if (now >= deadlineNs) {
+                errno = ETIMEDOUT;
+                return -1;
+            }
+            timeout.tv_sec = (deadlineNs - now) / NANO_PER_SEC;
+            timeout.tv_nsec = (deadlineNs - now) % NANO_PER_SEC;
+        }
+        atomic_store(&doorbell->sleeping, 1);
+        if (atomic_load(&doorbell->ring) == bell) {
+            if (deadlineNs != 0) {
+                futexWaitTimeout(&doorbell->ring, bell, &timeout);
+            } else {
+                futexWait(&doorbell->ring, bell);
+            }
+        }
+        atomic_store(&doorbell->sleeping, 0);
+    }
+}
+
+/**
+ * Take a reply that has already arrived from any of the given slots
+ * @return 0 on success, -1 with errno EAGAIN if none is ready
+ */
+int transportTryRecvAnyFromWorker(Transport *t, const int *slots, int count, pid_t ossPid, Message *msg) {
+    if (t->kind == TRANSPORT_SOCK) {
+        return remoteRecv(msg, 0, 0);
+    }
+    if (t->kind != TRANSPORT_SHM) {
+        // Stale interrupts carry no reply; skip past them
+        int rc;
+        while ((rc = recvFromQueue(t, ossPid, msg, IPC_NOWAIT)) == -1 && errno == EINTR) {
+        }
+        return rc;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (ringTryPop(&t->mailboxes->boxes[slots[i]].toOss, msg) == 0) {
+            return 0;
+        }
+    }
+    errno = EAGAIN;
+    return -1;
+}
+
+/**
+ * Make a blocked or about-to-block receive in oss return EINTR, on every
+ * dispatcher shard. Async-signal-safe: called from the SIGCHLD handler.
+ */
+int transportInterrupt(Transport *t, pid_t ossPid) {
+    int shards = t->shards > 1 ? t->shards : 1;
+
+    if (t->kind == TRANSPORT_SHM) {
+        MailboxSegment *seg = t->mailboxes;
+        atomic_fetch_add(&seg->interrupts, 1);
+        for (int shard = 0; shard < shards; shard++) {
+            atomic_fetch_add(&seg->doorbells[shard].ring, 1);
+            futexWake(&seg->doorbells[shard].ring);
+        }
+        return 0;
+    }
+    if (t->kind == TRANSPORT_SOCK) {
+        return remoteInterrupt();
+    }
+
+    int rc = 0;
+    for (int shard = 0; shard < shards; shard++) {
+        Message msg;
+        msg.mtype = replyType(ossPid, shard);
+        msg.pid = 0;
+        msg.status = MSG_STATUS_INTERRUPT;
+        msg.shard = shard;
+        msg.payloadOffset = 0;
+        msg.payloadLength = 0;
+        if (msgsnd(t->msgqid, &msg, MSG_SIZE, IPC_NOWAIT) == -1) {
+            rc = -1;
+        }
+    }
+    return rc;
+}
+
+/**
+ * Release what timed receives set up; safe to call twice
+ */
+void transportClose(Transport *t) {
+    if (t->timeoutTimerReady) {
+        timer_delete(t->timeoutTimer);
+        t->timeoutTimerReady = 0;
+    }
+}
+
+/**
+ * Drop messages still queued for a worker that is gone, so a later worker
+ * reusing its PID does not receive them
+ */
+void transportDiscard(Transport *t, pid_t workerPid) {
+    if (t->kind != TRANSPORT_MSG) {
+        return;     // Rings are reset when the entry is reused; agents drop stale quanta
+    }
+
+    Message msg;
+    while (msgrcv(t->msgqid, &msg, MSG_SIZE, workerPid, IPC_NOWAIT) != -1) {
+    }
+}
+
+/**
+ * Send a worker's reply back to oss
+ * @param shard Dispatcher shard that sent the quantum being answered
+ */
+int transportSendToOss(Transport *t, int slot, int shard, pid_t ossPid, pid_t workerPid, int status) {
+    return transportSendReportToOss(t, slot, shard, ossPid, workerPid, status, 0, 0);
+}
+
+/**
+ * Send a worker's reply back to oss with a payload it wrote to the arena;
+ * only the descriptor travels with the message
+ * @param payloadOffset Payload's offset in the arena (payloadReserve)
+ * @param payloadLength Its bytes, 0 for none
+ */
+int transportSendReportToOss(Transport *t, int slot, int shard, pid_t ossPid, pid_t workerPid, int status,
+                             uint32_t payloadOffset, uint32_t payloadLength) {
+    Message msg;
+    msg.mtype = replyType(ossPid, shard);
+    msg.pid = workerPid;
+    msg.status = status;
+    msg.shard = shard;
+    msg.payloadOffset = payloadOffset;
+    msg.payloadLength = payloadLength;
+
+    if (t->kind == TRANSPORT_SHM) {
+        MailboxSegment *seg = t->mailboxes;
+        if (ringPush(&seg->boxes[slot].toOss, &msg) == -1) {
+            return -1;
+        }
+
+        // Let the shard know a reply is ready in case it waits on several slots
+        Doorbell *doorbell = &seg->doorbells[shard];
+        atomic_fetch_add(&doorbell->ring, 1);
+        if (atomic_load(&doorbell->sleeping)) {
+            futexWake(&doorbell->ring);
+        }
+        return 0;
+    }
+    return msgsnd(t->msgqid, &msg, MSG_SIZE, 0);
+}
+
+/**
+ * Receive the next message oss sent to this worker
+ */
+int transportRecvFromOss(Transport *t, int slot, pid_t workerPid, Message *msg) {
+    if (t->kind == TRANSPORT_SHM) {
+        return ringPop(&t->mailboxes->boxes[slot].toWorker, msg);
+    }
+    return msgrcv(t->msgqid, msg, MSG_SIZE, workerPid, 0) == -1 ? -1 : 0;
+}
@@ -0,0 +1,91 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+#include "common.h"
+
+#define RING_CAPACITY 8      // Slots per ring (power of two)
+#define CACHE_LINE 64        // Padding unit to keep producer/consumer apart
+#define TRANSPORT_MAX_SHARDS 16     // Dispatcher shards with their own reply channel (oss -m)
+#define TRANSPORT_SHARD_TYPE_BASE (1L << 30)  // + shard: reply message type of shards 1.. (above any PID)
+
+// Single-producer/single-consumer message ring living in shared memory.
+// The consumer only sleeps on the futex after announcing itself in
+// 'sleeping', so the producer issues a wakeup syscall only when needed.
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic uint32_t head;     // next slot to write (producer)
+    _Atomic uint32_t sleeping;                      // consumer is parked on head
+    _Alignas(CACHE_LINE) _Atomic uint32_t tail;     // next slot to read (consumer)
+    _Alignas(CACHE_LINE) Message slots[RING_CAPACITY];
+} MessageRing;
+
+// Per-worker mailbox: one ring in each direction
+typedef struct {
+    MessageRing toWorker;   // oss -> worker
+    MessageRing toOss;      // worker -> oss
+} Mailbox;
+
+// Doorbell of one dispatcher shard; a worker rings the one of the shard
+// that sent its quantum
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic uint32_t ring;       // bumped on every reply to the shard
+    _Atomic uint32_t sleeping;                        // the shard is parked on ring
+} Doorbell;
+
+// Shared-memory mailbox segment. Workers ring a doorbell after every
+// reply so oss can wait for a reply from any of several workers at once.
+typedef struct {
+    Doorbell doorbells[TRANSPORT_MAX_SHARDS];         // indexed by shard
+    _Alignas(CACHE_LINE) _Atomic uint32_t interrupts; // bumped by transportInterrupt
+    _Alignas(CACHE_LINE) Mailbox boxes[];             // indexed by slot
+} MailboxSegment;
+
+#define MAILBOX_SEGMENT_SIZE(slots) (sizeof(MailboxSegment) + (size_t)(slots) * sizeof(Mailbox))
+
+// Selectable oss <-> worker transport
+typedef enum {
+    TRANSPORT_MSG,          // SysV message queue (default)
+    TRANSPORT_SHM,          // Shared-memory mailboxes with futex wakeups
+    TRANSPORT_SOCK          // TCP to worker agents (remote.c), which run the workers
+} TransportKind;
+
+typedef struct {
+    TransportKind kind;
+    int msgqid;             // Message queue ID (TRANSPORT_MSG)
+    MailboxSegment *mailboxes;  // Mailbox segment (TRANSPORT_SHM)
+    uint32_t seenInterrupts;    // Interrupts already reported to oss (TRANSPORT_SHM)
+    int shard;              // Dispatcher shard this copy sends and receives for
+    int shards;             // Shards taking replies (0 or 1: oss alone)
+    timer_t timeoutTimer;   // Interrupts a timed send or receive on the queue (TRANSPORT_MSG, oss -q)
+    int timeoutTimerReady;  // timeoutTimer exists; it signals the thread that created it
+} Transport;
+
+// Ring primitives
+void ringReset(MessageRing *ring);
+int ringPush(MessageRing *ring, const Message *msg);
+int ringPop(MessageRing *ring, Message *msg);
+int ringTryPop(MessageRing *ring, Message *msg);
+
+// Transport helpers; all return 0 on success or -1 with errno set
+int parseTransportKind(const char *name, TransportKind *kind);
+const char *transportName(TransportKind kind);
+int transportSendToWorker(Transport *t, int slot, pid_t workerPid, int status);
+int transportSendToWorkerUntil(Transport *t, int slot, pid_t workerPid, int status, uint64_t deadlineNs);
+int transportSendWindow(Transport *t);
+int transportRecvFromWorker(Transport *t, int slot, pid_t ossPid, Message *msg);
+int transportRecvAnyFromWorker(Transport *t, const int *slots, int count, pid_t ossPid, Message *msg);
+int transportRecvAnyFromWorkerUntil(Transport *t, const int *slots, int count, pid_t ossPid, Message *msg,
+                                    uint64_t deadlineNs);
+int transportTryRecvAnyFromWorker(Transport *t, const int *slots, int count, pid_t ossPid, Message *msg);
+int transportInterrupt(Transport *t, pid_t ossPid);
+void transportDiscard(Transport *t, pid_t workerPid);
+void transportClose(Transport *t);
+int transportSendToOss(Transport *t, int slot, int shard, pid_t ossPid, pid_t workerPid, int status);
+int transportSendReportToOss(Transport *t, int slot, int shard, pid_t ossPid, pid_t workerPid, int status,
+                             uint32_t payloadOffset, uint32_t payloadLength);
+int transportRecvFromOss(Transport *t, int slot, pid_t workerPid, Message *msg);
+
+#endif /* TRANSPORT_H */
@@ -0,0 +1,607 @@
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "common.h"
+#include "launcher.h"
+#include "reaper.h"
+#include "region.h"
+#include "remote.h"
+#include "transport.h"
+#include "workload.h"
+
+#define AGENT_CONNECT_RETRY_MS 200  // Between attempts to reach oss
+#define AGENT_POLL_MS 100           // Socket wait between checks for exits and signals
+#define AGENT_SHUTDOWN_GRACE_NS (2 * NANO_PER_SEC)  // SIGTERM to SIGKILL escalation
+
+// One process table entry of the oss this agent serves
+typedef struct {
+    _Atomic pid_t pid;      // Local PID of its worker, 0 if none
+    pid_t workerId;         // ID oss knows the worker by
+    uint64_t sentNs;        // Wall time its last quantum was handed over
+    pid_t finalPid;         // Last worker whose final reply went out (pump only)
+    pid_t livePid;          // Worker not yet collected (main thread only)
+} AgentSlot;
+
+// A worker that exited, handed from the main thread to the pump
+typedef struct {
+    int slot;
+    pid_t pid;              // Local PID, -1 if it could not be started
+    pid_t workerId;
+    int status;             // Wait status
+} ExitRecord;
+
+volatile sig_atomic_t stopRequested = 0;   // SIGINT or SIGTERM
+
+int sock = -1;              // Connection to oss
+Region region = { .fd = -1 };
+Transport transport = { TRANSPORT_SHM, -1, NULL };  // Agent <-> its workers
+Workload workload;
+AgentSlot *slots = NULL;
+int *allSlots = NULL;       // 0 .. slotCount - 1, for receives from any worker
+int slotCount = 0;
+
+// Exits queued by the main thread; the pump swaps the queue for its spare
+pthread_mutex_t exitLock = PTHREAD_MUTEX_INITIALIZER;
+ExitRecord *exitQueue = NULL;
+int exitQueueCount = 0;
+int exitQueueCapacity = 0;
+ExitRecord *exitSpare = NULL;
+int exitSpareCapacity = 0;
+
+// Pump thread: the only writer to the socket once the handshake is done
+pthread_t pump;
+int pumpRunning = 0;
+_Atomic int pumpStopping = 0;
+unsigned char pumpOut[REMOTE_BUFFER];
+size_t pumpOutLength = 0;
+
+void stopHandler(int sig);
+int connectToOss(const char *address);
+int runSession(LaunchMode mode);
+int startSession(LaunchMode mode, const char *spec, int output);
+void endSession(void);
+int serve(void);
+void launchWorker(const WireFrame *frame);
+void handQuantum(const WireFrame *frame);
+void onWorkerExit(pid_t pid, int status, const struct rusage *usage);
+void queueExit(int slot, pid_t pid, pid_t workerId, int status);
+void *pumpMain(void *arg);
+void stopWorkers(void);
+
+int main(int argc, char *argv[]) {
+    char address[256] = REMOTE_DEFAULT_ADDRESS;
+    LaunchMode mode = LAUNCH_EXEC;
+    int keepServing = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "hX:L:l")) != -1) {
+        switch (opt) {
+            case 'h':
+                printf("Usage: %s [-h] [-X address] [-L exec|pool|spawn] [-l]\n", argv[0]);
+                printf("Options:\n");
+                printf("  -h                   : Display this help message\n");
+                printf("  -X address           : host:port of the oss to serve (default: %s)\n", REMOTE_DEFAULT_ADDRESS);
+                printf("  -L launch            : exec (fork + exec), pool (pre-forked workers) or spawn (posix_spawn)\n");
+                printf("                         (default: exec)\n");
+                printf("  -l                   : Keep serving: reconnect for the next run when one ends\n");
+                exit(EXIT_SUCCESS);
+            case 'X':
+                strncpy(address, optarg, sizeof(address) - 1);
+                address[sizeof(address) - 1] = '\0';
+                break;
+            case 'L':
+                if (parseLaunchMode(optarg, &mode) == -1 || mode == LAUNCH_THREAD) {
+                    fprintf(stderr, "Invalid launch mode. Use exec, pool or spawn.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'l':
+                keepServing = 1;
+                break;
+            default:
+                fprintf(stderr, "Invalid option. Use -h for help.\n");
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    // Interrupt poll and the connect retries rather than restarting them
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stopHandler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    int rc = 0;
+    do {
+        sock = connectToOss(address);
+        if (sock == -1) {
+            if (!stopRequested) {
+                perror("worker-agent: connect");
+                rc = -1;
+            }
+            break;
+        }
+        rc = runSession(mode);
+        close(sock);
+        sock = -1;
+    } while (keepServing && !stopRequested);
+
+    return rc == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * SIGINT/SIGTERM: stop the workers and exit once the main loop notices
+ */
+void stopHandler(int sig) {
+    (void)sig;
+    stopRequested = 1;
+}
+
+/**
+ * Connect to oss, retrying until it listens or a stop is requested
+ * @return Connected socket, or -1 with errno set
+ */
+int connectToOss(const char *address) {
+    struct sockaddr_storage addr;
+    socklen_t length;
+    if (wireParseAddress(address, 0, &addr, &length) == -1) {
+        return -1;
+    }
+
+    while (!stopRequested) {
+        int fd = socket(addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd == -1) {
+            return -1;
+        }
+        if (connect(fd, (struct sockaddr *)&addr, length) == 0) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+        int error = errno;
+        close(fd);
+        if (error != ECONNREFUSED && error != ETIMEDOUT && error != ENETUNREACH && error != EINTR) {
+            errno = error;
+            return -1;
+        }
+        usleep(AGENT_CONNECT_RETRY_MS * 1000);
+    }
+    errno = EINTR;
+    return -1;
+}
+
+/**
+ * Serve one oss run: take its configuration, set up a control region and
+ * mailboxes of its size, run the workers it launches and tear everything
+ * down when it is over
+ * @return 0 on success, -1 on failure
+ */
+int runSession(LaunchMode mode) {
+    unsigned char buf[WIRE_FRAME_SIZE];
+    WireFrame hello = { WIRE_HELLO, 0, REMOTE_PROTOCOL_VERSION, 0, 0 };
+    WireFrame config;
+    char spec[256] = "";
+
+    wireEncode(&hello, buf);
+    if (wireWriteAll(sock, buf, sizeof(buf)) == -1 || wireReadAll(sock, buf, sizeof(buf)) == -1) {
+        if (errno == ECONNRESET || errno == EPIPE) {
+            return 0;       // oss stopped before it took this agent
+        }
+        perror("worker-agent: handshake");
+        return -1;
+    }
+    wireDecode(buf, &config);
+    if (config.type != WIRE_CONFIG || config.clockNs == 0 || config.clockNs > INT32_MAX ||
+        config.arg >= sizeof(spec) || wireReadAll(sock, spec, config.arg) == -1) {
+        fprintf(stderr, "worker-agent: invalid configuration from oss\n");
+        return -1;
+    }
+    spec[config.arg] = '\0';
+    slotCount = (int)config.clockNs;
+
+    if (spec[0] != '\0' && parseWorkload(spec, &workload) == -1) {
+        fprintf(stderr, "worker-agent: invalid workload from oss: %s\n", spec);
+        return -1;
+    }
+
+    int rc = startSession(mode, spec, (int)config.value) == 0 ? serve() : -1;
+    endSession();
+    return rc;
+}
+
+/**
+ * Set up a session: entry tables, a control region of oss's size, the
+ * launcher and the pump thread
+ * @param spec -w workload from oss, "" for none
+ * @param output WorkerOutput from oss
+ * @return 0 on success, -1 on failure (endSession releases what was set up)
+ */
+int startSession(LaunchMode mode, const char *spec, int output) {
+    slots = calloc(slotCount, sizeof(AgentSlot));
+    allSlots = malloc(slotCount * sizeof(int));
+    exitQueueCapacity = exitSpareCapacity = 2 * slotCount;
+    exitQueue = malloc(exitQueueCapacity * sizeof(ExitRecord));
+    exitSpare = malloc(exitSpareCapacity * sizeof(ExitRecord));
+    if (slots == NULL || allSlots == NULL || exitQueue == NULL || exitSpare == NULL) {
+        perror("malloc");
+        return -1;
+    }
+    for (int i = 0; i < slotCount; i++) {
+        allSlots[i] = i;
+    }
+    exitQueueCount = 0;
+
+    if (regionCreate(&region, slotCount, 0) == -1) {
+        perror("worker-agent: control region");
+        return -1;
+    }
+    region.header->workerOutput = output;
+    clockSet(region.clock, 0);
+    transport.mailboxes = region.mailboxes;
+    transport.seenInterrupts = atomic_load(&region.mailboxes->interrupts);
+
+    if (reaperInit(NULL) == -1) {
+        perror("reaperInit");
+        return -1;
+    }
+    if (launcherInit(mode, &transport, &region, slotCount) == -1) {
+        return -1;
+    }
+    if (spec[0] != '\0') {
+        launcherSetWorkload(spec, &workload);
+    }
+    for (int i = 0; i < slotCount; i++) {
+        if (launcherPrepare(i) == -1) {
+            perror("launcherPrepare");
+        }
+    }
+
+    // The pump leaves signals to this thread
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &previous);
+    atomic_store(&pumpStopping, 0);
+    pumpOutLength = 0;
+    int rc = pthread_create(&pump, NULL, pumpMain, NULL);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if (rc != 0) {
+        errno = rc;
+        perror("pthread_create");
+        return -1;
+    }
+    pumpRunning = 1;
+
+    printf("worker-agent: serving %d entries for oss (workload: %s)\n", slotCount, spec[0] != '\0' ? spec : "none");
+    fflush(stdout);
+    return 0;
+}
+
+/**
+ * Stop the pump and the workers and release the session; safe after a
+ * partial startSession
+ */
+void endSession(void) {
+    if (pumpRunning) {
+        atomic_store(&pumpStopping, 1);
+        transportInterrupt(&transport, 0);
+        pthread_join(pump, NULL);
+        pumpRunning = 0;
+    }
+    stopWorkers();
+    reaperClose();
+    launcherCleanup();
+    if (region.header != NULL) {
+        regionDestroy(&region);
+        transport.mailboxes = NULL;
+    }
+    free(slots);
+    free(allSlots);
+    free(exitQueue);
+    free(exitSpare);
+    slots = NULL;
+    allSlots = NULL;
+    exitQueue = exitSpare = NULL;
+}
+
+/**
+ * Act on oss's frames until it shuts the run down or goes away, collecting
+ * worker exits in between
+ * @return 0 on success, -1 on failure
+ */
+int serve(void) {
+    static unsigned char in[REMOTE_BUFFER];
+    size_t inLength = 0;
+
+    for (;;) {
+        if (reaperPending()) {
+            reaperPoll(0, onWorkerExit);
+        }
+        if (stopRequested) {
+            return 0;
+        }
+
+        struct pollfd p = { sock, POLLIN, 0 };
+        int rc = poll(&p, 1, AGENT_POLL_MS);
+        if (rc == -1 && errno != EINTR) {
+            perror("worker-agent: poll");
+            return -1;
+        }
+        if (rc <= 0) {
+            continue;
+        }
+
+        ssize_t n = recv(sock, in + inLength, sizeof(in) - inLength, 0);
+        if (n == 0 || (n == -1 && errno == ECONNRESET)) {
+            fprintf(stderr, "worker-agent: oss closed the connection\n");
+            return 0;
+        }
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("worker-agent: receive");
+            return -1;
+        }
+        inLength += (size_t)n;
+
+        size_t used = 0;
+        while (inLength - used >= WIRE_FRAME_SIZE) {
+            WireFrame frame;
+            wireDecode(in + used, &frame);
+            used += WIRE_FRAME_SIZE;
+
+            if (frame.type == WIRE_SHUTDOWN) {
+                return 0;
+            }
+            if (frame.slot >= slotCount) {
+                fprintf(stderr, "worker-agent: ignoring frame for entry %d\n", frame.slot);
+                continue;
+            }
+            if (frame.type == WIRE_LAUNCH) {
+                launchWorker(&frame);
+            } else if (frame.type == WIRE_QUANTUM) {
+                handQuantum(&frame);
+            } else {
+                fprintf(stderr, "worker-agent: ignoring frame of type %d\n", frame.type);
+            }
+        }
+
+        // Keep the partial frame at the front
+        memmove(in, in + used, inLength - used);
+        inLength -= used;
+    }
+}
+
+/**
+ * Start a worker on an entry at oss's clock, with the lifetime oss chose
+ */
+void launchWorker(const WireFrame *frame) {
+    AgentSlot *s = &slots[frame->slot];
+
+    // Quanta oss sent before it learned the previous worker had died
+    Message stale;
+    while (ringTryPop(&region.mailboxes->boxes[frame->slot].toWorker, &stale) == 0) {
+    }
+
+    clockSet(region.clock, frame->clockNs);
+    s->workerId = frame->value;
+    pid_t pid = launcherStart(frame->slot, (int)(frame->arg / NANO_PER_SEC), (int)(frame->arg % NANO_PER_SEC));
+    if (pid == -1) {
+        perror("worker-agent: launch worker");
+        queueExit(frame->slot, -1, frame->value, W_EXITCODE(EXIT_FAILURE, 0));
+        return;
+    }
+    s->livePid = pid;
+    atomic_store(&s->pid, pid);
+}
+
+/**
+ * Hand a quantum from oss to the worker of an entry at oss's clock
+ */
+void handQuantum(const WireFrame *frame) {
+    AgentSlot *s = &slots[frame->slot];
+    pid_t pid = atomic_load(&s->pid);
+
+    clockSet(region.clock, frame->clockNs);
+    if (s->workerId != frame->value || pid <= 0) {
+        return;     // For a worker that is gone; its exit is on the way to oss
+    }
+    s->sentNs = monotonicNs();
+    if (transportSendToWorker(&transport, frame->slot, pid, 1) == -1) {
+        perror("worker-agent: send to worker");
+    }
+}
+
+/**
+ * Reaper callback: hand the exit of an entry's worker to the pump, which
+ * reports it to oss unless the worker's final reply already went out. With
+ * -L pool a fresh worker is parked on the entry if it is still free.
+ */
+void onWorkerExit(pid_t pid, int status, const struct rusage *usage) {
+    (void)usage;
+    if (launcherForget(pid)) {
+        return;
+    }
+    for (int i = 0; i < slotCount; i++) {
+        if (slots[i].livePid == pid) {
+            slots[i].livePid = 0;
+            queueExit(i, pid, slots[i].workerId, status);
+            if (launcherPrepare(i) == -1) {
+                perror("launcherPrepare");
+            }
+            return;
+        }
+    }
+}
+
+/**
+ * Queue an exit for the pump and break it out of its receive
+ */
+void queueExit(int slot, pid_t pid, pid_t workerId, int status) {
+    pthread_mutex_lock(&exitLock);
+    if (exitQueueCount == exitQueueCapacity) {
+        ExitRecord *grown = realloc(exitQueue, 2 * exitQueueCapacity * sizeof(ExitRecord));
+        if (grown == NULL) {
+            pthread_mutex_unlock(&exitLock);
+            perror("worker-agent: exit queue");
+            return;
+        }
+        exitQueue = grown;
+        exitQueueCapacity *= 2;
+    }
+    exitQueue[exitQueueCount++] = (ExitRecord){ slot, pid, workerId, status };
+    pthread_mutex_unlock(&exitLock);
+    transportInterrupt(&transport, 0);
+}
+
+/**
+ * Send the frames the pump has queued in one write; if oss is gone they are
+ * dropped and the main thread notices the closed connection
+ */
+static void pumpFlush(void) {
+    if (pumpOutLength > 0) {
+        wireWriteAll(sock, pumpOut, pumpOutLength);
+        pumpOutLength = 0;
+    }
+}
+
+/**
+ * Queue a frame to oss
+ */
+static void pumpQueue(const WireFrame *frame) {
+    if (pumpOutLength + WIRE_FRAME_SIZE > REMOTE_BUFFER) {
+        pumpFlush();
+    }
+    wireEncode(frame, pumpOut + pumpOutLength);
+    pumpOutLength += WIRE_FRAME_SIZE;
+}
+
+/**
+ * Queue a worker's reply to oss under its worker ID, with the wall time the
+ * agent held the quantum
+ */
+static void forwardReply(int slot, pid_t workerId, const Message *msg) {
+    AgentSlot *s = &slots[slot];
+    uint64_t now = monotonicNs();
+    WireFrame frame = { WIRE_REPLY, (uint16_t)slot, workerId, now > s->sentNs ? now - s->sentNs : 0,
+                        (uint64_t)(uint32_t)msg->status };
+    if (msg->status == 0) {
+        s->finalPid = msg->pid;
+    }
+    pumpQueue(&frame);
+}
+
+/**
+ * Forward a reply taken from any worker, matched to its entry by PID
+ */
+static void forwardAny(const Message *msg) {
+    for (int i = 0; i < slotCount; i++) {
+        if (atomic_load(&slots[i].pid) == msg->pid) {
+            forwardReply(i, slots[i].workerId, msg);
+            return;
+        }
+    }
+    fprintf(stderr, "worker-agent: ignoring reply from unknown PID %d\n", msg->pid);
+}
+
+/**
+ * Report the exits the main thread queued: first forward whatever the
+ * worker sent before it died, then tell oss unless that was its final reply
+ */
+static void pumpExits(void) {
+    pthread_mutex_lock(&exitLock);
+    ExitRecord *records = exitQueue;
+    int count = exitQueueCount;
+    int capacity = exitQueueCapacity;
+    exitQueue = exitSpare;
+    exitQueueCapacity = exitSpareCapacity;
+    exitQueueCount = 0;
+    pthread_mutex_unlock(&exitLock);
+
+    for (int k = 0; k < count; k++) {
+        ExitRecord *r = &records[k];
+        Message msg;
+        while (ringTryPop(&region.mailboxes->boxes[r->slot].toOss, &msg) == 0) {
+            if (msg.pid == r->pid) {
+                forwardReply(r->slot, r->workerId, &msg);
+            } else {
+                forwardAny(&msg);
+            }
+        }
+        if (r->pid == -1 || slots[r->slot].finalPid != r->pid) {
+            WireFrame frame = { WIRE_EXIT, (uint16_t)r->slot, r->workerId, 0, (uint64_t)(uint32_t)r->status };
+            pumpQueue(&frame);
+        }
+        pid_t expected = r->pid;
+        atomic_compare_exchange_strong(&slots[r->slot].pid, &expected, 0);
+    }
+
+    exitSpare = records;
+    exitSpareCapacity = capacity;
+}
+
+/**
+ * Pump thread: take the workers' replies as they arrive and send them to
+ * oss in batches, one write per wakeup
+ */
+void *pumpMain(void *arg) {
+    (void)arg;
+    Message msg;
+
+    for (;;) {
+        if (transportRecvAnyFromWorker(&transport, allSlots, slotCount, 0, &msg) == 0) {
+            forwardAny(&msg);
+            while (transportTryRecvAnyFromWorker(&transport, allSlots, slotCount, 0, &msg) == 0) {
+                forwardAny(&msg);
+            }
+        } else {
+            pumpExits();
+            if (atomic_load(&pumpStopping)) {
+                break;
+            }
+        }
+        pumpFlush();
+    }
+    return NULL;
+}
+
+/**
+ * Stop every worker: SIGTERM, then SIGKILL for those still there after the
+ * grace period
+ */
+void stopWorkers(void) {
+    for (int i = 0; slots != NULL && i < slotCount; i++) {
+        if (slots[i].livePid > 0) {
+            kill(slots[i].livePid, SIGTERM);
+        }
+    }
+    launcherSignalSpares(SIGTERM);
+
+    uint64_t deadline = monotonicNs() + AGENT_SHUTDOWN_GRACE_NS;
+    uint64_t now;
+    while (reaperLiveChildren() > 0 && (now = monotonicNs()) < deadline) {
+        reaperPoll((int)((deadline - now) / NANO_PER_MS) + 1, NULL);
+    }
+
+    if (reaperLiveChildren() > 0) {
+        for (int i = 0; slots != NULL && i < slotCount; i++) {
+            if (slots[i].livePid > 0) {
+                kill(slots[i].livePid, SIGKILL);
+            }
+        }
+        launcherSignalSpares(SIGKILL);
+        reaperWaitAll(NULL);
+    }
+}
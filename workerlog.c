@@ -0,0 +1,63 @@
+#include <string.h>
+#include "workerlog.h"
+
+/**
+ * Parse a worker output mode given on the command line
+ * @return 0 on success, -1 if the name is unknown
+ */
+int parseWorkerOutput(const char *name, WorkerOutput *output) {
+    if (strcmp(name, "stdout") == 0) {
+        *output = WORKER_OUTPUT_STDOUT;
+    } else if (strcmp(name, "ring") == 0) {
+        *output = WORKER_OUTPUT_RING;
+    } else if (strcmp(name, "off") == 0) {
+        *output = WORKER_OUTPUT_OFF;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Name of a worker output mode for logs and statistics
+ */
+const char *workerOutputName(WorkerOutput output) {
+    switch (output) {
+        case WORKER_OUTPUT_RING:
+            return "ring";
+        case WORKER_OUTPUT_OFF:
+            return "off";
+        default:
+            return "stdout";
+    }
+}
+
+/**
+ * Append a record (worker side); counts a drop instead of waiting if the
+ * ring is full
+ */
+void workerLogPut(WorkerLogRing *ring, const WorkerLogRecord *record) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail >= WORKER_LOG_CAPACITY) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+    ring->records[head % WORKER_LOG_CAPACITY] = *record;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+/**
+ * Take the oldest record (oss side) without blocking
+ * @return 0 on success, -1 if the ring is empty
+ */
+int workerLogTake(WorkerLogRing *ring, WorkerLogRecord *record) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (atomic_load_explicit(&ring->head, memory_order_acquire) == tail) {
+        return -1;
+    }
+    *record = ring->records[tail % WORKER_LOG_CAPACITY];
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return 0;
+}
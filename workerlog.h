@@ -0,0 +1,51 @@
+#ifndef WORKERLOG_H
+#define WORKERLOG_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "transport.h"
+
+#define WORKER_LOG_CAPACITY 16      // Records per ring (power of two)
+
+// Where workers report their status lines (-o)
+typedef enum {
+    WORKER_OUTPUT_STDOUT,           // printf to the shared stdout (default)
+    WORKER_OUTPUT_RING,             // Records in the worker's log ring, merged by oss
+    WORKER_OUTPUT_OFF               // Not at all
+} WorkerOutput;
+
+// What a record reports
+typedef enum {
+    WORKER_LOG_START,               // Read the clock at startup ("Just Starting")
+    WORKER_LOG_ITERATION,           // Finished a quantum and will continue
+    WORKER_LOG_TERMINATE            // Finished its last quantum
+} WorkerLogType;
+
+// One status record; oss formats it like the worker's printf lines
+typedef struct {
+    uint32_t type;                  // WorkerLogType
+    pid_t pid;
+    pid_t parentPid;
+    uint32_t iterations;
+    uint64_t clockNs;               // Clock the worker read
+    uint64_t terminationNs;         // Its termination time
+} WorkerLogRecord;
+
+// Single-producer/single-consumer log ring of one process table entry. The
+// entry's worker appends without ever blocking (a full ring drops the record);
+// oss takes records when the worker replies, so successive occupants of the
+// entry share the ring one after another.
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic uint32_t head;     // next record to write (worker)
+    _Atomic uint32_t dropped;                       // records lost to a full ring
+    _Alignas(CACHE_LINE) _Atomic uint32_t tail;     // next record to read (oss)
+    _Alignas(CACHE_LINE) WorkerLogRecord records[WORKER_LOG_CAPACITY];
+} WorkerLogRing;
+
+int parseWorkerOutput(const char *name, WorkerOutput *output);
+const char *workerOutputName(WorkerOutput output);
+void workerLogPut(WorkerLogRing *ring, const WorkerLogRecord *record);
+int workerLogTake(WorkerLogRing *ring, WorkerLogRecord *record);
+
+#endif /* WORKERLOG_H */
@@ -0,0 +1,157 @@
+#include <errno.h>
+#include <stdio.h>
+#include "workerloop.h"
+
+/**
+ * Report the worker's status: print it, or append it to the entry's log
+ * ring for oss to merge into its log (-o ring)
+ * @param type WorkerLogType
+ */
+static void report(const WorkerContext *ctx, int type, int iterations, uint64_t now, uint64_t terminationTime) {
+    if (ctx->output == WORKER_OUTPUT_RING) {
+        WorkerLogRecord record = { type, ctx->pid, ctx->parentPid, iterations, now, terminationTime };
+        workerLogPut(ctx->log, &record);
+        return;
+    }
+    if (ctx->output == WORKER_OUTPUT_OFF) {
+        return;
+    }
+
+    printf("WORKER PID:%d PPID:%d SysClockS: %llu SysclockNano: %u TermTimeS: %llu TermTimeNano: %u\n",
+           ctx->pid, ctx->parentPid, CLOCK_SECONDS(now), CLOCK_NANOS(now),
+           CLOCK_SECONDS(terminationTime), CLOCK_NANOS(terminationTime));
+    if (type == WORKER_LOG_START) {
+        printf("--Just Starting\n");
+    } else if (type == WORKER_LOG_TERMINATE) {
+        printf("--Terminating after sending message back to oss after %d iterations.\n", iterations);
+    } else {
+        printf("--%d iteration%s have passed since starting\n",
+               iterations, (iterations == 1) ? "" : "s");
+    }
+}
+
+/**
+ * Write the quantum's report to the entry's payload slab: the work done,
+ * one wall time sample per kernel and any error
+ * @param work The worker's workload, NULL if it runs none
+ * @param error errno of a failure so far, 0 if none
+ * @param length Set to the report's bytes, 0 if the slab had no room
+ * @return The report's offset in the arena
+ */
+static uint32_t writeReport(const WorkerContext *ctx, const WorkloadState *work, int error, int iterations,
+                            uint64_t now, uint32_t *length) {
+    uint32_t kernels = 0, samples = 0;
+    for (int k = 0; work != NULL && k < KERNEL_COUNT; k++) {
+        if (work->workload->amount[k] != 0) {
+            kernels |= 1u << k;
+            samples++;
+        }
+    }
+
+    uint32_t offset = 0;
+    uint32_t bytes = sizeof(WorkerReport) + samples * sizeof(uint64_t);
+    WorkerReport *r = payloadReserve(ctx->payload, bytes, &offset);
+    *length = r != NULL ? bytes : 0;
+    if (r == NULL) {
+        return 0;
+    }
+
+    r->iterations = iterations;
+    r->error = error;
+    r->clockNs = now;
+    r->workNs = 0;
+    r->kernels = kernels;
+    r->sampleCount = samples;
+    uint32_t n = 0;
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        if (kernels & (1u << k)) {
+            r->samples[n++] = work->kernelNs[k];
+            r->workNs += work->kernelNs[k];
+        }
+    }
+    return offset;
+}
+
+/**
+ * Run a worker until the simulated clock passes its termination time:
+ * wait for a message from oss, run the workload, check the clock, report
+ * and reply
+ * @return Number of iterations completed
+ */
+int workerRun(const WorkerContext *ctx) {
+    pid_t myPid = ctx->pid;
+    pid_t parentPid = ctx->parentPid;
+
+    // Buffers for the per-quantum workload (oss -w)
+    WorkloadState work;
+    int working = ctx->workload != NULL && workloadActive(ctx->workload);
+    int workError = 0;
+    if (working && workloadInit(&work, ctx->workload, ctx->slot + 1) == -1) {
+        workError = errno;
+        perror("workload");
+        working = 0;
+    }
+    if (working) {
+        work.timed = ctx->payload != NULL;
+    }
+
+    // Calculate absolute termination time
+    uint64_t now = clockRead(ctx->clock);
+    uint64_t terminationTime = now + ctx->lifetimeNs;
+
+    // Output initial status
+    report(ctx, WORKER_LOG_START, 0, now, terminationTime);
+
+    // Main loop
+    int iterations = 0;
+    int shouldTerminate = 0;
+
+    do {
+        // Wait for message from oss
+        Message msg;
+        if (transportRecvFromOss(ctx->transport, ctx->slot, myPid, &msg) == -1) {
+            if (errno == EINTR) {
+                // Interrupted by signal, try again
+                continue;
+            }
+            perror("msgrcv");
+            break;
+        }
+
+        // The quantum's work
+        if (working) {
+            workloadRun(&work);
+        }
+
+        // Check if we should terminate based on a single clock snapshot
+        now = clockRead(ctx->clock);
+        if (now >= terminationTime) {
+            shouldTerminate = 1;
+        }
+
+        // Increment iterations
+        iterations++;
+
+        // Report status before replying, so oss finds it when the reply arrives
+        report(ctx, shouldTerminate ? WORKER_LOG_TERMINATE : WORKER_LOG_ITERATION, iterations, now, terminationTime);
+
+        // Send message back to oss, with the quantum's report if it wants one
+        int status = shouldTerminate ? 0 : 1;  // 0 = terminate, 1 = continue
+        uint32_t payloadOffset = 0, payloadLength = 0;
+        if (ctx->payload != NULL) {
+            payloadOffset = writeReport(ctx, working ? &work : NULL, workError, iterations, now, &payloadLength);
+        }
+
+        if (transportSendReportToOss(ctx->transport, ctx->slot, msg.shard, parentPid, myPid, status,
+                                     payloadOffset, payloadLength) == -1) {
+            perror("msgsnd");
+            break;
+        }
+
+    } while (!shouldTerminate);
+
+    if (working) {
+        workloadFree(&work);
+    }
+    return iterations;
+}
@@ -0,0 +1,29 @@
+#ifndef WORKERLOOP_H
+#define WORKERLOOP_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "common.h"
+#include "payload.h"
+#include "transport.h"
+#include "workerlog.h"
+#include "workload.h"
+
+// Everything one worker needs to run its receive / check-clock / reply loop,
+// whether it is a separate process (worker.c) or a thread inside oss
+typedef struct {
+    Transport *transport;   // Channel to oss
+    int slot;               // Process table entry (mailbox index)
+    const SystemClock *clock;
+    pid_t pid;              // Identity reported to oss
+    pid_t parentPid;        // oss PID (reply message type)
+    uint64_t lifetimeNs;    // Time to run, relative to the first clock read
+    const Workload *workload;  // Kernels run in every quantum, NULL for none
+    WorkerOutput output;    // Where status lines go (-o)
+    WorkerLogRing *log;     // The entry's log ring (WORKER_OUTPUT_RING)
+    PayloadSlab *payload;   // The entry's payload slab, NULL if the worker does not report (-W)
+} WorkerContext;
+
+int workerRun(const WorkerContext *ctx);
+
+#endif /* WORKERLOOP_H */
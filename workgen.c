@@ -0,0 +1,391 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "common.h"
+#include "workgen.h"
+
+/**
+ * Split "name[:parameter]" and parse the parameter
+ * @param param Set to the parameter, left alone if there is none
+ * @return Length of the name, or -1 if the parameter is not a number
+ */
+static int splitParam(const char *text, double *param) {
+    const char *colon = strchr(text, ':');
+    if (colon == NULL) {
+        return (int)strlen(text);
+    }
+    char *end;
+    double value = strtod(colon + 1, &end);
+    if (end == colon + 1 || *end != '\0') {
+        return -1;
+    }
+    *param = value;
+    return (int)(colon - text);
+}
+
+/**
+ * Parse an arrival process: fixed, poisson or bursty[:meanBurstSize]
+ * @return 0 on success, -1 if unknown
+ */
+int parseArrivalProcess(const char *text, WorkgenConfig *config) {
+    double burstSize = WORKGEN_BURST_SIZE;
+    int len = splitParam(text, &burstSize);
+    if (len == 5 && strncmp(text, "fixed", 5) == 0 && text[len] == '\0') {
+        config->arrival = ARRIVAL_FIXED;
+    } else if (len == 7 && strncmp(text, "poisson", 7) == 0 && text[len] == '\0') {
+        config->arrival = ARRIVAL_POISSON;
+    } else if (len == 6 && strncmp(text, "bursty", 6) == 0 && burstSize >= 1.0) {
+        config->arrival = ARRIVAL_BURSTY;
+        config->burstSize = burstSize;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Parse a lifetime distribution: uniform, exp, pareto[:alpha] (alpha > 1)
+ * or lognormal[:sigma]
+ * @return 0 on success, -1 if unknown
+ */
+int parseLifetimeDistribution(const char *text, WorkgenConfig *config) {
+    double shape = -1.0;
+    int len = splitParam(text, &shape);
+    if (len == 7 && strncmp(text, "uniform", 7) == 0 && text[len] == '\0') {
+        config->lifetime = LIFETIME_UNIFORM;
+    } else if (len == 3 && strncmp(text, "exp", 3) == 0 && text[len] == '\0') {
+        config->lifetime = LIFETIME_EXPONENTIAL;
+    } else if (len == 6 && strncmp(text, "pareto", 6) == 0) {
+        config->lifetime = LIFETIME_PARETO;
+        config->shape = shape < 0.0 ? WORKGEN_PARETO_ALPHA : shape;
+        if (config->shape <= 1.0) {
+            return -1;
+        }
+    } else if (len == 9 && strncmp(text, "lognormal", 9) == 0) {
+        config->lifetime = LIFETIME_LOGNORMAL;
+        config->shape = shape < 0.0 ? WORKGEN_LOGNORMAL_SIGMA : shape;
+        if (config->shape <= 0.0) {
+            return -1;
+        }
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Describe the arrival process and lifetime distribution for logs and
+ * statistics, e.g. "poisson (mean gap 100 ms), pareto lifetimes (alpha 1.5)"
+ */
+void workgenDescribe(const WorkgenConfig *config, const char *tracePath, char *out, size_t size) {
+    double gapMs = (double)config->intervalNs / NANO_PER_MS;
+    int used;
+    switch (config->arrival) {
+        case ARRIVAL_POISSON:
+            used = snprintf(out, size, "poisson (mean gap %g ms)", gapMs);
+            break;
+        case ARRIVAL_BURSTY:
+            used = snprintf(out, size, "bursty (%g per burst, mean gap %g ms)", config->burstSize, gapMs);
+            break;
+        case ARRIVAL_TRACE:
+            snprintf(out, size, "trace %s", tracePath);
+            return;
+        default:
+            used = snprintf(out, size, "fixed (every %g ms)", gapMs);
+            break;
+    }
+    if (used < 0 || (size_t)used >= size) {
+        return;
+    }
+    switch (config->lifetime) {
+        case LIFETIME_EXPONENTIAL:
+            snprintf(out + used, size - used, ", exp lifetimes");
+            break;
+        case LIFETIME_PARETO:
+            snprintf(out + used, size - used, ", pareto lifetimes (alpha %g)", config->shape);
+            break;
+        case LIFETIME_LOGNORMAL:
+            snprintf(out + used, size - used, ", lognormal lifetimes (sigma %g)", config->shape);
+            break;
+        default:
+            snprintf(out + used, size - used, ", uniform lifetimes");
+            break;
+    }
+}
+
+/**
+ * Exponential variate with the given mean
+ */
+static double drawExponential(Rng *rng, double mean) {
+    return -mean * log1p(-rngDouble(rng));
+}
+
+/**
+ * Draw a lifetime. Every distribution has the mean of the uniform one,
+ * 1 s + t/2, so switching distributions changes only the shape; heavy
+ * tails are cut at WORKGEN_LIFETIME_CAP times t.
+ */
+static uint64_t drawLifetime(Workgen *gen) {
+    const WorkgenConfig *c = &gen->config;
+    Rng *rng = &gen->state.rng;
+    double mean = (double)NANO_PER_SEC + (double)c->maxLifetimeNs / 2;
+    double ns;
+
+    switch (c->lifetime) {
+        case LIFETIME_EXPONENTIAL:
+            ns = drawExponential(rng, mean);
+            break;
+        case LIFETIME_PARETO: {
+            double scale = mean * (c->shape - 1.0) / c->shape;
+            ns = scale / pow(1.0 - rngDouble(rng), 1.0 / c->shape);
+            break;
+        }
+        case LIFETIME_LOGNORMAL: {
+            // Box-Muller; the second normal of the pair is not needed
+            double mu = log(mean) - c->shape * c->shape / 2;
+            double z = sqrt(-2.0 * log1p(-rngDouble(rng))) * cos(2.0 * M_PI * rngDouble(rng));
+            ns = exp(mu + c->shape * z);
+            break;
+        }
+        default:
+            return NANO_PER_SEC + rngBelow(rng, c->maxLifetimeNs);
+    }
+
+    double cap = (double)c->maxLifetimeNs * WORKGEN_LIFETIME_CAP;
+    if (ns > cap) {
+        ns = cap;
+    }
+    return ns < WORKGEN_MIN_LIFETIME_NS ? WORKGEN_MIN_LIFETIME_NS : (uint64_t)ns;
+}
+
+/**
+ * Draw the gap before the next synthetic arrival
+ */
+static uint64_t drawGap(Workgen *gen) {
+    const WorkgenConfig *c = &gen->config;
+    WorkgenState *s = &gen->state;
+
+    switch (c->arrival) {
+        case ARRIVAL_POISSON:
+            return (uint64_t)drawExponential(&s->rng, (double)c->intervalNs);
+        case ARRIVAL_BURSTY:
+            // Within a burst workers launch back to back; bursts arrive
+            // Poisson with a mean gap that keeps the mean rate at one per -i
+            if (s->burstLeft > 0) {
+                s->burstLeft--;
+                return 0;
+            }
+            // The floor of an exponential is geometric; this one has mean burstSize - 1
+            s->burstLeft = c->burstSize > 1.0 ?
+                (int32_t)floor(drawExponential(&s->rng, 1.0 / log1p(1.0 / (c->burstSize - 1.0)))) : 0;
+            return (uint64_t)drawExponential(&s->rng, c->burstSize * (double)c->intervalNs);
+        default:
+            return c->intervalNs;
+    }
+}
+
+/**
+ * Next line of the trace, refilling the buffer as needed
+ * @param line Set to the line, NUL-terminated in place
+ * @return 1 if a line was read, 0 at end of file, -1 with errno set (EINVAL
+ *         if a line does not fit in the buffer)
+ */
+static int traceNextLine(Workgen *gen, char **line) {
+    TraceReader *r = &gen->trace;
+    for (;;) {
+        char *newline = memchr(r->buffer + r->start, '\n', r->end - r->start);
+        if (newline != NULL || (r->eof && r->end > r->start)) {
+            size_t length = newline != NULL ? (size_t)(newline - (r->buffer + r->start)) : r->end - r->start;
+            *line = r->buffer + r->start;
+            (*line)[length] = '\0';
+            r->start += newline != NULL ? length + 1 : length;
+            gen->state.traceOffset += newline != NULL ? length + 1 : length;
+            gen->state.traceLine++;
+            return 1;
+        }
+        if (r->eof) {
+            return 0;
+        }
+
+        // Keep the partial line and read behind it; the buffer has one spare
+        // byte so a final line without a newline can still be terminated
+        memmove(r->buffer, r->buffer + r->start, r->end - r->start);
+        r->end -= r->start;
+        r->start = 0;
+        if (r->end == sizeof(r->buffer) - 1) {
+            errno = EINVAL;
+            return -1;
+        }
+        ssize_t n = read(r->fd, r->buffer + r->end, sizeof(r->buffer) - 1 - r->end);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            r->eof = 1;
+        }
+        r->end += n;
+    }
+}
+
+/**
+ * Read the next "arrival,lifetime" record (seconds, fractions allowed; more
+ * columns are ignored). Blank lines, # comments and a header line are skipped.
+ * @return 0 on success, -1 with errno set (EINVAL for a malformed line)
+ */
+static int traceNextRecord(Workgen *gen) {
+    WorkgenState *s = &gen->state;
+    char *line;
+    int rc;
+
+    while ((rc = traceNextLine(gen, &line)) == 1) {
+        while (*line == ' ' || *line == '\t') {
+            line++;
+        }
+        if (*line == '\0' || *line == '\r' || *line == '#') {
+            continue;
+        }
+
+        char *end;
+        double arrival = strtod(line, &end);
+        int valid = end != line && *end == ',';
+        double lifetime = valid ? strtod(end + 1, &end) : 0.0;
+        valid = valid && (*end == '\0' || *end == ',' || *end == '\r' || *end == ' ');
+        if (!valid || arrival < 0.0 || lifetime < 0.0) {
+            if (s->traceLine == 1) {
+                continue;       // Column names
+            }
+            errno = EINVAL;
+            return -1;
+        }
+
+        // Arrivals are relative to the first record and never go backwards
+        uint64_t arrivalNs = (uint64_t)(arrival * NANO_PER_SEC);
+        if (s->traceBaseNs == UINT64_MAX) {
+            s->traceBaseNs = arrivalNs;
+        }
+        uint64_t relativeNs = arrivalNs > s->traceBaseNs ? arrivalNs - s->traceBaseNs : 0;
+        s->nextNs = relativeNs > s->tracePrevNs ? relativeNs : s->tracePrevNs;
+        s->tracePrevNs = s->nextNs;
+        s->lifetimeNs = (uint64_t)(lifetime * NANO_PER_SEC);
+        if (s->lifetimeNs < WORKGEN_MIN_LIFETIME_NS) {
+            s->lifetimeNs = WORKGEN_MIN_LIFETIME_NS;
+        }
+        s->pending = 1;
+        return 0;
+    }
+    s->pending = 0;
+    return rc;
+}
+
+/**
+ * Consume the pending arrival and generate the next one
+ * @return 0 on success (the trace may have ended: see state.pending), -1
+ *         with errno set if the trace cannot be read; no arrivals follow
+ */
+int workgenAdvance(Workgen *gen) {
+    WorkgenState *s = &gen->state;
+    if (gen->config.arrival == ARRIVAL_TRACE) {
+        s->pending = 0;
+        return traceNextRecord(gen);
+    }
+    s->nextNs = drawGap(gen);
+    s->lifetimeNs = drawLifetime(gen);
+    s->pending = 1;
+    return 0;
+}
+
+/**
+ * Open the trace, if any, at the given byte offset
+ * @return 0 on success, -1 with errno set
+ */
+static int traceOpen(Workgen *gen, const char *tracePath, uint64_t offset) {
+    TraceReader *r = &gen->trace;
+    r->fd = -1;
+    r->start = r->end = 0;
+    r->eof = 0;
+    if (gen->config.arrival != ARRIVAL_TRACE) {
+        return 0;
+    }
+
+    r->fd = open(tracePath, O_RDONLY | O_CLOEXEC);
+    if (r->fd == -1) {
+        return -1;
+    }
+    posix_fadvise(r->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (offset > 0 && lseek(r->fd, (off_t)offset, SEEK_SET) == -1) {
+        workgenClose(gen);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Start a generator and draw its first arrival
+ * @param tracePath CSV trace when config->arrival is ARRIVAL_TRACE
+ * @param seed Seed of the run (-S)
+ * @return 0 on success, -1 with errno set (EINVAL if the trace is malformed
+ *         or empty)
+ */
+int workgenInit(Workgen *gen, const WorkgenConfig *config, const char *tracePath, uint64_t seed) {
+    gen->config = *config;
+    memset(&gen->state, 0, sizeof(gen->state));
+    rngSeed(&gen->state.rng, seed);
+    if (traceOpen(gen, tracePath, 0) == -1) {
+        return -1;
+    }
+    gen->state.traceBaseNs = UINT64_MAX;
+    if (workgenAdvance(gen) == -1) {
+        int saved = errno;
+        workgenClose(gen);
+        errno = saved;
+        return -1;
+    }
+    if (!gen->state.pending) {
+        workgenClose(gen);
+        errno = EINVAL;         // The trace holds no records
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Continue a checkpointed generator: the trace is reopened where it stopped
+ * @return 0 on success, -1 with errno set
+ */
+int workgenRestore(Workgen *gen, const WorkgenConfig *config, const char *tracePath, const WorkgenState *state) {
+    gen->config = *config;
+    gen->state = *state;
+    return traceOpen(gen, tracePath, state->traceOffset);
+}
+
+/**
+ * Earliest simulated time of the next launch: the drawn gap after the
+ * previous launch, or the trace's arrival time
+ * @return UINT64_MAX once the trace has ended
+ */
+uint64_t workgenNextLaunch(const Workgen *gen, uint64_t lastLaunchNs) {
+    if (!gen->state.pending) {
+        return UINT64_MAX;
+    }
+    if (gen->config.arrival == ARRIVAL_TRACE) {
+        return gen->state.nextNs;
+    }
+    return lastLaunchNs + gen->state.nextNs;
+}
+
+/**
+ * Close the trace
+ */
+void workgenClose(Workgen *gen) {
+    if (gen->trace.fd != -1) {
+        close(gen->trace.fd);
+        gen->trace.fd = -1;
+    }
+}
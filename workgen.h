@@ -0,0 +1,80 @@
+#ifndef WORKGEN_H
+#define WORKGEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "rng.h"
+
+#define WORKGEN_BURST_SIZE 8.0      // Default mean launches per burst (-A bursty)
+#define WORKGEN_PARETO_ALPHA 1.5    // Default Pareto shape (-l pareto)
+#define WORKGEN_LOGNORMAL_SIGMA 1.5 // Default log-normal sigma (-l lognormal)
+#define WORKGEN_LIFETIME_CAP 100    // Heavy-tailed lifetimes are cut at this many times -t
+#define WORKGEN_MIN_LIFETIME_NS 1000000ull  // Shortest lifetime handed to a worker (1 ms)
+#define WORKGEN_TRACE_BUFFER (1 << 16)      // Bytes of an arrival trace read at a time
+
+// When workers arrive (-A, -g)
+typedef enum {
+    ARRIVAL_FIXED,          // One launch every -i ms (default)
+    ARRIVAL_POISSON,        // Exponential gaps with mean -i ms
+    ARRIVAL_BURSTY,         // Poisson bursts of geometrically many back-to-back launches
+    ARRIVAL_TRACE           // Arrival times and lifetimes read from a CSV trace
+} ArrivalProcess;
+
+// How long they live (-l)
+typedef enum {
+    LIFETIME_UNIFORM,       // 1 s plus uniform in [0, -t s) (default)
+    LIFETIME_EXPONENTIAL,   // Exponential
+    LIFETIME_PARETO,        // Pareto with shape alpha
+    LIFETIME_LOGNORMAL      // Log-normal with shape sigma
+} LifetimeDistribution;
+
+// Generator settings; a checkpoint stores them so a resumed run keeps them
+typedef struct {
+    int32_t arrival;        // ArrivalProcess
+    int32_t lifetime;       // LifetimeDistribution
+    double burstSize;       // Mean launches per burst
+    double shape;           // Pareto alpha or log-normal sigma
+    uint64_t intervalNs;    // Mean gap between launches (-i)
+    uint64_t maxLifetimeNs; // -t; uniform lifetimes stay below 1 s + -t
+} WorkgenConfig;
+
+// Generator state, also checkpointed
+typedef struct {
+    Rng rng;
+    uint64_t nextNs;        // Next arrival: gap after the previous launch, or
+                            // simulated time relative to the first trace record
+    uint64_t lifetimeNs;    // Its lifetime
+    int32_t pending;        // nextNs/lifetimeNs hold an arrival (0 at end of trace)
+    int32_t burstLeft;      // Launches left in the current burst
+    uint64_t traceOffset;   // Bytes of the trace consumed
+    uint64_t traceLine;     // Lines of the trace consumed
+    uint64_t traceBaseNs;   // Arrival time of the first trace record
+    uint64_t tracePrevNs;   // Latest trace arrival so far
+} WorkgenState;
+
+// Streaming reader for a CSV arrival trace; holds one buffer of it at a time
+typedef struct {
+    int fd;
+    size_t start;           // Unparsed bytes are buffer[start, end)
+    size_t end;
+    int eof;
+    char buffer[WORKGEN_TRACE_BUFFER];
+} TraceReader;
+
+typedef struct {
+    WorkgenConfig config;
+    WorkgenState state;
+    TraceReader trace;
+} Workgen;
+
+int parseArrivalProcess(const char *text, WorkgenConfig *config);
+int parseLifetimeDistribution(const char *text, WorkgenConfig *config);
+void workgenDescribe(const WorkgenConfig *config, const char *tracePath, char *out, size_t size);
+
+int workgenInit(Workgen *gen, const WorkgenConfig *config, const char *tracePath, uint64_t seed);
+int workgenRestore(Workgen *gen, const WorkgenConfig *config, const char *tracePath, const WorkgenState *state);
+uint64_t workgenNextLaunch(const Workgen *gen, uint64_t lastLaunchNs);
+int workgenAdvance(Workgen *gen);
+void workgenClose(Workgen *gen);
+
+#endif /* WORKGEN_H */
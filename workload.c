@@ -0,0 +1,267 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "rng.h"
+#include "transport.h"
+#include "workload.h"
+
+#define COMPUTE_VECTOR 1024         // floats in the compute array (4 KB, stays in L1)
+#define CHASE_NODE_WORDS (CACHE_LINE / sizeof(uint32_t))  // One chase node per cache line
+
+static const char *kernelNames[KERNEL_COUNT] = { "compute", "stream", "chase", "sleep" };
+
+/**
+ * Parse a workload such as compute:1M,stream:8M,chase:4M,sleep:100. Amounts
+ * take an optional K, M or G (binary) suffix; "none" clears the workload.
+ * @return 0 on success, -1 with errno EINVAL if the spec is malformed
+ */
+int parseWorkload(const char *spec, Workload *workload) {
+    memset(workload, 0, sizeof(*workload));
+    if (strcmp(spec, "none") == 0) {
+        return 0;
+    }
+
+    const char *p = spec;
+    while (*p != '\0') {
+        int kernel = -1;
+        for (int k = 0; k < KERNEL_COUNT; k++) {
+            size_t len = strlen(kernelNames[k]);
+            if (strncmp(p, kernelNames[k], len) == 0 && p[len] == ':') {
+                kernel = k;
+                p += len + 1;
+                break;
+            }
+        }
+        if (kernel == -1) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        char *end;
+        unsigned long long amount = strtoull(p, &end, 10);
+        if (end == p) {
+            errno = EINVAL;
+            return -1;
+        }
+        switch (*end) {
+            case 'K': case 'k': amount <<= 10; end++; break;
+            case 'M': case 'm': amount <<= 20; end++; break;
+            case 'G': case 'g': amount <<= 30; end++; break;
+            default: break;
+        }
+        if (*end != ',' && *end != '\0') {
+            errno = EINVAL;
+            return -1;
+        }
+        workload->amount[kernel] = amount;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return 0;
+}
+
+/**
+ * Name of a kernel as -w spells it
+ */
+const char *workloadKernelName(int kernel) {
+    return kernel >= 0 && kernel < KERNEL_COUNT ? kernelNames[kernel] : "unknown";
+}
+
+/**
+ * Whether any kernel runs
+ */
+int workloadActive(const Workload *workload) {
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        if (workload->amount[k] != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Describe a workload for logs and statistics, e.g. "compute 1048576, stream
+ * 8388608 B" or "none"
+ */
+void workloadDescribe(const Workload *workload, char *out, size_t size) {
+    static const char *units[KERNEL_COUNT] = { " multiply-adds", " B", " B", " us" };
+    size_t used = 0;
+    out[0] = '\0';
+    for (int k = 0; k < KERNEL_COUNT && used < size; k++) {
+        if (workload->amount[k] != 0) {
+            used += snprintf(out + used, size - used, "%s%s %llu%s", used > 0 ? ", " : "", kernelNames[k],
+                             (unsigned long long)workload->amount[k], units[k]);
+        }
+    }
+    if (used == 0) {
+        snprintf(out, size, "none");
+    }
+}
+
+/**
+ * Allocate a cache-line-aligned buffer and touch its pages, so the first
+ * quantum does not pay for the page faults
+ */
+static void *allocTouched(size_t bytes) {
+    bytes = (bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    void *buffer = aligned_alloc(CACHE_LINE, bytes);
+    if (buffer != NULL) {
+        memset(buffer, 0, bytes);
+    }
+    return buffer;
+}
+
+/**
+ * Allocate one worker's buffers. The chase cycle visits every node once in
+ * random order (Sattolo's algorithm), so the prefetcher cannot follow it.
+ * @param seed Seed of the chase order
+ * @return 0 on success, -1 on allocation failure
+ */
+int workloadInit(WorkloadState *state, const Workload *workload, unsigned int seed) {
+    memset(state, 0, sizeof(*state));
+    state->workload = workload;
+
+    if (workload->amount[KERNEL_COMPUTE] != 0) {
+        state->vector = allocTouched(COMPUTE_VECTOR * sizeof(float));
+        if (state->vector == NULL) {
+            return -1;
+        }
+        for (int i = 0; i < COMPUTE_VECTOR; i++) {
+            state->vector[i] = (float)i;
+        }
+    }
+
+    if (workload->amount[KERNEL_STREAM] != 0) {
+        state->streamLength = workload->amount[KERNEL_STREAM] / (3 * sizeof(double));
+        state->streamLength = state->streamLength > 0 ? state->streamLength : 1;
+        state->streamA = allocTouched(state->streamLength * sizeof(double));
+        state->streamB = allocTouched(state->streamLength * sizeof(double));
+        state->streamC = allocTouched(state->streamLength * sizeof(double));
+        if (state->streamA == NULL || state->streamB == NULL || state->streamC == NULL) {
+            workloadFree(state);
+            return -1;
+        }
+    }
+
+    if (workload->amount[KERNEL_CHASE] != 0) {
+        size_t nodes = workload->amount[KERNEL_CHASE] / CACHE_LINE;
+        nodes = nodes > 1 ? nodes : 2;
+        uint32_t *order = malloc(nodes * sizeof(uint32_t));
+        state->chain = allocTouched(nodes * CACHE_LINE);
+        if (order == NULL || state->chain == NULL) {
+            free(order);
+            workloadFree(state);
+            return -1;
+        }
+        Rng rng;
+        rngSeed(&rng, seed);
+        for (size_t i = 0; i < nodes; i++) {
+            order[i] = i;
+        }
+        for (size_t i = nodes - 1; i > 0; i--) {
+            size_t j = rngBelow(&rng, i);
+            uint32_t t = order[i];
+            order[i] = order[j];
+            order[j] = t;
+        }
+        for (size_t i = 0; i < nodes; i++) {
+            state->chain[order[i] * CHASE_NODE_WORDS] = order[(i + 1) % nodes];
+        }
+        free(order);
+        state->chainLength = nodes;
+    }
+    return 0;
+}
+
+/**
+ * Multiply-adds over a small array; the inner loop has no dependences
+ * between elements, so the compiler vectorizes it
+ */
+static void computeKernel(WorkloadState *state, uint64_t operations) {
+    float *restrict v = state->vector;
+    uint64_t passes = (operations + COMPUTE_VECTOR - 1) / COMPUTE_VECTOR;
+    for (uint64_t p = 0; p < passes; p++) {
+        for (int i = 0; i < COMPUTE_VECTOR; i++) {
+            v[i] = v[i] * 0.999f + 0.001f;
+        }
+    }
+    state->sink += v[COMPUTE_VECTOR - 1];
+}
+
+/**
+ * One triad pass over the stream arrays
+ */
+static void streamKernel(WorkloadState *state) {
+    double *restrict a = state->streamA;
+    const double *restrict b = state->streamB;
+    const double *restrict c = state->streamC;
+    for (size_t i = 0; i < state->streamLength; i++) {
+        a[i] = b[i] + 3.0 * c[i];
+    }
+    state->sink += a[state->streamLength - 1];
+}
+
+/**
+ * One lap of the chase cycle; every load depends on the previous one
+ */
+static void chaseKernel(WorkloadState *state) {
+    uint32_t node = state->chasePosition;
+    for (size_t i = 0; i < state->chainLength; i++) {
+        node = state->chain[node * CHASE_NODE_WORDS];
+    }
+    state->chasePosition = node;
+}
+
+/**
+ * Run one kernel, timing it if asked to
+ */
+static void runKernel(WorkloadState *state, int kernel) {
+    const Workload *w = state->workload;
+    uint64_t start = state->timed ? monotonicNs() : 0;
+
+    switch (kernel) {
+        case KERNEL_COMPUTE:
+            computeKernel(state, w->amount[KERNEL_COMPUTE]);
+            break;
+        case KERNEL_STREAM:
+            streamKernel(state);
+            break;
+        case KERNEL_CHASE:
+            chaseKernel(state);
+            break;
+        default: {
+            struct timespec ts = { w->amount[KERNEL_SLEEP] / 1000000, (w->amount[KERNEL_SLEEP] % 1000000) * 1000 };
+            while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {
+            }
+            break;
+        }
+    }
+
+    if (state->timed) {
+        state->kernelNs[kernel] = monotonicNs() - start;
+    }
+}
+
+/**
+ * Run every configured kernel once: the work of one quantum
+ */
+void workloadRun(WorkloadState *state) {
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        if (state->workload->amount[k] != 0) {
+            runKernel(state, k);
+        }
+    }
+}
+
+/**
+ * Release one worker's buffers
+ */
+void workloadFree(WorkloadState *state) {
+    free(state->vector);
+    free(state->streamA);
+    free(state->streamB);
+    free(state->streamC);
+    free(state->chain);
+    memset(state, 0, sizeof(*state));
+}
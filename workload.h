@@ -0,0 +1,47 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Kernels a worker can run during each quantum
+typedef enum {
+    KERNEL_COMPUTE,         // Vectorizable multiply-add loop over an L1-resident array
+    KERNEL_STREAM,          // Triad over three arrays: memory bandwidth
+    KERNEL_CHASE,           // Dependent loads around a random cycle: cache and TLB misses
+    KERNEL_SLEEP,           // nanosleep, standing in for I/O
+    KERNEL_COUNT
+} WorkloadKernel;
+
+// What every worker runs per quantum (oss -w), 0 = kernel not used.
+// compute: multiply-adds; stream, chase: working set in bytes; sleep: microseconds
+typedef struct {
+    uint64_t amount[KERNEL_COUNT];
+} Workload;
+
+// One worker's buffers
+typedef struct {
+    const Workload *workload;
+    float *vector;          // compute
+    double *streamA;        // stream: a = b + s * c
+    double *streamB;
+    double *streamC;
+    size_t streamLength;
+    uint32_t *chain;        // chase: next node of each node, one node per cache line
+    size_t chainLength;
+    uint32_t chasePosition;
+    double sink;            // Keeps results live
+    int timed;              // Time each kernel (worker reports, oss -W)
+    uint64_t kernelNs[KERNEL_COUNT];  // Wall time of each kernel in the last run, if timed
+} WorkloadState;
+
+int parseWorkload(const char *spec, Workload *workload);
+int workloadActive(const Workload *workload);
+void workloadDescribe(const Workload *workload, char *out, size_t size);
+const char *workloadKernelName(int kernel);
+
+int workloadInit(WorkloadState *state, const Workload *workload, unsigned int seed);
+void workloadRun(WorkloadState *state);
+void workloadFree(WorkloadState *state);
+
+#endif /* WORKLOAD_H */